@@ -45,6 +45,6 @@ public:
 	int damageDiff() const;
 	int attackValue() const;
 
-	static AttackPossibility evaluate(const BattleAttackInfo &AttackInfo, const HypotheticChangesToBattleState &state, BattleHex hex);
+	static AttackPossibility evaluate(const CBattleCallback * cb, const BattleAttackInfo &AttackInfo, const HypotheticChangesToBattleState &state, BattleHex hex);
 	static Priorities * priorities;
 };
@@ -33,7 +33,6 @@ CBattleAI::~CBattleAI(void)
 
 void CBattleAI::init(std::shared_ptr<CBattleCallback> CB)
 {
-	setCbc(CB);
 	cb = CB;
 	playerID = *CB->getPlayerID(); //TODO should be sth in callback
 	wasWaitingForRealize = cb->waitTillRealize;
@@ -45,7 +44,6 @@ void CBattleAI::init(std::shared_ptr<CBattleCallback> CB)
 BattleAction CBattleAI::activeStack( const CStack * stack )
 {
 	LOG_TRACE_PARAMS(logAi, "stack: %s", stack->nodeName())	;
-	setCbc(cb); //TODO: make solid sure that AIs always use their callbacks (need to take care of event handlers too)
 	try
 	{
 		if(stack->type->idNumber == CreatureID::CATAPULT)
@@ -65,7 +63,7 @@ BattleAction CBattleAI::activeStack( const CStack * stack )
 
 		attemptCastingSpell();
 
-		if(auto ret = getCbc()->battleIsFinished())
+		if(auto ret = cb->battleIsFinished())
 		{
 			//spellcast may finish battle
 			//send special preudo-action
@@ -76,7 +74,7 @@ BattleAction CBattleAI::activeStack( const CStack * stack )
 
 		if(auto action = considerFleeingOrSurrendering())
 			return *action;
-		PotentialTargets targets(stack);
+		PotentialTargets targets(cb.get(), stack);
 		if(targets.possibleAttacks.size())
 		{
 			auto hlp = targets.bestAction();
@@ -90,7 +88,7 @@ BattleAction CBattleAI::activeStack( const CStack * stack )
 			if(stack->waited())
 			{
 				//ThreatMap threatsToUs(stack); // These lines may be usefull but they are't used in the code.
-				auto dists = getCbc()->battleGetDistances(stack);
+				auto dists = cb->battleGetDistances(stack);
 				const EnemyInfo &ei= *range::min_element(targets.unreachableEnemies, std::bind(isCloser, _1, _2, std::ref(dists)));
 				if(distToNearestNeighbour(ei.s->position, dists) < GameConstants::BFIELD_SIZE)
 				{
@@ -198,7 +196,7 @@ void CBattleAI::attemptCastingSpell()
 	std::vector<const CSpell*> possibleSpells;
 	vstd::copy_if(VLC->spellh->objects, std::back_inserter(possibleSpells), [this, hero] (const CSpell *s) -> bool
 	{
-		return s->canBeCast(getCbc().get(), ECastingMode::HERO_CASTING, hero) == ESpellCastProblem::OK;
+		return s->canBeCast(cb.get(), ECastingMode::HERO_CASTING, hero) == ESpellCastProblem::OK;
 	});
 	LOGFL("I can cast %d spells.", possibleSpells.size());
 
@@ -223,7 +221,7 @@ void CBattleAI::attemptCastingSpell()
 	std::map<const CStack*, int> valueOfStack;
 	for(auto stack : cb->battleGetStacks())
 	{
-		PotentialTargets pt(stack);
+		PotentialTargets pt(cb.get(), stack);
 		valueOfStack[stack] = pt.bestActionValue();
 	}
 
@@ -268,7 +266,7 @@ void CBattleAI::attemptCastingSpell()
 				ps.spell->getEffects(swb.bonusesToAdd, skillLevel, true, hero->getEnchantPower(ps.spell));
 				HypotheticChangesToBattleState state;
 				state.bonusesOfStacks[swb.stack] = &swb;
-				PotentialTargets pt(swb.stack, state);
+				PotentialTargets pt(cb.get(), swb.stack, state);
 				auto newValue = pt.bestActionValue();
 				auto oldValue = valueOfStack[swb.stack];
 				auto gain = newValue - oldValue;
@@ -319,7 +317,7 @@ std::vector<BattleHex> CBattleAI::getTargetsToConsider(const CSpell * spell, con
 		{
 		case CSpell::CREATURE:
 		{
-			for(const CStack * stack : getCbc()->battleAliveStacks())
+			for(const CStack * stack : cb->battleAliveStacks())
 			{
 				bool immune = ESpellCastProblem::OK != spell->isImmuneByStack(caster, stack);
 				bool casterStack = stack->owner == caster->getOwner();
@@ -11,11 +11,10 @@
 #include "EnemyInfo.h"
 #include "../../lib/CRandomGenerator.h"
 #include "../../CCallback.h"
-#include "common.h"
 
-void EnemyInfo::calcDmg(const CStack * ourStack)
+void EnemyInfo::calcDmg(const CBattleCallback * cb, const CStack * ourStack)
 {
-	TDmgRange retal, dmg = getCbc()->battleEstimateDamage(CRandomGenerator::getDefault(), ourStack, s, &retal);
+	TDmgRange retal, dmg = cb->battleEstimateDamage(CRandomGenerator::getDefault(), ourStack, s, &retal);
 	adi = (dmg.first + dmg.second) / 2;
 	adr = (retal.first + retal.second) / 2;
 }
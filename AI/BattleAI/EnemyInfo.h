@@ -12,6 +12,7 @@
 #include "../../lib/battle/BattleHex.h"
 
 class CStack;
+class CBattleCallback;
 
 class EnemyInfo
 {
@@ -21,7 +22,7 @@ public:
 	std::vector<BattleHex> attackFrom; //for melee fight
 	EnemyInfo(const CStack * _s) : s(_s)
 	{}
-	void calcDmg(const CStack * ourStack);
+	void calcDmg(const CBattleCallback * cb, const CStack * ourStack);
 	bool operator==(const EnemyInfo& ei) const
 	{
 		return s == ei.s;
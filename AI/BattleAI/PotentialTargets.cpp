@@ -10,12 +10,12 @@
 #include "StdInc.h"
 #include "PotentialTargets.h"
 
-PotentialTargets::PotentialTargets(const CStack * attacker, const HypotheticChangesToBattleState & state)
+PotentialTargets::PotentialTargets(const CBattleCallback * cb, const CStack * attacker, const HypotheticChangesToBattleState & state)
 {
-	auto dists = getCbc()->battleGetDistances(attacker);
-	auto avHexes = getCbc()->battleGetAvailableHexes(attacker, false);
+	auto dists = cb->battleGetDistances(attacker);
+	auto avHexes = cb->battleGetAvailableHexes(attacker, false);
 
-	for(const CStack *enemy : getCbc()->battleGetStacks())
+	for(const CStack *enemy : cb->battleGetStacks())
 	{
 		//Consider only stacks of different owner
 		if(enemy->side == attacker->side)
@@ -33,10 +33,10 @@ PotentialTargets::PotentialTargets(const CStack * attacker, const HypotheticChan
 				bai.chargedFields = dists[hex];
 			}
 
-			return AttackPossibility::evaluate(bai, state, hex);
+			return AttackPossibility::evaluate(cb, bai, state, hex);
 		};
 
-		if(getCbc()->battleCanShoot(attacker, enemy->position))
+		if(cb->battleCanShoot(attacker, enemy->position))
 		{
 			possibleAttacks.push_back(GenerateAttackInfo(true, BattleHex::INVALID));
 		}
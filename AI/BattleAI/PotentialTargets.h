@@ -19,7 +19,7 @@ public:
 	//std::function<AttackPossibility(bool,BattleHex)>  GenerateAttackInfo; //args: shooting, destHex
 
 	PotentialTargets(){};
-	PotentialTargets(const CStack *attacker, const HypotheticChangesToBattleState &state = HypotheticChangesToBattleState());
+	PotentialTargets(const CBattleCallback * cb, const CStack *attacker, const HypotheticChangesToBattleState &state = HypotheticChangesToBattleState());
 
 	AttackPossibility bestAction() const;
 	int bestActionValue() const;
@@ -9,8 +9,6 @@
  */
 #pragma once
 
-class CBattleCallback;
-
 template<typename Key, typename Val, typename Val2>
 const Val getValOr(const std::map<Key, Val> &Map, const Key &key, const Val2 defaultValue)
 {
@@ -22,5 +20,3 @@ const Val getValOr(const std::map<Key, Val> &Map, const Key &key, const Val2 def
 		return defaultValue;
 }
 
-void setCbc(std::shared_ptr<CBattleCallback> cb);
-std::shared_ptr<CBattleCallback> getCbc();
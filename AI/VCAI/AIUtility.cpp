@@ -207,7 +207,7 @@ ui64 evaluateDanger(crint3 tile)
 	return std::max(objectDanger, guardDanger);
 }
 
-ui64 evaluateDanger(crint3 tile, const CGHeroInstance *visitor)
+static ui64 evaluateTileDanger(crint3 tile, const CGHeroInstance *visitor)
 {
 	const TerrainTile *t = cb->getTile(tile, false);
 	if(!t) //we can know about guard but can't check its tile (the edge of fow)
@@ -262,6 +262,272 @@ ui64 evaluateDanger(crint3 tile, const CGHeroInstance *visitor)
 	return std::max(objectDanger, guardDanger);
 }
 
+ui64 evaluateDanger(crint3 tile, const CGHeroInstance *visitor)
+{
+	return ai->dangerHeatmap.get(tile, visitor);
+}
+
+const ui64 DangerHeatmap::NOT_EVALUATED;
+
+ui64 DangerHeatmap::get(crint3 tile, const CGHeroInstance *visitor)
+{
+	if(!cb->isInTheMap(tile))
+		return evaluateTileDanger(tile, visitor);
+
+	boost::unique_lock<boost::mutex> lock(mx);
+
+	const int3 mapSize = cb->getMapSize();
+	if(mapSize != sizes)
+	{
+		dangers.clear();
+		sizes = mapSize;
+	}
+
+	const ui64 heroStrength = visitor ? visitor->getTotalStrength() : 0;
+	HeroDangers & heroDangers = dangers[visitor];
+	if(heroDangers.tiles.empty() || heroDangers.heroStrength != heroStrength)
+	{
+		heroDangers.heroStrength = heroStrength;
+		heroDangers.tiles.assign(sizes.x * sizes.y * sizes.z, NOT_EVALUATED);
+	}
+
+	ui64 & danger = heroDangers.tiles[(tile.z * sizes.y + tile.y) * sizes.x + tile.x];
+	if(danger == NOT_EVALUATED)
+		danger = evaluateTileDanger(tile, visitor);
+	return danger;
+}
+
+void DangerHeatmap::invalidateTile(crint3 tile)
+{
+	if(tile.x < 0 || tile.y < 0 || tile.x >= sizes.x || tile.y >= sizes.y || tile.z < 0 || tile.z >= sizes.z)
+		return;
+
+	for(auto & heroDangers : dangers)
+	{
+		if(!heroDangers.second.tiles.empty())
+			heroDangers.second.tiles[(tile.z * sizes.y + tile.y) * sizes.x + tile.x] = NOT_EVALUATED;
+	}
+}
+
+void DangerHeatmap::invalidate(crint3 tile)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+
+	//monsters guard all neighbouring tiles
+	for(int dx = -1; dx <= 1; dx++)
+		for(int dy = -1; dy <= 1; dy++)
+			invalidateTile(tile + int3(dx, dy, 0));
+
+	//danger of subterranean gate includes guards on the other side
+	for(auto & gate : ai->knownSubterraneanGates)
+	{
+		const int3 exit = gate.second->visitablePos();
+		if(exit.z == tile.z && std::abs(exit.x - tile.x) <= 1 && std::abs(exit.y - tile.y) <= 1)
+			invalidateTile(gate.first->visitablePos());
+	}
+}
+
+void DangerHeatmap::clear()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	dangers.clear();
+}
+
+TimeBudget::TimeBudget(si64 limit):
+	start(boost::posix_time::microsec_clock::universal_time()), limit(limit)
+{
+}
+
+si64 TimeBudget::elapsed() const
+{
+	return (boost::posix_time::microsec_clock::universal_time() - start).total_milliseconds();
+}
+
+bool TimeBudget::exhausted() const
+{
+	return limit >= 0 && elapsed() >= limit;
+}
+
+ExplorationMap::ExplorationMap()
+{
+	sumsValid = false;
+}
+
+void ExplorationMap::init()
+{
+	sizes = cb->getMapSize();
+	hidden.assign(sizes.x * sizes.y * sizes.z, 0);
+	frontier.clear();
+	sumsValid = false;
+
+	auto &fow = cb->getVisibilityMap();
+	for(int z = 0; z < sizes.z; z++)
+		for(int y = 0; y < sizes.y; y++)
+			for(int x = 0; x < sizes.x; x++)
+				hidden[(z * sizes.y + y) * sizes.x + x] = !fow[x][y][z];
+
+	for(int z = 0; z < sizes.z; z++)
+		for(int y = 0; y < sizes.y; y++)
+			for(int x = 0; x < sizes.x; x++)
+				updateFrontier(int3(x, y, z));
+}
+
+bool ExplorationMap::isHidden(crint3 tile) const
+{
+	return hidden[(tile.z * sizes.y + tile.y) * sizes.x + tile.x];
+}
+
+void ExplorationMap::updateFrontier(crint3 tile)
+{
+	if(tile.x < 0 || tile.y < 0 || tile.x >= sizes.x || tile.y >= sizes.y)
+		return;
+
+	bool nearFog = false;
+	if(!isHidden(tile))
+	{
+		for(const int3 &dir : int3::getDirs())
+		{
+			const int3 n = tile + dir;
+			if(n.x >= 0 && n.y >= 0 && n.x < sizes.x && n.y < sizes.y && isHidden(n))
+			{
+				nearFog = true;
+				break;
+			}
+		}
+	}
+
+	if(nearFog)
+		frontier.insert(tile);
+	else
+		frontier.erase(tile);
+}
+
+int ExplorationMap::hiddenInRect(int x1, int y1, int x2, int y2, int z) const
+{
+	vstd::amax(x1, 0);
+	vstd::amax(y1, 0);
+	vstd::amin(x2, sizes.x - 1);
+	vstd::amin(y2, sizes.y - 1);
+	if(x1 > x2 || y1 > y2)
+		return 0;
+
+	const int width = sizes.x + 1;
+	const int * sums = &hiddenSums[z * width * (sizes.y + 1)];
+	return sums[(y2 + 1) * width + x2 + 1] - sums[y1 * width + x2 + 1] - sums[(y2 + 1) * width + x1] + sums[y1 * width + x1];
+}
+
+int ExplorationMap::hiddenTilesAround(crint3 pos, int radius)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(hidden.empty() || sizes != cb->getMapSize())
+		init();
+
+	if(!sumsValid)
+	{
+		const int width = sizes.x + 1, height = sizes.y + 1;
+		hiddenSums.assign(width * height * sizes.z, 0);
+		for(int z = 0; z < sizes.z; z++)
+		{
+			int * sums = &hiddenSums[z * width * height];
+			for(int y = 0; y < sizes.y; y++)
+			{
+				int row = 0;
+				for(int x = 0; x < sizes.x; x++)
+				{
+					row += isHidden(int3(x, y, z));
+					sums[(y + 1) * width + x + 1] = sums[y * width + x + 1] + row;
+				}
+			}
+		}
+		sumsValid = true;
+	}
+
+	//same circle as in howManyTilesWillBeDiscovered, counted as one rectangle per row
+	int ret = 0;
+	for(int dy = -radius; dy <= radius; dy++)
+	{
+		int dx = radius;
+		while(dx >= 0 && std::sqrt(dx * dx + dy * dy) - 0.5 >= radius)
+			dx--;
+		if(dx >= 0)
+			ret += hiddenInRect(pos.x - dx, pos.y + dy, pos.x + dx, pos.y + dy, pos.z);
+	}
+	return ret;
+}
+
+std::vector<std::vector<int3>> ExplorationMap::getTilesNearFog(int maxDistance)
+{
+	std::vector<std::vector<int3>> ret(std::max(maxDistance, 1));
+	std::set<int3> visited;
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		if(hidden.empty() || sizes != cb->getMapSize())
+			init();
+
+		if(maxDistance > 1)
+			ret[1].assign(frontier.begin(), frontier.end());
+	}
+	if(maxDistance > 1)
+		visited.insert(ret[1].begin(), ret[1].end());
+
+	CCallback * cbp = cb.get();
+	for(int i = 2; i < maxDistance; i++)
+	{
+		for(const int3 &tile : ret[i - 1])
+		{
+			foreach_neighbour(cbp, tile, [&](CCallback * cbp, crint3 neighbour)
+			{
+				if(cbp->isVisible(neighbour) && visited.insert(neighbour).second)
+					ret[i].push_back(neighbour);
+			});
+		}
+		boost::sort(ret[i]);
+	}
+	return ret;
+}
+
+void ExplorationMap::tilesRevealed(const std::unordered_set<int3, ShashInt3> &tiles)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(hidden.empty())
+		return;
+
+	for(const int3 &tile : tiles)
+		hidden[(tile.z * sizes.y + tile.y) * sizes.x + tile.x] = 0;
+	for(const int3 &tile : tiles)
+	{
+		updateFrontier(tile);
+		for(const int3 &dir : int3::getDirs())
+			updateFrontier(tile + dir);
+	}
+	sumsValid = false;
+}
+
+void ExplorationMap::tilesHidden(const std::unordered_set<int3, ShashInt3> &tiles)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(hidden.empty())
+		return;
+
+	for(const int3 &tile : tiles)
+		hidden[(tile.z * sizes.y + tile.y) * sizes.x + tile.x] = 1;
+	for(const int3 &tile : tiles)
+	{
+		updateFrontier(tile);
+		for(const int3 &dir : int3::getDirs())
+			updateFrontier(tile + dir);
+	}
+	sumsValid = false;
+}
+
+void ExplorationMap::clear()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	hidden.clear();
+	frontier.clear();
+	sumsValid = false;
+}
+
 ui64 evaluateDanger(const CGObjectInstance *obj)
 {
 	if(obj->tempOwner < PlayerColor::PLAYER_LIMIT && cb->getPlayerRelations(obj->tempOwner, ai->playerID) != PlayerRelations::ENEMIES) //owned or allied objects don't pose any threat
@@ -452,18 +718,6 @@ int howManyTilesWillBeDiscovered(int radious, int3 pos, crint3 dir)
 	return howManyTilesWillBeDiscovered(pos + dir, radious, cb.get());
 }
 
-void getVisibleNeighbours(const std::vector<int3> &tiles, std::vector<int3> &out)
-{
-	for(const int3 &tile : tiles)
-	{
-		foreach_neighbour(tile, [&](int3 neighbour)
-		{
-			if(cb->isVisible(neighbour))
-				out.push_back(neighbour);
-		});
-	}
-}
-
 ui64 howManyReinforcementsCanGet(HeroPtr h, const CGTownInstance *t)
 {
 	ui64 ret = 0;
@@ -111,6 +111,18 @@ struct TimeCheck
 	}
 };
 
+/// Wall clock time AI may spend on some task, lets AI play turns of predictable length
+class TimeBudget
+{
+	boost::posix_time::ptime start;
+	si64 limit; //in milliseconds, negative if there is no limit
+public:
+	TimeBudget(si64 limit = -1);
+
+	si64 elapsed() const; //in milliseconds
+	bool exhausted() const;
+};
+
 //TODO: replace with vstd::
 struct AtScopeExit
 {
@@ -142,7 +154,6 @@ void foreach_neighbour(CCallback * cbp, const int3 &pos, std::function<void(CCal
 
 int howManyTilesWillBeDiscovered(const int3 &pos, int radious, CCallback * cbp);
 int howManyTilesWillBeDiscovered(int radious, int3 pos, crint3 dir);
-void getVisibleNeighbours(const std::vector<int3> &tiles, std::vector<int3> &out);
 
 bool canBeEmbarkmentPoint(const TerrainTile *t, bool fromWater);
 bool isBlockedBorderGate(int3 tileToHit);
@@ -163,6 +174,59 @@ bool compareArtifacts(const CArtifactInstance *a1, const CArtifactInstance *a2);
 ui64 howManyReinforcementsCanGet(HeroPtr h, const CGTownInstance *t);
 int3 whereToExplore(HeroPtr h);
 
+/// Danger of tiles for visiting heroes, evaluated on first query and kept until something near the tile changes
+class DangerHeatmap
+{
+	struct HeroDangers
+	{
+		ui64 heroStrength; //danger depends on tactical advantage of hero, so it is outdated when his army changes
+		std::vector<ui64> tiles; //[z][y][x]
+	};
+
+	static const ui64 NOT_EVALUATED = std::numeric_limits<ui64>::max();
+
+	boost::mutex mx; //events invalidating tiles come from client thread
+	int3 sizes;
+	std::map<const CGHeroInstance *, HeroDangers> dangers;
+
+	void invalidateTile(crint3 tile);
+public:
+	/// same as evaluateDanger(tile, visitor)
+	ui64 get(crint3 tile, const CGHeroInstance *visitor);
+	/// forgets danger of tile and of tiles guarded from it, should be called when objects or visibility of tile change
+	void invalidate(crint3 tile);
+	/// forgets everything, should be called at start of turn and after battles
+	void clear();
+};
+
+/// Hidden tiles of the map, kept up to date with revealed and hidden tiles, used to pick exploration targets
+class ExplorationMap
+{
+	boost::mutex mx; //tiles are revealed by events from client thread
+	int3 sizes;
+	std::vector<ui8> hidden; //[z][y][x], empty until first query
+	std::set<int3> frontier; //visible tiles with a hidden neighbour
+	std::vector<int> hiddenSums; //summed-area table, [z][y+1][x+1] is number of hidden tiles in rectangle (0,0)-(x,y)
+	bool sumsValid;
+
+	void init();
+	void updateFrontier(crint3 tile);
+	bool isHidden(crint3 tile) const;
+	int hiddenInRect(int x1, int y1, int x2, int y2, int z) const;
+public:
+	ExplorationMap();
+
+	/// upper bound of howManyTilesWillBeDiscovered(pos, radius), exact unless known barriers block the view
+	int hiddenTilesAround(crint3 pos, int radius);
+	/// visible tiles grouped by distance to nearest hidden tile, ret[distance] for distance from 1 up to maxDistance-1
+	std::vector<std::vector<int3>> getTilesNearFog(int maxDistance);
+
+	void tilesRevealed(const std::unordered_set<int3, ShashInt3> &tiles);
+	void tilesHidden(const std::unordered_set<int3, ShashInt3> &tiles);
+	/// forgets everything, visibility is read again on next query
+	void clear();
+};
+
 class CDistanceSorter
 {
 	const CGHeroInstance * hero;
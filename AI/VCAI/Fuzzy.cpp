@@ -17,6 +17,7 @@
 #include "../../lib/CPathfinder.h"
 #include "../../lib/CGameStateFwd.h"
 #include "../../lib/VCMI_Lib.h"
+#include "../../lib/CConfigHandler.h"
 #include "../../CCallback.h"
 #include "VCAI.h"
 
@@ -36,22 +37,6 @@ FuzzyHelper *fh;
 extern boost::thread_specific_ptr<CCallback> cb;
 extern boost::thread_specific_ptr<VCAI> ai;
 
-engineBase::engineBase()
-{
-	engine.addRuleBlock(&rules);
-}
-
-void engineBase::configure()
-{
-	engine.configure("Minimum", "Maximum", "Minimum", "AlgebraicSum", "Centroid", "General");
-	logAi->info(engine.toString());
-}
-
-void engineBase::addRule(const std::string &txt)
-{
-	rules.addRule(fl::Rule::parse(txt, &engine));
-}
-
 struct armyStructure
 {
 	float walkers, shooters, flyers;
@@ -97,8 +82,12 @@ FuzzyHelper::FuzzyHelper()
 {
 	initTacticalAdvantage();
 	ta.configure();
-	initVisitTile();
+	vt.init(SAFE_ATTACK_CONSTANT);
 	vt.configure();
+
+	useLookupTables = settings["server"]["aiFuzzyLookupTables"].Bool();
+	if(useLookupTables)
+		useLookupTables = vt.buildTables();
 }
 
 
@@ -230,6 +219,7 @@ float FuzzyHelper::getTacticalAdvantage (const CArmedInstance *we, const CArmedI
 		armyStructure ourStructure = evaluateArmyStructure(we);
 		armyStructure enemyStructure = evaluateArmyStructure(enemy);
 
+		boost::unique_lock<boost::mutex> lock(engineMx);
 		ta.ourWalkers->setValue(ourStructure.walkers);
 		ta.ourShooters->setValue(ourStructure.shooters);
 		ta.ourFlyers->setValue(ourStructure.flyers);
@@ -301,8 +291,6 @@ Goals::TSubgoal FuzzyHelper::chooseSolution (Goals::TGoalVec vec)
 	if (vec.empty()) //no possibilities found
 		return sptr(Goals::Invalid());
 
-	ai->cachedSectorMaps.clear();
-
 	//a trick to switch between heroes less often - calculatePaths is costly
 	auto sortByHeroes = [](const Goals::TSubgoal & lhs, const Goals::TSubgoal & rhs) -> bool
 	{
@@ -332,95 +320,6 @@ float FuzzyHelper::evaluate (Goals::RecruitHero & g)
 {
 	return 1; //just try to recruit hero as one of options
 }
-FuzzyHelper::EvalVisitTile::~EvalVisitTile()
-{
-	delete strengthRatio;
-	delete heroStrength;
-	delete turnDistance;
-	delete missionImportance;
-	delete estimatedReward;
-}
-
-void FuzzyHelper::initVisitTile()
-{
-	try
-	{
-		vt.strengthRatio = new fl::InputVariable("strengthRatio"); //hero must be strong enough to defeat guards
-		vt.heroStrength = new fl::InputVariable("heroStrength"); //we want to use weakest possible hero
-		vt.turnDistance = new fl::InputVariable("turnDistance"); //we want to use hero who is near
-		vt.missionImportance = new fl::InputVariable("lockedMissionImportance"); //we may want to preempt hero with low-priority mission
-		vt.estimatedReward = new fl::InputVariable("estimatedReward"); //indicate AI that content of the file is important or it is probably bad
-		vt.value = new fl::OutputVariable("Value");
-		vt.value->setMinimum(0);
-		vt.value->setMaximum(5);
-
-		std::vector<fl::InputVariable*> helper = {vt.strengthRatio, vt.heroStrength, vt.turnDistance, vt.missionImportance, vt.estimatedReward};
-		for (auto val : helper)
-		{
-			vt.engine.addInputVariable(val);
-		}
-		vt.engine.addOutputVariable(vt.value);
-
-		vt.strengthRatio->addTerm(new fl::Ramp("LOW", SAFE_ATTACK_CONSTANT, 0));
-		vt.strengthRatio->addTerm(new fl::Ramp("HIGH", SAFE_ATTACK_CONSTANT, SAFE_ATTACK_CONSTANT * 3));
-		vt.strengthRatio->setRange(0, SAFE_ATTACK_CONSTANT * 3 );
-
-		//strength compared to our main hero
-		vt.heroStrength->addTerm(new fl::Ramp("LOW", 0.2, 0));
-		vt.heroStrength->addTerm(new fl::Triangle("MEDIUM", 0.2, 0.8));
-		vt.heroStrength->addTerm(new fl::Ramp("HIGH", 0.5, 1));
-		vt.heroStrength->setRange(0.0, 1.0);
-
-		vt.turnDistance->addTerm(new fl::Ramp("SMALL", 0.5, 0));
-		vt.turnDistance->addTerm(new fl::Triangle("MEDIUM", 0.1, 0.8));
-		vt.turnDistance->addTerm(new fl::Ramp("LONG", 0.5, 3));
-		vt.turnDistance->setRange(0.0, 3.0);
-
-		vt.missionImportance->addTerm(new fl::Ramp("LOW", 2.5, 0));
-		vt.missionImportance->addTerm(new fl::Triangle("MEDIUM", 2, 3));
-		vt.missionImportance->addTerm(new fl::Ramp("HIGH", 2.5, 5));
-		vt.missionImportance->setRange(0.0, 5.0);
-
-		vt.estimatedReward->addTerm(new fl::Ramp("LOW", 2.5, 0));
-		vt.estimatedReward->addTerm(new fl::Ramp("HIGH", 2.5, 5));
-		vt.estimatedReward->setRange(0.0, 5.0);
-
-		//an issue: in 99% cases this outputs center of mass (2.5) regardless of actual input :/
-		 //should be same as "mission Importance" to keep consistency
-		vt.value->addTerm(new fl::Ramp("LOW", 2.5, 0));
-		vt.value->addTerm(new fl::Triangle("MEDIUM", 2, 3)); //can't be center of mass :/
-		vt.value->addTerm(new fl::Ramp("HIGH", 2.5, 5));
-		vt.value->setRange(0.0,5.0);
-
-		//use unarmed scouts if possible
-		vt.addRule("if strengthRatio is HIGH and heroStrength is LOW then Value is very HIGH");
-		//we may want to use secondary hero(es) rather than main hero
-		vt.addRule("if strengthRatio is HIGH and heroStrength is MEDIUM then Value is somewhat HIGH");
-		vt.addRule("if strengthRatio is HIGH and heroStrength is HIGH then Value is somewhat LOW");
-		//don't assign targets to heroes who are too weak, but prefer targets of our main hero (in case we need to gather army)
-		vt.addRule("if strengthRatio is LOW and heroStrength is LOW then Value is very LOW");
-		//attempt to arm secondary heroes is not stupid
-		vt.addRule("if strengthRatio is LOW and heroStrength is MEDIUM then Value is somewhat HIGH");
-		vt.addRule("if strengthRatio is LOW and heroStrength is HIGH then Value is LOW");
-
-		//do not cancel important goals
-		vt.addRule("if lockedMissionImportance is HIGH then Value is very LOW");
-		vt.addRule("if lockedMissionImportance is MEDIUM then Value is somewhat LOW");
-		vt.addRule("if lockedMissionImportance is LOW then Value is HIGH");
-		//pick nearby objects if it's easy, avoid long walks
-		vt.addRule("if turnDistance is SMALL then Value is HIGH");
-		vt.addRule("if turnDistance is MEDIUM then Value is MEDIUM");
-		vt.addRule("if turnDistance is LONG then Value is LOW");
-		//some goals are more rewarding by definition f.e. capturing town is more important than collecting resource - experimental
-		vt.addRule("if estimatedReward is HIGH then Value is very HIGH");
-		vt.addRule("if estimatedReward is LOW then Value is somewhat LOW");
-	}
-	catch (fl::Exception & fe)
-	{
-		logAi->error("visitTile: %s",fe.getWhat());
-	}
-}
-
 float FuzzyHelper::evaluate (Goals::VisitTile & g)
 {
 	//we assume that hero is already set and we want to choose most suitable one for the mission
@@ -450,18 +349,30 @@ float FuzzyHelper::evaluate (Goals::VisitTile & g)
 		strengthRatio = (fl::scalar)g.hero.h->getTotalStrength() / danger;
 
 	float tilePriority = 0;
-	if(g.objid == -1)
-		vt.estimatedReward->setEnabled(false);
-	else if(g.objid == Obj::TOWN) //TODO: move to getObj eventually and add appropiate logic there
+	bool rewardEnabled = false;
+	if(g.objid == Obj::TOWN) //TODO: move to getObj eventually and add appropiate logic there
 	{
-		vt.estimatedReward->setEnabled(true);
+		rewardEnabled = true;
 		tilePriority = 5;
 	}
 		
+	const fl::scalar heroStrength = (fl::scalar)g.hero->getTotalStrength() / ai->primaryHero()->getTotalStrength();
+	if (useLookupTables) //tables are read-only once built, no need to lock
+	{
+		if (rewardEnabled)
+			g.priority = vt.rewardTable.evaluate({strengthRatio, heroStrength, turns, missionImportance, tilePriority});
+		else
+			g.priority = vt.table.evaluate({strengthRatio, heroStrength, turns, missionImportance});
+		assert (g.priority >= 0);
+		return g.priority;
+	}
+
+	boost::unique_lock<boost::mutex> lock(engineMx);
 	try
 	{
+		vt.estimatedReward->setEnabled(rewardEnabled);
 		vt.strengthRatio->setValue(strengthRatio);
-		vt.heroStrength->setValue((fl::scalar)g.hero->getTotalStrength() / ai->primaryHero()->getTotalStrength());
+		vt.heroStrength->setValue(heroStrength);
 		vt.turnDistance->setValue(turns);
 		vt.missionImportance->setValue(missionImportance);
 		vt.estimatedReward->setValue(tilePriority);
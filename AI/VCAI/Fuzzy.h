@@ -8,7 +8,7 @@
  *
 */
 #pragma once
-#include "fl/Headers.h"
+#include "FuzzyEngines.h"
 #include "Goals.h"
 
 class VCAI;
@@ -16,17 +16,6 @@ class CArmedInstance;
 class CBank;
 struct SectorMap;
 
-class engineBase
-{
-public:
-	fl::Engine engine;
-	fl::RuleBlock rules;
-
-	engineBase();
-	void configure();
-	void addRule(const std::string &txt);
-};
-
 class FuzzyHelper
 {
 	friend class VCAI;
@@ -42,20 +31,11 @@ class FuzzyHelper
 		~TacticalAdvantage();
 	} ta;
 
-	class EvalVisitTile : public engineBase
-	{
-	public:
-		fl::InputVariable * strengthRatio;
-		fl::InputVariable * heroStrength;
-		fl::InputVariable * turnDistance;
-		fl::InputVariable * missionImportance;
-		fl::InputVariable * estimatedReward;
-		fl::OutputVariable * value;
-		fl::RuleBlock rules;
-		~EvalVisitTile();
-	} vt;
+	VisitTileEngine vt;
+
+	boost::mutex engineMx; //engines are shared by AI players, which may make turns at the same time
+	bool useLookupTables; //evaluate precomputed tables instead of running fuzzy engines
 
-	
 
 public:
 	enum RuleBlocks {BANK_DANGER, TACTICAL_ADVANTAGE, VISIT_TILE};
@@ -63,7 +43,6 @@ public:
 
 	FuzzyHelper();
 	void initTacticalAdvantage();
-	void initVisitTile();
 
 	float evaluate (Goals::Explore & g);
 	float evaluate (Goals::RecruitHero & g);
@@ -0,0 +1,217 @@
+/*
+ * FuzzyEngines.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+*/
+#include "StdInc.h"
+#include "FuzzyEngines.h"
+
+const double SAFE_ATTACK_CONSTANT = 1.5;
+
+engineBase::engineBase()
+{
+	engine.addRuleBlock(&rules);
+}
+
+void engineBase::configure()
+{
+	engine.configure("Minimum", "Maximum", "Minimum", "AlgebraicSum", "Centroid", "General");
+	logAi->info(engine.toString());
+}
+
+void engineBase::addRule(const std::string &txt)
+{
+	rules.addRule(fl::Rule::parse(txt, &engine));
+}
+
+void FuzzyLookupTable::build(engineBase &base, const std::vector<fl::InputVariable *> &inputs, const std::vector<std::vector<fl::scalar>> &Axes, fl::OutputVariable *output)
+{
+	assert(inputs.size() == Axes.size());
+	if(Axes.size() > MAX_DIMENSIONS)
+		throw std::runtime_error("Fuzzy lookup table supports at most " + std::to_string(MAX_DIMENSIONS) + " inputs");
+	axes = Axes;
+
+	size_t count = 1;
+	for(auto &axis : axes)
+		count *= axis.size();
+	samples.resize(count);
+
+	std::vector<size_t> point(axes.size(), 0);
+	for(size_t i = 0; i < count; i++)
+	{
+		for(size_t d = 0; d < axes.size(); d++)
+			inputs[d]->setValue(axes[d][point[d]]);
+		base.engine.process();
+		samples[i] = output->getValue();
+
+		for(size_t d = axes.size(); d-- > 0;) //next point, last input changes fastest
+		{
+			if(++point[d] < axes[d].size())
+				break;
+			point[d] = 0;
+		}
+	}
+}
+
+fl::scalar FuzzyLookupTable::evaluate(std::initializer_list<fl::scalar> values) const
+{
+	assert(values.size() == axes.size());
+	const size_t dimensions = axes.size();
+
+	//cell containing values and position inside it
+	std::array<size_t, MAX_DIMENSIONS> lower, stride;
+	std::array<fl::scalar, MAX_DIMENSIONS> weight;
+	size_t step = 1;
+	for(size_t d = dimensions; d-- > 0;)
+	{
+		const auto &axis = axes[d];
+		fl::scalar value = values.begin()[d];
+		vstd::abetween(value, axis.front(), axis.back());
+		size_t i = std::upper_bound(axis.begin(), axis.end(), value) - axis.begin();
+		vstd::abetween(i, size_t(1), axis.size() - 1);
+		lower[d] = i - 1;
+		weight[d] = axis.size() > 1 ? (value - axis[i - 1]) / (axis[i] - axis[i - 1]) : 0;
+		stride[d] = step;
+		step *= axis.size();
+	}
+
+	fl::scalar ret = 0;
+	for(size_t corner = 0; corner < (size_t(1) << dimensions); corner++)
+	{
+		fl::scalar cornerWeight = 1;
+		size_t index = 0;
+		for(size_t d = 0; d < dimensions && cornerWeight > 0; d++)
+		{
+			const bool upper = corner & (size_t(1) << d);
+			cornerWeight *= upper ? weight[d] : 1 - weight[d];
+			index += (lower[d] + upper) * stride[d];
+		}
+		if(cornerWeight > 0)
+			ret += cornerWeight * samples[index];
+	}
+	return ret;
+}
+
+VisitTileEngine::~VisitTileEngine()
+{
+	delete strengthRatio;
+	delete heroStrength;
+	delete turnDistance;
+	delete missionImportance;
+	delete estimatedReward;
+}
+
+void VisitTileEngine::init(fl::scalar SafeAttackRatio)
+{
+	safeAttackRatio = SafeAttackRatio;
+	try
+	{
+		strengthRatio = new fl::InputVariable("strengthRatio"); //hero must be strong enough to defeat guards
+		heroStrength = new fl::InputVariable("heroStrength"); //we want to use weakest possible hero
+		turnDistance = new fl::InputVariable("turnDistance"); //we want to use hero who is near
+		missionImportance = new fl::InputVariable("lockedMissionImportance"); //we may want to preempt hero with low-priority mission
+		estimatedReward = new fl::InputVariable("estimatedReward"); //indicate AI that content of the file is important or it is probably bad
+		value = new fl::OutputVariable("Value");
+		value->setMinimum(0);
+		value->setMaximum(5);
+
+		std::vector<fl::InputVariable*> helper = {strengthRatio, heroStrength, turnDistance, missionImportance, estimatedReward};
+		for (auto val : helper)
+		{
+			engine.addInputVariable(val);
+		}
+		engine.addOutputVariable(value);
+
+		strengthRatio->addTerm(new fl::Ramp("LOW", safeAttackRatio, 0));
+		strengthRatio->addTerm(new fl::Ramp("HIGH", safeAttackRatio, safeAttackRatio * 3));
+		strengthRatio->setRange(0, safeAttackRatio * 3 );
+
+		//strength compared to our main hero
+		heroStrength->addTerm(new fl::Ramp("LOW", 0.2, 0));
+		heroStrength->addTerm(new fl::Triangle("MEDIUM", 0.2, 0.8));
+		heroStrength->addTerm(new fl::Ramp("HIGH", 0.5, 1));
+		heroStrength->setRange(0.0, 1.0);
+
+		turnDistance->addTerm(new fl::Ramp("SMALL", 0.5, 0));
+		turnDistance->addTerm(new fl::Triangle("MEDIUM", 0.1, 0.8));
+		turnDistance->addTerm(new fl::Ramp("LONG", 0.5, 3));
+		turnDistance->setRange(0.0, 3.0);
+
+		missionImportance->addTerm(new fl::Ramp("LOW", 2.5, 0));
+		missionImportance->addTerm(new fl::Triangle("MEDIUM", 2, 3));
+		missionImportance->addTerm(new fl::Ramp("HIGH", 2.5, 5));
+		missionImportance->setRange(0.0, 5.0);
+
+		estimatedReward->addTerm(new fl::Ramp("LOW", 2.5, 0));
+		estimatedReward->addTerm(new fl::Ramp("HIGH", 2.5, 5));
+		estimatedReward->setRange(0.0, 5.0);
+
+		//an issue: in 99% cases this outputs center of mass (2.5) regardless of actual input :/
+		 //should be same as "mission Importance" to keep consistency
+		value->addTerm(new fl::Ramp("LOW", 2.5, 0));
+		value->addTerm(new fl::Triangle("MEDIUM", 2, 3)); //can't be center of mass :/
+		value->addTerm(new fl::Ramp("HIGH", 2.5, 5));
+		value->setRange(0.0,5.0);
+
+		//use unarmed scouts if possible
+		addRule("if strengthRatio is HIGH and heroStrength is LOW then Value is very HIGH");
+		//we may want to use secondary hero(es) rather than main hero
+		addRule("if strengthRatio is HIGH and heroStrength is MEDIUM then Value is somewhat HIGH");
+		addRule("if strengthRatio is HIGH and heroStrength is HIGH then Value is somewhat LOW");
+		//don't assign targets to heroes who are too weak, but prefer targets of our main hero (in case we need to gather army)
+		addRule("if strengthRatio is LOW and heroStrength is LOW then Value is very LOW");
+		//attempt to arm secondary heroes is not stupid
+		addRule("if strengthRatio is LOW and heroStrength is MEDIUM then Value is somewhat HIGH");
+		addRule("if strengthRatio is LOW and heroStrength is HIGH then Value is LOW");
+
+		//do not cancel important goals
+		addRule("if lockedMissionImportance is HIGH then Value is very LOW");
+		addRule("if lockedMissionImportance is MEDIUM then Value is somewhat LOW");
+		addRule("if lockedMissionImportance is LOW then Value is HIGH");
+		//pick nearby objects if it's easy, avoid long walks
+		addRule("if turnDistance is SMALL then Value is HIGH");
+		addRule("if turnDistance is MEDIUM then Value is MEDIUM");
+		addRule("if turnDistance is LONG then Value is LOW");
+		//some goals are more rewarding by definition f.e. capturing town is more important than collecting resource - experimental
+		addRule("if estimatedReward is HIGH then Value is very HIGH");
+		addRule("if estimatedReward is LOW then Value is somewhat LOW");
+	}
+	catch (fl::Exception & fe)
+	{
+		logAi->error("visitTile: %s",fe.getWhat());
+	}
+}
+
+bool VisitTileEngine::buildTables()
+{
+	//samples are placed at edges of terms, inputs above range have same membership as range end
+	std::vector<fl::InputVariable *> inputs = {strengthRatio, heroStrength, turnDistance, missionImportance};
+	std::vector<std::vector<fl::scalar>> axes =
+	{
+		{0, safeAttackRatio * 0.5, safeAttackRatio, safeAttackRatio * 1.5, safeAttackRatio * 2, safeAttackRatio * 2.5, safeAttackRatio * 3},
+		{0, 0.2, 0.35, 0.5, 0.65, 0.8, 1},
+		{0, 0.1, 0.3, 0.5, 0.8, 1.5, 3},
+		{0, 1, 2, 2.5, 3, 4, 5}
+	};
+
+	try
+	{
+		estimatedReward->setEnabled(false);
+		table.build(*this, inputs, axes, value);
+
+		estimatedReward->setEnabled(true);
+		inputs.push_back(estimatedReward);
+		axes.push_back({0, 5}); //reward is either unknown or town
+		rewardTable.build(*this, inputs, axes, value);
+	}
+	catch (fl::Exception & fe)
+	{
+		logAi->error("buildTables: %s", fe.getWhat());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+/*
+ * FuzzyEngines.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+*/
+#pragma once
+#include "fl/Headers.h"
+
+extern const double SAFE_ATTACK_CONSTANT; //strength ratio at which attack is considered safe
+
+class engineBase
+{
+public:
+	fl::Engine engine;
+	fl::RuleBlock rules;
+
+	engineBase();
+	void configure();
+	void addRule(const std::string &txt);
+};
+
+/// Output of fuzzy engine sampled on a grid of its inputs, evaluated by multilinear interpolation between samples
+class FuzzyLookupTable
+{
+	std::vector<std::vector<fl::scalar>> axes; //sample points of every input, ascending
+	std::vector<fl::scalar> samples; //last input changes fastest
+
+public:
+	static const size_t MAX_DIMENSIONS = 5;
+
+	/// runs engine for every point of the grid, inputs not given are left as they are
+	void build(engineBase &base, const std::vector<fl::InputVariable *> &inputs, const std::vector<std::vector<fl::scalar>> &Axes, fl::OutputVariable *output);
+	/// values outside of axes are clamped to the nearest sample; doesn't allocate, AI calls it for every tile it considers
+	fl::scalar evaluate(std::initializer_list<fl::scalar> values) const;
+};
+
+/// Rates how suitable is a hero for visiting a tile; doesn't depend on game state, so it can be tested alone
+class VisitTileEngine : public engineBase
+{
+	fl::scalar safeAttackRatio;
+
+public:
+	fl::InputVariable * strengthRatio;
+	fl::InputVariable * heroStrength;
+	fl::InputVariable * turnDistance;
+	fl::InputVariable * missionImportance;
+	fl::InputVariable * estimatedReward;
+	fl::OutputVariable * value;
+
+	FuzzyLookupTable table; //estimated reward disabled
+	FuzzyLookupTable rewardTable;
+
+	/// SafeAttackRatio is strength ratio at which attack is considered safe, VCAI uses SAFE_ATTACK_CONSTANT
+	void init(fl::scalar SafeAttackRatio);
+	/// samples configured engine into tables, returns false if engine failed
+	bool buildTables();
+	~VisitTileEngine();
+};
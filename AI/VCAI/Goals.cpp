@@ -27,6 +27,71 @@ TSubgoal Goals::sptr(const AbstractGoal & tmp)
 	return ptr;
 }
 
+TGoalVec Goals::AbstractGoal::getCachedSubgoals()
+{
+	return ai->subgoalsCache.get(*this);
+}
+
+SubgoalsCache::SubgoalsCache()
+{
+	generation = 0;
+	hits = misses = 0;
+}
+
+SubgoalsCache::TKey SubgoalsCache::key(const AbstractGoal &goal)
+{
+	return TKey(goal.goalType, goal.hero.h, goal.town, goal.tile, goal.objid, goal.resID, goal.aid, goal.bid, goal.value);
+}
+
+TGoalVec SubgoalsCache::copy(const TGoalVec &goals)
+{
+	TGoalVec ret;
+	for(auto goal : goals)
+		ret.push_back(sptr(*goal));
+	return ret;
+}
+
+TGoalVec SubgoalsCache::get(AbstractGoal &goal)
+{
+	const TKey goalKey = key(goal);
+	ui32 startGeneration;
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		auto it = subgoals.find(goalKey);
+		if(it != subgoals.end())
+		{
+			hits++;
+			return copy(it->second);
+		}
+		misses++;
+		startGeneration = generation;
+	}
+
+	TGoalVec ret = goal.getAllPossibleSubgoals(); //exceptions, like fulfilled goal, are never cached
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(generation == startGeneration)
+		subgoals[goalKey] = copy(ret);
+	return ret;
+}
+
+void SubgoalsCache::invalidate()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	subgoals.clear();
+	generation++;
+}
+
+void SubgoalsCache::clear()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(hits || misses)
+		logAi->debug("Goal decomposition: %d subgoal lists reused, %d searched", hits, misses);
+	subgoals.clear();
+	generation++;
+	hits = misses = 0;
+}
+
 std::string Goals::AbstractGoal::name() const //TODO: virtualize
 {
 	std::string desc;
@@ -470,7 +535,7 @@ TSubgoal ClearWayTo::whatToDoToAchieve()
 		return sptr (Goals::Explore());
 	}
 
-	return (fh->chooseSolution(getAllPossibleSubgoals()));
+	return (fh->chooseSolution(getCachedSubgoals()));
 }
 
 TGoalVec ClearWayTo::getAllPossibleSubgoals()
@@ -563,7 +628,7 @@ std::string Explore::completeMessage() const
 
 TSubgoal Explore::whatToDoToAchieve()
 {
-	auto ret = fh->chooseSolution(getAllPossibleSubgoals());
+	auto ret = fh->chooseSolution(getCachedSubgoals());
 	if (hero) //use best step for this hero
 		return ret;
 	else
@@ -952,7 +1017,7 @@ TSubgoal GatherTroops::whatToDoToAchieve()
 
 TSubgoal Conquer::whatToDoToAchieve()
 {
-	return fh->chooseSolution (getAllPossibleSubgoals());
+	return fh->chooseSolution (getCachedSubgoals());
 }
 TGoalVec Conquer::getAllPossibleSubgoals()
 {
@@ -1053,7 +1118,7 @@ TSubgoal GatherArmy::whatToDoToAchieve()
 	//TODO: find hero if none set
 	assert(hero.h);
 
-	return fh->chooseSolution (getAllPossibleSubgoals()); //find dwelling. use current hero to prevent him from doing nothing.
+	return fh->chooseSolution (getCachedSubgoals()); //find dwelling. use current hero to prevent him from doing nothing.
 }
 
 static const BuildingID unitsSource[] = { BuildingID::DWELL_LVL_1, BuildingID::DWELL_LVL_2, BuildingID::DWELL_LVL_3,
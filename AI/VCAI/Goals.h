@@ -96,6 +96,7 @@ public:
 	virtual AbstractGoal * clone() const {return const_cast<AbstractGoal*>(this);};
 	virtual TGoalVec getAllPossibleSubgoals() {TGoalVec vec; return vec;};
 	virtual TSubgoal whatToDoToAchieve() {return sptr(AbstractGoal());};
+	TGoalVec getCachedSubgoals(); //same as getAllPossibleSubgoals, reused if nothing changed since last call for equal goal
 
 	EGoals goalType;
 
@@ -373,4 +374,26 @@ class CIssueCommand : public CGoal<CIssueCommand>
 	//TSubgoal whatToDoToAchieve() override {return sptr(Invalid());};
 };
 
+/// Subgoals of goals decomposed during current turn, forgotten whenever game state or AI plans change
+class SubgoalsCache
+{
+	//goal type, hero, town, tile, objid, resID, aid, bid, value
+	typedef std::tuple<int, const CGHeroInstance *, const CGTownInstance *, int3, int, int, int, int, int> TKey;
+
+	boost::mutex mx; //events invalidating cache come from client thread
+	std::map<TKey, TGoalVec> subgoals;
+	ui32 generation; //incremented on invalidation, subgoals found meanwhile are not stored
+	ui32 hits, misses;
+
+	static TKey key(const AbstractGoal &goal);
+	static TGoalVec copy(const TGoalVec &goals); //subgoals are modified by callers, eg. by setting priority
+public:
+	SubgoalsCache();
+
+	TGoalVec get(AbstractGoal &goal);
+	void invalidate();
+	/// forgets everything and logs statistics of current turn
+	void clear();
+};
+
 }
@@ -26,7 +26,6 @@ extern FuzzyHelper *fh;
 
 class CGVisitableOPW;
 
-const double SAFE_ATTACK_CONSTANT = 1.5;
 const int GOLD_RESERVE = 10000; //when buying creatures we want to keep at least this much gold (10000 so at least we'll be able to reach capitol)
 
 //one thread may be turn of AI and another will be handling a side effect for AI2
@@ -56,7 +55,8 @@ struct SetGlobalState
 
 #define SET_GLOBAL_STATE(ai) SetGlobalState _hlpSetState(ai);
 
-#define NET_EVENT_HANDLER SET_GLOBAL_STATE(this)
+//every event may change what AI should do, subgoals found so far are outdated
+#define NET_EVENT_HANDLER SET_GLOBAL_STATE(this); subgoalsCache.invalidate()
 #define MAKING_TURN SET_GLOBAL_STATE(this)
 
 void foreach_tile(std::vector< std::vector< std::vector<unsigned char> > > &vectors, std::function<void(unsigned char &in)> foo)
@@ -87,6 +87,7 @@ VCAI::VCAI(void)
 	makingTurn = nullptr;
 	destinationTeleport = ObjectInstanceID();
 	destinationTeleportPos = int3(-1);
+	sectorMap = std::make_shared<SectorMap>();
 }
 
 VCAI::~VCAI(void)
@@ -108,10 +109,12 @@ void VCAI::heroMoved(const TryMoveHero & details)
 
 	validateObject(details.id); //enemy hero may have left visible area
 	auto hero = cb->getHero(details.id);
-	cachedSectorMaps.clear();
 
 	const int3 from = CGHeroInstance::convertPosition(details.start, false),
 		to = CGHeroInstance::convertPosition(details.end, false);
+	sectorMap->objectsMoved(std::set<int3>{from, to});
+	dangerHeatmap.invalidate(from);
+	dangerHeatmap.invalidate(to);
 	const CGObjectInstance *o1 = vstd::frontOrNull(cb->getVisitableObjs(from)),
 		*o2 = vstd::frontOrNull(cb->getVisitableObjs(to));
 
@@ -296,6 +299,10 @@ void VCAI::tileHidden(const std::unordered_set<int3, ShashInt3> &pos)
 
 	validateVisitableObjs();
 	clearPathsInfo();
+	sectorMap->invalidate(); //sectors may fall apart
+	explorationMap.tilesHidden(pos);
+	for(int3 tile : pos)
+		dangerHeatmap.invalidate(tile);
 }
 
 void VCAI::tileRevealed(const std::unordered_set<int3, ShashInt3> &pos)
@@ -303,10 +310,15 @@ void VCAI::tileRevealed(const std::unordered_set<int3, ShashInt3> &pos)
 	LOG_TRACE(logAi);
 	NET_EVENT_HANDLER;
 	for(int3 tile : pos)
+	{
 		for(const CGObjectInstance *obj : myCb->getVisitableObjs(tile))
 			addVisitableObj(obj);
+		dangerHeatmap.invalidate(tile);
+	}
 
 	clearPathsInfo();
+	sectorMap->tilesChanged(pos);
+	explorationMap.tilesRevealed(pos);
 }
 
 void VCAI::heroExchangeStarted(ObjectInstanceID hero1, ObjectInstanceID hero2, QueryID query)
@@ -396,7 +408,9 @@ void VCAI::newObject(const CGObjectInstance * obj)
 	if(obj->isVisitable())
 		addVisitableObj(obj);
 
-	cachedSectorMaps.clear();
+	sectorMap->tilesChanged(obj->getBlockedPos());
+	sectorMap->tilesChanged(std::set<int3>{obj->visitablePos()});
+	dangerHeatmap.invalidate(obj->visitablePos());
 }
 
 void VCAI::objectRemoved(const CGObjectInstance *obj)
@@ -423,7 +437,14 @@ void VCAI::objectRemoved(const CGObjectInstance *obj)
 		}
 	}
 
-	cachedSectorMaps.clear(); //invalidate all paths
+	sectorMap->tilesChanged(obj->getBlockedPos()); //object is still on map, tiles are checked on next update
+	if(obj->isVisitable())
+		sectorMap->tilesChanged(std::set<int3>{obj->visitablePos()});
+
+	if(obj->ID == Obj::HERO)
+		dangerHeatmap.clear(); //dangers are stored per hero
+	else
+		dangerHeatmap.invalidate(obj->visitablePos());
 
 	//TODO
 	//there are other places where CGObjectinstance ptrs are stored...
@@ -537,6 +558,9 @@ void VCAI::objectPropertyChanged(const SetObjectProperty * sop)
 {
 	LOG_TRACE(logAi);
 	NET_EVENT_HANDLER;
+	if(auto obj = myCb->getObj(sop->id, false))
+		dangerHeatmap.invalidate(obj->visitablePos());
+
 	if(sop->what == ObjProperty::OWNER)
 	{
 		if(myCb->getPlayerRelations(playerID, (PlayerColor)sop->val) == PlayerRelations::ENEMIES)
@@ -598,6 +622,9 @@ void VCAI::yourTurn()
 	LOG_TRACE(logAi);
 	NET_EVENT_HANDLER;
 	status.startedTurn();
+	dangerHeatmap.clear();
+	explorationMap.clear();
+	sectorMap->invalidate(); //build sectors once per turn from scratch, events are applied incrementally
 	makingTurn = make_unique<boost::thread>(&VCAI::makeTurn, this);
 }
 
@@ -784,6 +811,9 @@ void VCAI::makeTurn()
 void VCAI::makeTurnInternal()
 {
 	saving = 0;
+	const si64 turnTimeLimit = settings["server"]["aiTurnTimeLimit"].Integer();
+	turnBudget = TimeBudget(turnTimeLimit > 0 ? turnTimeLimit : -1);
+	heroThinkingTime.clear();
 
 	//it looks messy here, but it's better to have armed heroes before attempting realizing goals
 	for(const CGTownInstance *t : cb->getTownsInfo())
@@ -795,6 +825,8 @@ void VCAI::makeTurnInternal()
 		auto reservedHeroesCopy = reservedHeroesMap; //work on copy => the map may be changed while iterating (eg because hero died when attempting a goal)
 		for (auto hero : reservedHeroesCopy)
 		{
+			if(outOfTurnTime("visiting reserved objects"))
+				break;
 			if(reservedHeroesMap.count(hero.first))
 				continue; //hero might have been removed while we were in this loop
 			if(!hero.first.validAndSet())
@@ -817,12 +849,13 @@ void VCAI::makeTurnInternal()
 		}
 
 		//now try to win
-		striveToGoal(sptr(Goals::Win()));
+		if(!outOfTurnTime("striving to win"))
+			striveToGoal(sptr(Goals::Win()));
 
 		//finally, continue our abstract long-term goals
 		int oldMovement = 0;
 		int newMovement = 0;
-		while (true)
+		while (!outOfTurnTime("realizing goals of heroes"))
 		{
 			oldMovement = newMovement; //remember old value
 			newMovement = 0;
@@ -830,7 +863,7 @@ void VCAI::makeTurnInternal()
 			for (auto mission : lockedHeroes)
 			{
 				fh->setPriority (mission.second); //re-evaluate
-				if (canAct(mission.first))
+				if (canAct(mission.first) && !heroBudget(mission.first).exhausted())
 				{
 					newMovement += mission.first->movement;
 					safeCopy.push_back (mission);
@@ -852,13 +885,18 @@ void VCAI::makeTurnInternal()
 					return m1.second->priority < m2.second->priority;
 				};
 				boost::sort(safeCopy, lockedHeroesSorter);
+
+				TimeBudget heroTime;
 				striveToGoal (safeCopy.back().second);
+				heroThinkingTime[safeCopy.back().first] += heroTime.elapsed();
 			}
 		}
 
 		auto quests = myCb->getMyQuests();
 		for (auto quest : quests)
 		{
+			if(outOfTurnTime("quests"))
+				break;
 			striveToQuest (quest);
 		}
 
@@ -871,6 +909,10 @@ void VCAI::makeTurnInternal()
 			if (h->movement)
 				logAi->warn("Hero %s has %d MP left", h->name, h->movement);
 		}
+		for (auto heroTime : heroThinkingTime)
+			logAi->debug("Hero %s was given %d ms of thinking", heroTime.first.name, heroTime.second);
+		subgoalsCache.clear();
+		logAi->info("Player %d: turn took %d ms", playerID, turnBudget.elapsed());
 	}
 	catch(boost::thread_interrupted &e)
 	{
@@ -885,6 +927,24 @@ void VCAI::makeTurnInternal()
 	endTurn();
 }
 
+bool VCAI::outOfTurnTime(crstring skipped)
+{
+	if(!turnBudget.exhausted())
+		return false;
+
+	logAi->warn("Player %d: turn time budget exhausted after %d ms, skipping %s", playerID, turnBudget.elapsed(), skipped);
+	return true;
+}
+
+TimeBudget VCAI::heroBudget(HeroPtr h)
+{
+	const si64 heroTimeLimit = settings["server"]["aiHeroTimeLimit"].Integer();
+	if(heroTimeLimit <= 0)
+		return TimeBudget();
+
+	return TimeBudget(std::max<si64>(heroTimeLimit - heroThinkingTime[h], 0));
+}
+
 bool VCAI::goVisitObj(const CGObjectInstance * obj, HeroPtr h)
 {
 	int3 dst = obj->visitablePos();
@@ -1497,6 +1557,11 @@ void VCAI::wander(HeroPtr h)
 	}
 
 	TimeCheck tc("looking for wander destination");
+	TimeBudget budget = heroBudget(h);
+	AtScopeExit accountTime([&]()
+	{
+		heroThinkingTime[h] += budget.elapsed();
+	});
 
 	while (h->movement)
 	{
@@ -1515,6 +1580,12 @@ void VCAI::wander(HeroPtr h)
 			return false;
 		});
 
+		if(!dests.size() && (turnBudget.exhausted() || budget.exhausted())) //reserved objects are still visited, looking for new ones is the costly part
+		{
+			logAi->debug("%s stops wandering, out of time", h->name);
+			break;
+		}
+
 		int pass = 0;
 		while(!dests.size() && pass < 3)
 		{
@@ -1639,6 +1710,7 @@ void VCAI::wander(HeroPtr h)
 
 void VCAI::setGoal(HeroPtr h, Goals::TSubgoal goal)
 {
+	subgoalsCache.invalidate(); //goals of other heroes matter when choosing subgoals
 	if(goal->invalid())
 		vstd::erase_if_present(lockedHeroes, h);
 	else
@@ -1655,6 +1727,7 @@ void VCAI::evaluateGoal(HeroPtr h)
 
 void VCAI::completeGoal (Goals::TSubgoal goal)
 {
+	subgoalsCache.invalidate();
 	logAi->trace("Completing goal: %s", goal->name());
 	if (const CGHeroInstance * h = goal->hero.get(true))
 	{
@@ -1696,6 +1769,7 @@ void VCAI::battleEnd(const BattleResult *br)
 	NET_EVENT_HANDLER;
 	assert(status.getBattle() == ONGOING_BATTLE);
 	status.setBattle(ENDING_BATTLE);
+	dangerHeatmap.clear();
 	bool won = br->winner == myCb->battleGetMySide();
 	logAi->debug("Player %d (%s): I %s the %s!", playerID, playerID.getStr(), (won  ? "won" : "lost"), battlename);
 	battlename.clear();
@@ -1721,6 +1795,7 @@ void VCAI::markObjectVisited (const CGObjectInstance *obj)
 
 void VCAI::reserveObject(HeroPtr h, const CGObjectInstance *obj)
 {
+	subgoalsCache.invalidate();
 	reservedObjs.insert(obj);
 	reservedHeroesMap[h].insert(obj);
 	logAi->debug("reserved object id=%d; address=%p; name=%s", obj->id ,obj, obj->getObjectName());
@@ -1728,16 +1803,19 @@ void VCAI::reserveObject(HeroPtr h, const CGObjectInstance *obj)
 
 void VCAI::unreserveObject(HeroPtr h, const CGObjectInstance *obj)
 {
+	subgoalsCache.invalidate();
 	vstd::erase_if_present(reservedObjs, obj); //unreserve objects
 	vstd::erase_if_present(reservedHeroesMap[h], obj);
 }
 
 void VCAI::markHeroUnableToExplore (HeroPtr h)
 {
+	subgoalsCache.invalidate();
 	heroesUnableToExplore.insert(h);
 }
 void VCAI::markHeroAbleToExplore (HeroPtr h)
 {
+	subgoalsCache.invalidate();
 	vstd::erase_if_present(heroesUnableToExplore, h);
 }
 bool VCAI::isAbleToExplore (HeroPtr h)
@@ -1747,7 +1825,6 @@ bool VCAI::isAbleToExplore (HeroPtr h)
 void VCAI::clearPathsInfo()
 {
 	heroesUnableToExplore.clear();
-	cachedSectorMaps.clear();
 }
 
 void VCAI::validateVisitableObjs()
@@ -1963,9 +2040,12 @@ bool VCAI::moveHeroToTile(int3 dst, HeroPtr h)
 			return nullptr;
 		};
 
+		//simple steps are collected and sent to server in one request
+		std::vector<HeroPathStep> steps;
+
 		auto doMovement = [&](int3 dst, bool transit)
 		{
-			cb->moveHero(*h, CGHeroInstance::convertPosition(dst, true), transit);
+			steps.push_back(HeroPathStep(CGHeroInstance::convertPosition(dst, true), transit));
 		};
 
 		auto doTeleportMovement = [&](ObjectInstanceID exitId, int3 exitPos)
@@ -1993,6 +2073,23 @@ bool VCAI::moveHeroToTile(int3 dst, HeroPtr h)
 			doTeleportMovement(currentExit, currentPos);
 		};
 
+		//returns false if hero stopped before the last collected step
+		auto flushMovement = [&]() -> bool
+		{
+			if(steps.empty())
+				return true;
+
+			const int3 lastStep = steps.back().dest;
+			cb->moveHeroAlongPath(*h, steps, true);
+			steps.clear();
+			afterMovementCheck();
+
+			if(teleportChannelProbingList.size())
+				doChannelProbing();
+
+			return h->pos == lastStep;
+		};
+
 		for(; i>0; i--)
 		{
 			int3 currentCoord = path.nodes[i].coord;
@@ -2004,6 +2101,8 @@ bool VCAI::moveHeroToTile(int3 dst, HeroPtr h)
 			auto destTeleportObj = getDestTeleportObj(currentObject, nextObjectTop, nextObject);
 			if(isTeleportAction(path.nodes[i-1].action) && destTeleportObj != nullptr)
 			{ //we use special login if hero standing on teleporter it's mean we need
+				if(!flushMovement())
+					break;
 				doTeleportMovement(destTeleportObj->id, nextCoord);
 				if(teleportChannelProbingList.size())
 					doChannelProbing();
@@ -2033,12 +2132,8 @@ bool VCAI::moveHeroToTile(int3 dst, HeroPtr h)
 				doMovement(endpos, true);
 			else
 				doMovement(endpos, false);
-
-			afterMovementCheck();
-
-			if(teleportChannelProbingList.size())
-				doChannelProbing();
 		}
+		flushMovement();
 	}
 	if (h)
 	{
@@ -2324,6 +2419,13 @@ Goals::TSubgoal VCAI::striveToGoalInternal(Goals::TSubgoal ultimateGoal, bool on
 
 	while(1)
 	{
+		//goals realized so far are kept, the rest waits for next turn; building is cheap and doesn't use hero movement, so it always runs
+		if(turnBudget.exhausted() && ultimateGoal->goalType != Goals::BUILD)
+		{
+			logAi->debug("Out of time, stopped striving to goal of type %s", ultimateGoal->name());
+			break;
+		}
+
 		Goals::TSubgoal goal = ultimateGoal;
 		logAi->debug("Striving to goal of type %s", ultimateGoal->name());
 		int maxGoals = searchDepth; //preventing deadlock for mutually dependent goals
@@ -2359,7 +2461,10 @@ Goals::TSubgoal VCAI::striveToGoalInternal(Goals::TSubgoal ultimateGoal, bool on
 			if (!maxGoals) //we counted down to 0 and found no solution
 			{
 				if (ultimateGoal->hero) // we seemingly don't know what to do with hero, free him
+				{
 					vstd::erase_if_present(lockedHeroes, ultimateGoal->hero);
+					subgoalsCache.invalidate();
+				}
 				std::runtime_error e("Too many subgoals, don't know what to do");
 				throw (e);
 			}
@@ -2622,14 +2727,7 @@ int3 VCAI::explorationNewPoint(HeroPtr h)
 	CCallback * cbp = cb.get();
 	const CGHeroInstance * hero = h.get();
 
-	std::vector<std::vector<int3> > tiles; //tiles[distance_to_fow]
-	tiles.resize(radius);
-
-	foreach_tile_pos([&](const int3 &pos)
-	{
-		if(!cbp->isVisible(pos))
-			tiles[0].push_back(pos);
-	});
+	auto tiles = explorationMap.getTilesNearFog(radius); //tiles[distance_to_fow]
 
 	float bestValue = 0; //discovered tile to node distance ratio
 	int3 bestTile(-1,-1,-1);
@@ -2637,19 +2735,23 @@ int3 VCAI::explorationNewPoint(HeroPtr h)
 
 	for (int i = 1; i < radius; i++)
 	{
-		getVisibleNeighbours(tiles[i-1], tiles[i]);
-		vstd::removeDuplicates(tiles[i]);
-
 		for(const int3 &tile : tiles[i])
 		{
 			if (tile == ourPos) //shouldn't happen, but it does
 				continue;
+			const int hiddenTiles = explorationMap.hiddenTilesAround(tile, radius);
+			if (!hiddenTiles)
+				continue;
 			if (!cb->getPathsInfo(hero)->getPathInfo(tile)->reachable()) //this will remove tiles that are guarded by monsters (or removable objects)
 				continue;
 
 			CGPath path;
 			cb->getPathsInfo(hero)->getPath(path, tile);
-			float ourValue = (float)howManyTilesWillBeDiscovered(tile, radius, cbp) / (path.nodes.size() + 1); //+1 prevents erratic jumps
+			const size_t distance = path.nodes.size() + 1; //+1 prevents erratic jumps
+			if ((float)hiddenTiles / distance <= bestValue) //even without barriers this tile can't be better
+				continue;
+
+			float ourValue = (float)howManyTilesWillBeDiscovered(tile, radius, cbp) / distance;
 
 			if (ourValue > bestValue) //avoid costly checks of tiles that don't reveal much
 			{
@@ -2671,30 +2773,20 @@ int3 VCAI::explorationDesperate(HeroPtr h)
 	auto sm = getCachedSectorMap(h);
 	int radius = h->getSightRadius();
 
-	std::vector<std::vector<int3> > tiles; //tiles[distance_to_fow]
-	tiles.resize(radius);
+	auto tiles = explorationMap.getTilesNearFog(radius); //tiles[distance_to_fow]
 
 	CCallback * cbp = cb.get();
 
-	foreach_tile_pos([&](const int3 &pos)
-	{
-		if(!cbp->isVisible(pos))
-			tiles[0].push_back(pos);
-	});
-
 	ui64 lowestDanger = -1;
 	int3 bestTile(-1,-1,-1);
 
 	for(int i = 1; i < radius; i++)
 	{
-		getVisibleNeighbours(tiles[i-1], tiles[i]);
-		vstd::removeDuplicates(tiles[i]);
-
 		for(const int3 &tile : tiles[i])
 		{
 			if (cbp->getTile(tile)->blocked) //does it shorten the time?
 				continue;
-			if (!howManyTilesWillBeDiscovered(tile, radius, cbp)) //avoid costly checks of tiles that don't reveal much
+			if (!explorationMap.hiddenTilesAround(tile, radius) || !howManyTilesWillBeDiscovered(tile, radius, cbp)) //avoid costly checks of tiles that don't reveal much
 				continue;
 
 			auto t = sm->firstTileToGet(h, tile);
@@ -2823,7 +2915,6 @@ void VCAI::lostHero(HeroPtr h)
 		vstd::erase_if_present(reservedObjs, obj); //unreserve all objects for that hero
 	}
 	vstd::erase_if_present(reservedHeroesMap, h);
-	vstd::erase_if_present(cachedSectorMaps, h);
 }
 
 void VCAI::answerQuery(QueryID queryID, int selection)
@@ -2892,14 +2983,9 @@ TResources VCAI::freeResources() const
 
 std::shared_ptr<SectorMap> VCAI::getCachedSectorMap(HeroPtr h)
 {
-	auto it = cachedSectorMaps.find(h);
-	if (it != cachedSectorMaps.end())
-		return it->second;
-	else
-	{
-		cachedSectorMaps[h] = std::make_shared<SectorMap>(h);
-		return cachedSectorMaps[h];
-	}
+	//sectors are shared by all heroes, paths of given hero are built when first needed
+	sectorMap->update();
+	return sectorMap;
 }
 
 AIStatus::AIStatus()
@@ -3057,13 +3143,9 @@ bool AIStatus::channelProbing()
 
 SectorMap::SectorMap()
 {
-	update();
-}
-
-SectorMap::SectorMap(HeroPtr h)
-{
-	update();
-	makeParentBFS(h->visitablePos());
+	valid = false;
+	version = 0;
+	nextSector = 3;
 }
 
 bool SectorMap::markIfBlocked(TSectorID &sec, crint3 pos, const TerrainTile *t)
@@ -3084,23 +3166,112 @@ bool SectorMap::markIfBlocked(TSectorID &sec, crint3 pos)
 
 void SectorMap::update()
 {
+	std::set<int3> tiles, objects;
+	{
+		boost::unique_lock<boost::mutex> lock(changesMx);
+		if(!valid || nextSector >= std::numeric_limits<TSectorID>::max())
+		{
+			lock.unlock();
+			rebuild();
+			return;
+		}
+		tiles.swap(changedTiles);
+		objects.swap(movedObjects);
+	}
+
+	CCallback * cbp = cb.get(); //optimization
+	if(!tiles.empty())
+	{
+		visibleTiles = cb->getAllVisibleTiles();
+
+		std::vector<int3> toExplore;
+		for(crint3 pos : tiles)
+		{
+			if(!cbp->isInTheMap(pos))
+				continue;
+
+			TSectorID &sec = retreiveTileN(sector, pos);
+			const TerrainTile *t = getTile(pos);
+			if(!t)
+			{
+				if(sec != NOT_VISIBLE) //tile got hidden
+				{
+					rebuild();
+					return;
+				}
+			}
+			else if(sec > NOT_AVAILABLE)
+			{
+				if(t->blocked && !t->visitable) //sectors can only be merged, not split
+				{
+					rebuild();
+					return;
+				}
+			}
+			else if(!markIfBlocked(sec, pos, t))
+			{
+				sec = NOT_CHECKED;
+				toExplore.push_back(pos);
+			}
+		}
+
+		for(crint3 pos : toExplore)
+		{
+			if(retreiveTileN(sector, pos) == NOT_CHECKED)
+				exploreNewSector(pos, nextSector++, cbp);
+		}
+		version++;
+	}
+
+	objects.insert(tiles.begin(), tiles.end());
+	for(crint3 pos : objects)
+	{
+		if(!cbp->isInTheMap(pos))
+			continue;
+
+		TSectorID sec = retreiveTile(pos);
+		if(sec > NOT_AVAILABLE)
+			infoOnSectors[sec].objsOutdated = true;
+		updateEmbarkmentPoint(pos); //free water may be taken by boat or hero and vice versa
+	}
+}
+
+void SectorMap::rebuild()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(changesMx);
+		changedTiles.clear();
+		movedObjects.clear();
+	}
+
 	visibleTiles = cb->getAllVisibleTiles();
 	auto shape = visibleTiles->shape();
 	sector.resize(boost::extents[shape[0]][shape[1]][shape[2]]);
 
 	clear();
-	int curSector = 3; //0 is invisible, 1 is not explored
+	nextSector = 3; //0 is invisible, 1 is not explored
+	{
+		//marked valid before exploring, so that invalidation reported meanwhile is not lost and next update builds again
+		boost::unique_lock<boost::mutex> lock(changesMx);
+		valid = true;
+	}
 
 	CCallback * cbp = cb.get(); //optimization
 	foreach_tile_pos([&](crint3 pos)
 	{
-		if(retreiveTile(pos) == NOT_CHECKED)
+		TSectorID &sec = retreiveTileN(sector, pos);
+		if(sec == NOT_CHECKED)
 		{
-			if(!markIfBlocked(retreiveTile(pos), pos))
-				exploreNewSector(pos, curSector++, cbp);
+			if(!markIfBlocked(sec, pos))
+				exploreNewSector(pos, nextSector++, cbp);
 		}
 	});
-	valid = true;
+}
+
+void SectorMap::invalidate()
+{
+	boost::unique_lock<boost::mutex> lock(changesMx);
+	valid = false;
 }
 
 SectorMap::TSectorID &SectorMap::retreiveTileN(SectorMap::TSectorArray &a, const int3 &pos)
@@ -3129,22 +3300,32 @@ void SectorMap::clear()
 		for (size_t y = 0; y < height; y++ )
 			for (size_t z = 0; z < depth; z++)
 				sector[x][y][z] = fow[x][y][z];
-	valid = false;
+
+	infoOnSectors.clear();
+	mergedInto.clear();
+	parentTrees.clear();
+	version++;
 }
 
 void SectorMap::exploreNewSector(crint3 pos, int num, CCallback * cbp)
 {
+	if(mergedInto.size() <= static_cast<size_t>(num))
+		mergedInto.resize(num + 1);
+	mergedInto[num] = num;
+
 	Sector &s = infoOnSectors[num];
 	s.id = num;
 	s.water = getTile(pos)->isWater();
+	s.objsOutdated = true;
 
+	std::set<TSectorID> connectedSectors; //explored before, joined by revealed or unblocked tiles
 	std::queue<int3> toVisit;
 	toVisit.push(pos);
 	while(!toVisit.empty())
 	{
 		int3 curPos = toVisit.front();
 		toVisit.pop();
-		TSectorID &sec = retreiveTile(curPos);
+		TSectorID &sec = retreiveTileN(sector, curPos);
 		if(sec == NOT_CHECKED)
 		{
 			const TerrainTile *t = getTile(curPos);
@@ -3156,30 +3337,80 @@ void SectorMap::exploreNewSector(crint3 pos, int num, CCallback * cbp)
 					s.tiles.push_back(curPos);
 					foreach_neighbour(cbp, curPos, [&](CCallback * cbp, crint3 neighPos)
 					{
-						if(retreiveTile(neighPos) == NOT_CHECKED)
-						{
+						const TSectorID neighSector = retreiveTile(neighPos);
+						if(neighSector == NOT_CHECKED)
 							toVisit.push(neighPos);
-							//parent[neighPos] = curPos;
-						}
+
 						const TerrainTile *nt = getTile(neighPos);
 						if(nt && nt->isWater() != s.water && canBeEmbarkmentPoint(nt, s.water))
-						{
 							s.embarkmentPoints.push_back(neighPos);
-						}
+						else if(neighSector > NOT_AVAILABLE && neighSector != num && nt->isWater() == s.water)
+							connectedSectors.insert(neighSector);
 					});
-
-					if(t->visitable)
-					{
-						auto obj = t->visitableObjects.front();
-						if(cb->getObj(obj->id, false)) // FIXME: we have to filter invisible objcts like events, but probably TerrainTile shouldn't be used in SectorMap at all
-							s.visitableObjs.push_back(obj);
-					}
 				}
 			}
 		}
 	}
 
 	vstd::removeDuplicates(s.embarkmentPoints);
+
+	for(TSectorID other : connectedSectors)
+		mergeSectors(num, other);
+}
+
+void SectorMap::mergeSectors(TSectorID a, TSectorID b)
+{
+	a = findRoot(a);
+	b = findRoot(b);
+	if(a == b)
+		return;
+
+	if(infoOnSectors[a].tiles.size() < infoOnSectors[b].tiles.size())
+		std::swap(a, b); //copy tiles of smaller sector
+
+	Sector &to = infoOnSectors[a];
+	Sector &from = infoOnSectors[b];
+	range::copy(from.tiles, std::back_inserter(to.tiles));
+	range::copy(from.embarkmentPoints, std::back_inserter(to.embarkmentPoints));
+	vstd::removeDuplicates(to.embarkmentPoints);
+	to.objsOutdated = true;
+
+	mergedInto[b] = a;
+	infoOnSectors.erase(b);
+}
+
+void SectorMap::updateEmbarkmentPoint(crint3 pos)
+{
+	const TerrainTile *t = getTile(pos);
+	if(!t)
+		return;
+
+	std::set<TSectorID> neighbourSectors;
+	foreach_neighbour(pos, [&](crint3 neighPos)
+	{
+		const TSectorID neighSector = retreiveTile(neighPos);
+		if(neighSector > NOT_AVAILABLE)
+			neighbourSectors.insert(neighSector);
+	});
+
+	for(TSectorID id : neighbourSectors)
+	{
+		Sector &s = infoOnSectors[id];
+		if(s.water == t->isWater())
+			continue;
+
+		auto &eps = s.embarkmentPoints;
+		const bool present = vstd::contains(eps, pos);
+		if(canBeEmbarkmentPoint(t, s.water))
+		{
+			if(!present)
+				eps.push_back(pos);
+		}
+		else if(present)
+		{
+			eps.erase(std::remove(eps.begin(), eps.end(), pos), eps.end());
+		}
+	}
 }
 
 void SectorMap::write(crstring fname)
@@ -3191,7 +3422,7 @@ void SectorMap::write(crstring fname)
 		{
 			for(int i = 0; i < cb->getMapSize().x; i++)
 			{
-				out << (int)sector[i][j][k] << '\t';
+				out << (int)retreiveTile(int3(i, j, k)) << '\t';
 			}
 			out << std::endl;
 		}
@@ -3494,6 +3725,7 @@ int3 SectorMap::findFirstVisitableTile (HeroPtr h, crint3 dst)
 {
 	int3 ret(-1,-1,-1);
 	int3 curtile = dst;
+	const ParentTree &tree = getParentTree(h);
 
 	while(curtile != h->visitablePos())
 	{
@@ -3510,11 +3742,11 @@ int3 SectorMap::findFirstVisitableTile (HeroPtr h, crint3 dst)
 		}
 		else
 		{
-			auto i = parent.find(curtile);
-			if(i != parent.end())
+			const int3 &next = tree.parent[tileIndex(curtile)];
+			if(next.valid())
 			{
-				assert(curtile != i->second);
-				curtile = i->second;
+				assert(curtile != next);
+				curtile = next;
 			}
 			else
 			{
@@ -3526,9 +3758,24 @@ int3 SectorMap::findFirstVisitableTile (HeroPtr h, crint3 dst)
 	return ret;
 }
 
-void SectorMap::makeParentBFS(crint3 source)
+const SectorMap::ParentTree & SectorMap::getParentTree(HeroPtr h)
+{
+	ParentTree &tree = parentTrees[h];
+	if(tree.version != version || tree.source != h->visitablePos())
+	{
+		tree.source = h->visitablePos();
+		tree.version = version;
+		makeParentBFS(tree);
+	}
+	return tree;
+}
+
+void SectorMap::makeParentBFS(ParentTree &tree)
 {
-	parent.clear();
+	const int3 source = tree.source;
+	auto shape = sector.shape();
+	tree.parent.assign(shape[0] * shape[1] * shape[2], int3(-1, -1, -1));
+	tree.parent[tileIndex(source)] = source; //source is visited
 
 	int mySector = retreiveTile(source);
 	std::queue<int3> toVisit;
@@ -3537,27 +3784,50 @@ void SectorMap::makeParentBFS(crint3 source)
 	{
 		int3 curPos = toVisit.front();
 		toVisit.pop();
-		TSectorID &sec = retreiveTile(curPos);
-		assert(sec == mySector); //consider only tiles from the same sector
-		UNUSED(sec);
+		assert(retreiveTile(curPos) == mySector); //consider only tiles from the same sector
 
 		foreach_neighbour(curPos, [&](crint3 neighPos)
 		{
-			if(retreiveTile(neighPos) == mySector && !vstd::contains(parent, neighPos))
+			int3 &parent = tree.parent[tileIndex(neighPos)];
+			if(!parent.valid() && retreiveTile(neighPos) == mySector)
 			{
 				if (cb->canMoveBetween(curPos, neighPos))
 				{
 					toVisit.push(neighPos);
-					parent[neighPos] = curPos;
+					parent = curPos;
 				}
 			}
 		});
 	}
 }
 
-SectorMap::TSectorID & SectorMap::retreiveTile(crint3 pos)
+SectorMap::TSectorID SectorMap::retreiveTile(crint3 pos)
+{
+	return findRoot(retreiveTileN(sector, pos));
+}
+
+SectorMap::TSectorID SectorMap::findRoot(TSectorID id)
+{
+	if(id <= NOT_AVAILABLE)
+		return id;
+
+	TSectorID root = id;
+	while(mergedInto[root] != root)
+		root = mergedInto[root];
+
+	while(mergedInto[id] != root) //path compression
+	{
+		TSectorID next = mergedInto[id];
+		mergedInto[id] = root;
+		id = next;
+	}
+	return root;
+}
+
+int SectorMap::tileIndex(crint3 pos) const
 {
-	return retreiveTileN(sector, pos);
+	auto shape = sector.shape();
+	return (pos.z * shape[1] + pos.y) * shape[0] + pos.x;
 }
 
 TerrainTile* SectorMap::getTile(crint3 pos) const
@@ -3569,16 +3839,36 @@ TerrainTile* SectorMap::getTile(crint3 pos) const
 
 std::vector<const CGObjectInstance *> SectorMap::getNearbyObjs(HeroPtr h, bool sectorsAround)
 {
-	const Sector *heroSector = &infoOnSectors[retreiveTile(h->visitablePos())];
+	Sector *heroSector = &infoOnSectors[retreiveTile(h->visitablePos())];
 	if(sectorsAround)
 	{
 		std::vector<const CGObjectInstance *> ret;
 		for(auto embarkPoint : heroSector->embarkmentPoints)
 		{
-			const Sector *embarkSector = &infoOnSectors[retreiveTile(embarkPoint)];
-			range::copy(embarkSector->visitableObjs, std::back_inserter(ret));
+			Sector *embarkSector = &infoOnSectors[retreiveTile(embarkPoint)];
+			range::copy(getVisitableObjs(*embarkSector), std::back_inserter(ret));
 		}
 		return ret;
 	}
-	return heroSector->visitableObjs;
+	return getVisitableObjs(*heroSector);
+}
+
+const std::vector<const CGObjectInstance *> & SectorMap::getVisitableObjs(Sector &s)
+{
+	if(s.objsOutdated)
+	{
+		s.visitableObjs.clear();
+		for(crint3 pos : s.tiles)
+		{
+			const TerrainTile *t = getTile(pos);
+			if(t->visitable)
+			{
+				auto obj = t->visitableObjects.front();
+				if(cb->getObj(obj->id, false)) // FIXME: we have to filter invisible objcts like events, but probably TerrainTile shouldn't be used in SectorMap at all
+					s.visitableObjs.push_back(obj);
+			}
+		}
+		s.objsOutdated = false;
+	}
+	return s.visitableObjs;
 }
@@ -82,40 +82,78 @@ struct SectorMap
 		std::vector<int3> embarkmentPoints; //tiles of other sectors onto which we can (dis)embark
 		std::vector<const CGObjectInstance *> visitableObjs;
 		bool water; //all tiles of sector are land or water
+		bool objsOutdated; //visitableObjs have to be collected again from tiles
 		Sector()
 		{
 			id = -1;
 			water = false;
+			objsOutdated = false;
+		}
+	};
+
+	//tree of shortest ways from hero position within its sector, tiles are indexed by tileIndex()
+	struct ParentTree
+	{
+		int3 source;
+		int version; //of sector map this tree was built for
+		std::vector<int3> parent; //invalid int3 if tile was not reached
+		ParentTree()
+		{
+			version = -1;
 		}
 	};
 
 	typedef unsigned short TSectorID; //smaller than int to allow -1 value. Max number of sectors 65K should be enough for any proper map.
 	typedef boost::multi_array<TSectorID, 3> TSectorArray;
 
-	bool valid; //some kind of lazy eval
-	std::map<int3, int3> parent;
-	TSectorArray sector;
-	//std::vector<std::vector<std::vector<unsigned char>>> pathfinderSector;
+	bool valid; //false if sectors have to be built from scratch, guarded by changesMx
+	int version; //incremented whenever sectors or blocking objects change
+	TSectorArray sector; //sector of tile as it was explored, sectors merged later are resolved via mergedInto
+	std::vector<TSectorID> mergedInto; //union-find over sector ids, sector id is its own root
+	int nextSector;
 
-	std::map<int, Sector> infoOnSectors;
+	std::map<int, Sector> infoOnSectors; //only root sectors
+	std::map<HeroPtr, ParentTree> parentTrees;
 	std::shared_ptr<boost::multi_array<TerrainTile*, 3>> visibleTiles;
 
+	boost::mutex changesMx; //guards changes below, they are reported by event handlers
+	std::set<int3> changedTiles; //revealed or (un)blocked by objects
+	std::set<int3> movedObjects; //only visitable objects on tile changed, eg. hero moved
+
 	SectorMap();
-	SectorMap(HeroPtr h);
-	void update();
+	void update(); //applies reported changes, sectors are only built from scratch if a tile got hidden or blocked
+	void rebuild();
 	void clear();
 	void exploreNewSector(crint3 pos, int num, CCallback * cbp);
+	void mergeSectors(TSectorID a, TSectorID b);
+	void updateEmbarkmentPoint(crint3 pos);
 	void write(crstring fname);
 
+	template <typename Container> void tilesChanged(const Container &tiles)
+	{
+		boost::unique_lock<boost::mutex> lock(changesMx);
+		changedTiles.insert(tiles.begin(), tiles.end());
+	}
+	template <typename Container> void objectsMoved(const Container &tiles)
+	{
+		boost::unique_lock<boost::mutex> lock(changesMx);
+		movedObjects.insert(tiles.begin(), tiles.end());
+	}
+	void invalidate();
+
 	bool markIfBlocked(TSectorID &sec, crint3 pos, const TerrainTile *t);
 	bool markIfBlocked(TSectorID &sec, crint3 pos);
-	TSectorID & retreiveTile(crint3 pos);
+	TSectorID retreiveTile(crint3 pos); //root sector of tile
+	TSectorID findRoot(TSectorID id);
 	TSectorID & retreiveTileN(TSectorArray &vectors, const int3 &pos);
 	const TSectorID & retreiveTileN(const TSectorArray &vectors, const int3 &pos);
 	TerrainTile* getTile(crint3 pos) const;
+	int tileIndex(crint3 pos) const;
 	std::vector<const CGObjectInstance *> getNearbyObjs(HeroPtr h, bool sectorsAround);
+	const std::vector<const CGObjectInstance *> & getVisitableObjs(Sector &s);
 
-	void makeParentBFS(crint3 source);
+	const ParentTree & getParentTree(HeroPtr h);
+	void makeParentBFS(ParentTree &tree);
 
 	int3 firstTileToGet(HeroPtr h, crint3 dst); //if h wants to reach tile dst, which tile he should visit to clear the way?
 	int3 findFirstVisitableTile(HeroPtr h, crint3 dst);
@@ -154,7 +192,13 @@ public:
 	std::set<const CGObjectInstance *> alreadyVisited;
 	std::set<const CGObjectInstance *> reservedObjs; //to be visited by specific hero
 
-	std::map <HeroPtr, std::shared_ptr<SectorMap>> cachedSectorMaps; //TODO: serialize? not necessary
+	std::shared_ptr<SectorMap> sectorMap; //shared by all heroes, kept up to date with revealed tiles and objects. TODO: serialize? not necessary
+	DangerHeatmap dangerHeatmap; //not serialized, rebuilt on demand
+	ExplorationMap explorationMap; //not serialized, rebuilt on demand
+
+	TimeBudget turnBudget; //not serialized, started anew every turn
+	Goals::SubgoalsCache subgoalsCache; //not serialized, valid only until next event
+	std::map<HeroPtr, si64> heroThinkingTime; //milliseconds spent on goals and wandering of hero in current turn
 
 	TResources saving;
 
@@ -255,6 +299,8 @@ public:
 	void makeTurn();
 
 	void makeTurnInternal();
+	bool outOfTurnTime(crstring skipped);
+	TimeBudget heroBudget(HeroPtr h);
 	void performTypicalActions();
 
 	void buildArmyIn(const CGTownInstance * t);
@@ -43,6 +43,13 @@ bool CCallback::moveHero(const CGHeroInstance *h, int3 dst, bool transit)
 	return true;
 }
 
+bool CCallback::moveHeroAlongPath(const CGHeroInstance *h, const std::vector<HeroPathStep> & steps, bool stopOnNewGuard)
+{
+	MoveHeroPath pack(steps, h->id, stopOnNewGuard);
+	sendRequest(&pack);
+	return true;
+}
+
 int CCallback::selectionMade(int selection, QueryID queryID)
 {
 	JsonNode reply(JsonNode::JsonType::DATA_INTEGER);
@@ -175,7 +182,7 @@ bool CCallback::buildBuilding(const CGTownInstance *town, BuildingID buildingID)
 int CBattleCallback::battleMakeAction(BattleAction* action)
 {
 	assert(action->actionType == Battle::HERO_SPELL);
-	MakeCustomAction mca(*action);
+	MakeCustomAction mca(*action, battleGetID());
 	sendRequest(&mca);
 	return 0;
 }
@@ -376,9 +383,8 @@ CBattleCallback::CBattleCallback(CGameState *GS, boost::optional<PlayerColor> Pl
 
 bool CBattleCallback::battleMakeTacticAction( BattleAction * action )
 {
-	assert(cl->gs->curB->tacticDistance);
-	MakeAction ma;
-	ma.ba = *action;
+	assert(battleTacticDist());
+	MakeAction ma(*action, battleGetID());
 	sendRequest(&ma);
 	return true;
 }
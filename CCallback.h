@@ -29,6 +29,7 @@ struct CPack;
 class IBattleEventsReceiver;
 class IGameEventsReceiver;
 struct ArtifactLocation;
+struct HeroPathStep;
 
 class IBattleCallback
 {
@@ -45,6 +46,7 @@ class IGameActionCallback
 public:
 	//hero
 	virtual bool moveHero(const CGHeroInstance *h, int3 dst, bool transit) =0; //dst must be free, neighbouring tile (this function can move hero only by one tile)
+	virtual bool moveHeroAlongPath(const CGHeroInstance *h, const std::vector<HeroPathStep> & steps, bool stopOnNewGuard) =0; //same as moveHero for every step, but with single request
 	virtual bool dismissHero(const CGHeroInstance * hero)=0; //dismisses given hero; true - successfuly, false - not successfuly
 	virtual void dig(const CGObjectInstance *hero)=0;
 	virtual void castSpell(const CGHeroInstance *hero, SpellID spellID, const int3 &pos = int3(-1, -1, -1))=0; //cast adventure map spell
@@ -119,6 +121,7 @@ public:
 
 //commands
 	bool moveHero(const CGHeroInstance *h, int3 dst, bool transit = false) override; //dst must be free, neighbouring tile (this function can move hero only by one tile)
+	bool moveHeroAlongPath(const CGHeroInstance *h, const std::vector<HeroPathStep> & steps, bool stopOnNewGuard) override;
 	bool teleportHero(const CGHeroInstance *who, const CGTownInstance *where);
 	int selectionMade(int selection, QueryID queryID) override;
 	int sendQueryReply(const JsonNode & reply, QueryID queryID) override;
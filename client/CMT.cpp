@@ -1166,6 +1166,7 @@ static bool recreateWindow(int w, int h, int bpp, bool fullscreen, int displayIn
 		logGlobal->error(SDL_GetError());
 		throw std::runtime_error("Unable to create screen texture");
 	}
+	GH.invalidateAll();
 
 	screen2 = CSDL_Ext::copySurface(screen);
 
@@ -1297,6 +1298,10 @@ static void handleEvent(SDL_Event & ev)
 		case SDL_WINDOWEVENT_RESTORED:
 			fullScreenChanged();
 			break;
+		case SDL_WINDOWEVENT_EXPOSED:
+		case SDL_WINDOWEVENT_SIZE_CHANGED:
+			GH.invalidateAll();
+			break;
 		}
 		return;
 	}
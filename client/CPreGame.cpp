@@ -54,6 +54,7 @@
 #include "widgets/TextControls.h"
 #include "windows/InfoWindows.h"
 #include "../lib/mapping/CMapService.h"
+#include "../lib/mapping/CMapInfoCache.h"
 #include "../lib/CRandomGenerator.h"
 #include "../lib/CondSh.h"
 
@@ -1117,76 +1118,45 @@ void SelectionTab::parseMaps(const std::unordered_set<ResourceID> &files)
 {
 	logGlobal->debug("Parsing %d maps", files.size());
 	allItems.clear();
-	for(auto & file : files)
-	{
-		try
-		{
-			CMapInfo mapInfo;
-			mapInfo.mapInit(file.getName());
 
-			// ignore unsupported map versions (e.g. WoG maps without WoG)
-			// but accept VCMI maps
-			if((mapInfo.mapHeader->version >= EMapFormat::VCMI) || (mapInfo.mapHeader->version <= CGI->modh->settings.data["textData"]["mapVersion"].Float()))
-				allItems.push_back(std::move(mapInfo));
-		}
-		catch(std::exception & e)
-		{
-			logGlobal->error("Map %s is invalid. Message: %s", file.getName(), e.what());
-		}
+	CMapInfoCache cache(VCMIDirs::get().userCachePath() / "mapIndex.dat");
+	for(auto & mapInfo : cache.getMaps(files))
+	{
+		// ignore unsupported map versions (e.g. WoG maps without WoG)
+		// but accept VCMI maps
+		if((mapInfo.mapHeader->version >= EMapFormat::VCMI) || (mapInfo.mapHeader->version <= CGI->modh->settings.data["textData"]["mapVersion"].Float()))
+			allItems.push_back(std::move(mapInfo));
 	}
+	cache.save();
 }
 
 void SelectionTab::parseGames(const std::unordered_set<ResourceID> &files, CMenuScreen::EGameMode gameMode)
 {
-	for(auto & file : files)
+	CMapInfoCache cache(VCMIDirs::get().userCachePath() / "mapIndex.dat");
+	for(auto & mapInfo : cache.getSaves(files))
 	{
-		try
-		{
-			CLoadFile lf(*CResourceHandler::get()->getResourceName(file), MINIMAL_SERIALIZATION_VERSION);
-			lf.checkMagicBytes(SAVEGAME_MAGIC);
-// 			ui8 sign[8];
-// 			lf >> sign;
-// 			if(std::memcmp(sign,"VCMISVG",7))
-// 			{
-// 				throw std::runtime_error("not a correct savefile!");
-// 			}
-
-			// Create the map info object
-			CMapInfo mapInfo;
-			mapInfo.mapHeader = make_unique<CMapHeader>();
-			mapInfo.scenarioOpts = nullptr;//to be created by serialiser
-			lf >> *(mapInfo.mapHeader.get()) >> mapInfo.scenarioOpts;
-			mapInfo.fileURI = file.getName();
-			mapInfo.countPlayers();
-			std::time_t time = boost::filesystem::last_write_time(*CResourceHandler::get()->getResourceName(file));
-			mapInfo.date = std::asctime(std::localtime(&time));
-
-			// Filter out other game modes
-			bool isCampaign = mapInfo.scenarioOpts->mode == StartInfo::CAMPAIGN;
-			bool isMultiplayer = mapInfo.actualHumanPlayers > 1;
-			switch(gameMode)
-			{
-			case CMenuScreen::SINGLE_PLAYER:
-				if(isMultiplayer || isCampaign)
-					mapInfo.mapHeader.reset();
-				break;
-			case CMenuScreen::SINGLE_CAMPAIGN:
-				if(!isCampaign)
-					mapInfo.mapHeader.reset();
-				break;
-			default:
-				if(!isMultiplayer)
-					mapInfo.mapHeader.reset();
-				break;
-			}
-
-			allItems.push_back(std::move(mapInfo));
-		}
-		catch(const std::exception & e)
+		// Filter out other game modes
+		bool isCampaign = mapInfo.scenarioOpts->mode == StartInfo::CAMPAIGN;
+		bool isMultiplayer = mapInfo.actualHumanPlayers > 1;
+		switch(gameMode)
 		{
-			logGlobal->error("Error: Failed to process %s: %s", file.getName(), e.what());
+		case CMenuScreen::SINGLE_PLAYER:
+			if(isMultiplayer || isCampaign)
+				mapInfo.mapHeader.reset();
+			break;
+		case CMenuScreen::SINGLE_CAMPAIGN:
+			if(!isCampaign)
+				mapInfo.mapHeader.reset();
+			break;
+		default:
+			if(!isMultiplayer)
+				mapInfo.mapHeader.reset();
+			break;
 		}
+
+		allItems.push_back(std::move(mapInfo));
 	}
+	cache.save();
 }
 
 void SelectionTab::parseCampaigns(const std::unordered_set<ResourceID> &files )
@@ -428,6 +428,7 @@ bool CVideoPlayer::openAndPlayVideo(std::string name, int x, int y, SDL_Surface
 	open(name, false, true, scale);
 	bool ret = playVideo(x, y, dst, stopOnKey);
 	close();
+	GH.invalidateAll(); //video frames were presented directly, bypassing screen
 	return ret;
 }
 
@@ -34,6 +34,7 @@
 #include "../lib/serializer/CTypeList.h"
 #include "../lib/serializer/Connection.h"
 #include "../lib/serializer/CLoadIntegrityValidator.h"
+#include "../lib/serializer/CSaveSnapshot.h"
 #ifndef VCMI_ANDROID
 #include "../lib/Interprocess.h"
 #endif
@@ -119,7 +120,8 @@ void CClient::init()
 		TLockGuard _(connectionHandlerMutex);
 		connectionHandler.reset();
 	}
-	pathInfo = nullptr;
+	pathInfo.clear();
+	backgroundSaver = make_unique<CBackgroundSaver>();
 	applier = new CApplier<CBaseForCLApply>();
 	registerTypesClientPacks1(*applier);
 	registerTypesClientPacks2(*applier);
@@ -146,17 +148,18 @@ CClient::~CClient(void)
 	delete applier;
 }
 
-void CClient::waitForMoveAndSend(PlayerColor color)
+void CClient::waitForMoveAndSend(PlayerColor color, BattleID battleID)
 {
 	try
 	{
 		setThreadName("CClient::waitForMoveAndSend");
 		assert(vstd::contains(battleints, color));
-		BattleAction ba = battleints[color]->activeStack(gs->curB->battleGetStackByID(gs->curB->activeStack, false));
+		const BattleInfo * battle = gs->getBattle(battleID);
+		BattleAction ba = battleints[color]->activeStack(battle->battleGetStackByID(battle->activeStack, false));
 		if(ba.actionType != Battle::CANCEL)
 		{
 			logNetwork->trace("Send battle action to server: %s", ba.toString());
-			MakeAction temp_action(ba);
+			MakeAction temp_action(ba, battleID);
 			sendRequest(&temp_action, color);
 		}
 	}
@@ -203,7 +206,7 @@ void CClient::run()
 
 void CClient::save(const std::string & fname)
 {
-	if(gs->curB)
+	if(gs->isBattleInProgress())
 	{
 		logNetwork->error("Game cannot be saved during battle!");
 		return;
@@ -298,7 +301,7 @@ void CClient::loadGame(const std::string & fname, const bool server, const std::
 		logNetwork->info("Loaded common part of save %d ms", tmh.getDiff());
 		const_cast<CGameInfo*>(CGI)->mh = new CMapHandler();
 		const_cast<CGameInfo*>(CGI)->mh->map = gs->map;
-		pathInfo = make_unique<CPathsInfo>(getMapSize());
+		pathInfo.clear();
 		CGI->mh->init();
 		logNetwork->info("Initing maphandler: %d ms", tmh.getDiff());
 	}
@@ -445,7 +448,7 @@ void CClient::newGame( CConnection *con, StartInfo *si )
 			logNetwork->info("Creating mapHandler: %d ms", tmh.getDiff());
 			CGI->mh->init();
 		}
-		pathInfo = make_unique<CPathsInfo>(getMapSize());
+		pathInfo.clear();
 		logNetwork->info("Initializing mapHandler (together): %d ms", tmh.getDiff());
 	}
 
@@ -810,14 +813,14 @@ void CClient::battleStarted(const BattleInfo * info)
 
 	if(info->tacticDistance && vstd::contains(battleints,info->sides[info->tacticsSide].color))
 	{
-		boost::thread(&CClient::commenceTacticPhaseForInt, this, battleints[info->sides[info->tacticsSide].color]);
+		boost::thread(&CClient::commenceTacticPhaseForInt, this, battleints[info->sides[info->tacticsSide].color], info->battleID);
 	}
 }
 
-void CClient::battleFinished()
+void CClient::battleFinished(const BattleInfo * info)
 {
 	stopAllBattleActions();
-	for(auto & side : gs->curB->sides)
+	for(auto & side : info->sides)
 		if(battleCallbacks.count(side.color))
 			battleCallbacks[side.color]->setBattle(nullptr);
 
@@ -845,15 +848,16 @@ PlayerColor CClient::getLocalPlayer() const
 	return getCurrentPlayer();
 }
 
-void CClient::commenceTacticPhaseForInt(std::shared_ptr<CBattleGameInterface> battleInt)
+void CClient::commenceTacticPhaseForInt(std::shared_ptr<CBattleGameInterface> battleInt, BattleID battleID)
 {
 	setThreadName("CClient::commenceTacticPhaseForInt");
 	try
 	{
-		battleInt->yourTacticPhase(gs->curB->tacticDistance);
-		if(gs && !!gs->curB && gs->curB->tacticDistance) //while awaiting for end of tactics phase, many things can happen (end of battle... or game)
+		battleInt->yourTacticPhase(gs->getBattle(battleID)->tacticDistance);
+		auto battle = gs ? gs->getBattle(battleID) : nullptr;
+		if(battle && battle->tacticDistance) //while awaiting for end of tactics phase, many things can happen (end of battle... or game)
 		{
-			MakeAction ma(BattleAction::makeEndOFTacticPhase(gs->curB->playerToSide(battleInt->playerID).get()));
+			MakeAction ma(BattleAction::makeEndOFTacticPhase(battle->playerToSide(battleInt->playerID).get()), battleID);
 			sendRequest(&ma, battleInt->playerID);
 		}
 	}
@@ -866,24 +870,37 @@ void CClient::commenceTacticPhaseForInt(std::shared_ptr<CBattleGameInterface> ba
 void CClient::invalidatePaths()
 {
 	// turn pathfinding info into invalid. It will be regenerated later
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	pathInfo->hero = nullptr;
+	boost::unique_lock<boost::mutex> lock(pathInfoMx);
+	for(auto & paths : pathInfo)
+	{
+		boost::unique_lock<boost::mutex> pathLock(paths.second->pathMx);
+		paths.second->hero = nullptr;
+	}
 }
 
 const CPathsInfo * CClient::getPathsInfo(const CGHeroInstance *h)
 {
 	assert(h);
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	if (pathInfo->hero != h)
+	CPathsInfo * paths = nullptr;
+	{
+		boost::unique_lock<boost::mutex> lock(pathInfoMx);
+		auto & ptr = pathInfo[h->tempOwner];
+		if (!ptr)
+			ptr = make_unique<CPathsInfo>(getMapSize());
+		paths = ptr.get();
+	}
+
+	boost::unique_lock<boost::mutex> pathLock(paths->pathMx);
+	if (paths->hero != h)
 	{
-		gs->calculatePaths(h, *pathInfo.get());
+		gs->calculatePaths(h, *paths);
 	}
-	return pathInfo.get();
+	return paths;
 }
 
 int CClient::sendRequest(const CPack *request, PlayerColor player)
 {
-	static ui32 requestCounter = 0;
+	static std::atomic<ui32> requestCounter(0); //AI players may send requests from several threads
 
 	ui32 requestID = requestCounter++;
 	logNetwork->trace("Sending a request \"%s\". It'll have an ID=%d.", typeid(*request).name(), requestID);
@@ -983,13 +1000,13 @@ std::string CClient::aiNameForPlayer(bool battleAI)
 	return goodAI;
 }
 
-void CClient::startPlayerBattleAction(PlayerColor color)
+void CClient::startPlayerBattleAction(PlayerColor color, BattleID battleID)
 {
 	stopPlayerBattleAction(color);
 
 	if(vstd::contains(battleints, color))
 	{
-		auto thread = std::make_shared<boost::thread>(std::bind(&CClient::waitForMoveAndSend, this, color));
+		auto thread = std::make_shared<boost::thread>(std::bind(&CClient::waitForMoveAndSend, this, color, battleID));
 		playerActionThreads[color] = thread;
 	}
 }
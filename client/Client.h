@@ -33,6 +33,7 @@ class CScriptingModule;
 struct CPathsInfo;
 class BinaryDeserializer;
 class BinarySerializer;
+class CBackgroundSaver;
 namespace boost { class thread; }
 
 /// structure to handle running server and connecting to it
@@ -122,7 +123,8 @@ public:
 /// Class which handles client - server logic
 class CClient : public IGameCallback
 {
-	std::unique_ptr<CPathsInfo> pathInfo;
+	std::map<PlayerColor, std::unique_ptr<CPathsInfo>> pathInfo; //one per player, AI players may make turns at the same time
+	boost::mutex pathInfoMx; //guards pathInfo map, paths themselves are guarded by their own mutex
 
 	std::map<PlayerColor, std::shared_ptr<boost::thread>> playerActionThreads;
 public:
@@ -145,6 +147,8 @@ public:
 
 	static ThreadSafeVector<int> waitingRequest;//FIXME: make this normal field (need to join all threads before client destruction)
 
+	std::unique_ptr<CBackgroundSaver> backgroundSaver; //writes client part of savegames, destroyed (and thus flushed) together with client
+
 
 	//void sendRequest(const CPackForServer *request, bool waitForRealization);
 	CClient(void);
@@ -242,7 +246,7 @@ public:
 
 	void handlePack( CPack * pack ); //applies the given pack and deletes it
 	void battleStarted(const BattleInfo * info);
-	void commenceTacticPhaseForInt(std::shared_ptr<CBattleGameInterface> battleInt); //will be called as separate thread
+	void commenceTacticPhaseForInt(std::shared_ptr<CBattleGameInterface> battleInt, BattleID battleID); //will be called as separate thread
 
 	void commitPackage(CPackForClient *pack) override;
 
@@ -253,12 +257,12 @@ public:
 
 	void serialize(BinarySerializer & h, const int version, const std::set<PlayerColor>& playerIDs);
 	void serialize(BinaryDeserializer & h, const int version, const std::set<PlayerColor>& playerIDs);
-	void battleFinished();
+	void battleFinished(const BattleInfo * info);
 
-    void startPlayerBattleAction(PlayerColor color);
+    void startPlayerBattleAction(PlayerColor color, BattleID battleID);
 
     void stopPlayerBattleAction(PlayerColor color);
     void stopAllBattleActions();
 private:
-	void waitForMoveAndSend(PlayerColor color);
+	void waitForMoveAndSend(PlayerColor color, BattleID battleID);
 };
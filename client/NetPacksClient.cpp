@@ -18,6 +18,7 @@
 #include "CGameInfo.h"
 #include "../lib/serializer/Connection.h"
 #include "../lib/serializer/BinarySerializer.h"
+#include "../lib/serializer/CSaveSnapshot.h"
 #include "../lib/CGeneralTextHandler.h"
 #include "../lib/CHeroHandler.h"
 #include "../lib/VCMI_Lib.h"
@@ -103,8 +104,8 @@
 
 
 #define BATTLE_INTERFACE_CALL_IF_PRESENT_FOR_BOTH_SIDES(function,...) 				\
-	CALL_ONLY_THAT_BATTLE_INTERFACE(GS(cl)->curB->sides[0].color, function, __VA_ARGS__)	\
-	CALL_ONLY_THAT_BATTLE_INTERFACE(GS(cl)->curB->sides[1].color, function, __VA_ARGS__)	\
+	CALL_ONLY_THAT_BATTLE_INTERFACE(GS(cl)->getBattle(battleID)->sides[0].color, function, __VA_ARGS__)	\
+	CALL_ONLY_THAT_BATTLE_INTERFACE(GS(cl)->getBattle(battleID)->sides[1].color, function, __VA_ARGS__)	\
 	if(settings["session"]["spectate"].Bool() && !settings["session"]["spectate-skip-battle"].Bool() && LOCPLINT->battleInt)	\
 	{																					\
 		CALL_ONLY_THAT_BATTLE_INTERFACE(PlayerColor::SPECTATOR, function, __VA_ARGS__)	\
@@ -604,7 +605,7 @@ void MapObjectSelectDialog::applyCl(CClient * cl)
 
 void BattleStart::applyFirstCl(CClient *cl)
 {
-	//Cannot use the usual macro because curB is not set yet
+	//Cannot use the usual macro because battle is not registered yet
 	CALL_ONLY_THAT_BATTLE_INTERFACE(info->sides[0].color, battleStartBefore, info->sides[0].armyObject, info->sides[1].armyObject,
 		info->tile, info->sides[0].hero, info->sides[1].hero);
 	CALL_ONLY_THAT_BATTLE_INTERFACE(info->sides[1].color, battleStartBefore, info->sides[0].armyObject, info->sides[1].armyObject,
@@ -635,20 +636,21 @@ void BattleSetActiveStack::applyCl(CClient *cl)
 	if(!askPlayerInterface)
 		return;
 
-	const CStack *activated = GS(cl)->curB->battleGetStackByID(stack);
+	const BattleInfo * battle = GS(cl)->getBattle(battleID);
+	const CStack *activated = battle->battleGetStackByID(stack);
 	PlayerColor playerToCall; //player that will move activated stack
 	if (activated->hasBonusOfType(Bonus::HYPNOTIZED))
 	{
-		playerToCall = (GS(cl)->curB->sides[0].color == activated->owner
-			? GS(cl)->curB->sides[1].color
-			: GS(cl)->curB->sides[0].color);
+		playerToCall = (battle->sides[0].color == activated->owner
+			? battle->sides[1].color
+			: battle->sides[0].color);
 	}
 	else
 	{
 		playerToCall = activated->owner;
 	}
 
-	cl->startPlayerBattleAction(playerToCall);
+	cl->startPlayerBattleAction(playerToCall, battleID);
 }
 
 void BattleTriggerEffect::applyCl(CClient * cl)
@@ -669,12 +671,12 @@ void BattleUpdateGateState::applyFirstCl(CClient * cl)
 void BattleResult::applyFirstCl(CClient *cl)
 {
 	BATTLE_INTERFACE_CALL_IF_PRESENT_FOR_BOTH_SIDES(battleEnd,this);
-	cl->battleFinished();
+	cl->battleFinished(GS(cl)->getBattle(battleID));
 }
 
 void BattleStackMoved::applyFirstCl(CClient *cl)
 {
-	const CStack * movedStack = GS(cl)->curB->battleGetStackByID(stack);
+	const CStack * movedStack = GS(cl)->getBattle(battleID)->battleGetStackByID(stack);
 	BATTLE_INTERFACE_CALL_IF_PRESENT_FOR_BOTH_SIDES(battleStackMoved,movedStack,tilesToMove,distance);
 }
 
@@ -763,7 +765,7 @@ void BattleStacksRemoved::applyFirstCl(CClient * cl)
 
 void BattleStackAdded::applyCl(CClient *cl)
 {
-	BATTLE_INTERFACE_CALL_IF_PRESENT_FOR_BOTH_SIDES(battleNewStackAppeared, GS(cl)->curB->stacks.back());
+	BATTLE_INTERFACE_CALL_IF_PRESENT_FOR_BOTH_SIDES(battleNewStackAppeared, GS(cl)->getBattle(battleID)->stacks.back());
 }
 
 CGameState* CPackForClient::GS(CClient *cl)
@@ -812,9 +814,11 @@ void SaveGame::applyCl(CClient *cl)
 
 	try
 	{
-		CSaveFile save(*CResourceHandler::get()->getResourceName(ResourceID(stem.to_string(), EResType::CLIENT_SAVEGAME)));
-		cl->saveCommonState(save);
-		save << *cl;
+		// only serialization has to be done while game is blocked, compression and writing happen in background
+		auto snapshot = make_unique<CSaveSnapshot>();
+		cl->saveCommonState(*snapshot);
+		*snapshot << *cl;
+		cl->backgroundSaver->save(std::move(snapshot), *CResourceHandler::get()->getResourceName(ResourceID(stem.to_string(), EResType::CLIENT_SAVEGAME)));
 	}
 	catch(std::exception &e)
 	{
@@ -99,6 +99,7 @@ public:
 
 	void horizontalFlip() override;
 	void verticalFlip() override;
+	SDL_Surface * toScreenFormat() const override;
 
 	void shiftPalette(int from, int howMany) override;
 
@@ -159,6 +160,7 @@ public:
 
 	void horizontalFlip() override;
 	void verticalFlip() override;
+	SDL_Surface * toScreenFormat() const override;
 
 	void shiftPalette(int from, int howMany) override;
 	void setBorderPallete(const BorderPallete & borderPallete) override;
@@ -1012,6 +1014,37 @@ void SDLImage::verticalFlip()
 	surf = flipped;
 }
 
+SDL_Surface * SDLImage::toScreenFormat() const
+{
+	if(screen->format->BytesPerPixel != 4 || !screen->format->Amask)
+		return nullptr;
+
+	SDL_Surface * ret = CSDL_Ext::newSurface(fullSize.x, fullSize.y, screen);
+	SDL_FillRect(ret, nullptr, 0); //borders are fully transparent
+
+	if(surf->format->palette)
+	{
+		// palette alpha is copied as it is instead of being blended, unlike in blit8bppAlphaTo24bpp
+		const SDL_Color * colors = surf->format->palette->colors;
+		for(int y = 0; y < surf->h; y++)
+		{
+			const ui8 * src = (const ui8 *)surf->pixels + y * surf->pitch;
+			ui32 * dst = (ui32 *)((ui8 *)ret->pixels + (y + margins.y) * ret->pitch) + margins.x;
+			for(int x = 0; x < surf->w; x++)
+			{
+				const SDL_Color & color = colors[src[x]];
+				dst[x] = SDL_MapRGBA(ret->format, color.r, color.g, color.b, color.a);
+			}
+		}
+	}
+	else
+	{
+		Rect dest(margins.x, margins.y, surf->w, surf->h);
+		SDL_UpperBlit(surf, nullptr, ret, &dest);
+	}
+	return ret;
+}
+
 void SDLImage::shiftPalette(int from, int howMany)
 {
 	//works with at most 16 colors, if needed more -> increase values
@@ -1298,6 +1331,11 @@ void CompImage::verticalFlip()
 	logAnim->error("%s is not implemented", BOOST_CURRENT_FUNCTION);
 }
 
+SDL_Surface * CompImage::toScreenFormat() const
+{
+	return nullptr; //RLE data can only be blended onto existing pixels
+}
+
 void CompImage::shiftPalette(int from, int howMany)
 {
 	logAnim->error("%s is not implemented", BOOST_CURRENT_FUNCTION);
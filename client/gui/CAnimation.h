@@ -56,6 +56,9 @@ public:
 	virtual void horizontalFlip() = 0;
 	virtual void verticalFlip() = 0;
 
+	//creates 32 bpp copy of whole image including borders, in screen format with per-pixel alpha; nullptr if not possible
+	virtual SDL_Surface * toScreenFormat() const = 0;
+
 	IImage();
 	virtual ~IImage() {};
 };
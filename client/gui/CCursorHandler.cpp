@@ -83,11 +83,13 @@ void CCursorHandler::drawWithScreenRestore()
 	{
 		dndObject->moveTo(Point(x - dndObject->pos.w/2, y - dndObject->pos.h/2));
 		dndObject->showAll(screen);
+		drawnArea = Rect(temp_rect1) | dndObject->pos;
 	}
 	else
 	{
 		currentCursor->moveTo(Point(x,y));
 		currentCursor->showAll(screen);
+		drawnArea = Rect(temp_rect1) | currentCursor->pos;
 	}
 }
 
@@ -219,11 +221,16 @@ void CCursorHandler::centerCursor()
 	SDL_EventState(SDL_MOUSEMOTION, SDL_ENABLE);
 }
 
-void CCursorHandler::render()
+bool CCursorHandler::render()
 {
+	//cursor drawn in previous frame is restored in uploaded pixels only if its area is checked again
+	GH.invalidate(drawnArea);
+	drawnArea = Rect();
 	drawWithScreenRestore();
-	CSDL_Ext::update(screen);
+	GH.invalidate(drawnArea);
+	bool changed = GH.updateScreenTexture();
 	drawRestored();
+	return changed;
 }
 
 CCursorHandler::CCursorHandler() = default;
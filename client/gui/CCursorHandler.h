@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include "Geometries.h"
+
 class CAnimImage;
 struct SDL_Surface;
 
@@ -35,6 +37,8 @@ class CCursorHandler final
 
 	bool showing;
 
+	Rect drawnArea; //part of screen covered by cursor in last frame
+
 	/// Draw cursor preserving original image below cursor
 	void drawWithScreenRestore();
 	/// Restore original image below cursor
@@ -61,7 +65,8 @@ public:
 	 */
 	void dragAndDropCursor (std::unique_ptr<CAnimImage> image);
 
-	void render();
+	/// Draws cursor and uploads changed parts of screen, returns false if nothing has changed since last frame
+	bool render();
 
 	void shiftPos( int &x, int &y );
 	void hide() { showing=0; };
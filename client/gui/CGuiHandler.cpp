@@ -171,6 +171,7 @@ void CGuiHandler::totalRedraw()
 	for(auto & elem : objsToBlit)
 		elem->showAll(screen2);
 	blitAt(screen2,0,0,screen);
+	invalidate(Rect(screen));
 }
 
 void CGuiHandler::updateTime()
@@ -405,7 +406,114 @@ void CGuiHandler::simpleRedraw()
 	if(objsToBlit.size() > 1)
 		blitAt(screen2,0,0,screen); //blit background
 	if(!objsToBlit.empty())
+	{
 		objsToBlit.back()->show(screen); //blit active interface/window
+
+		//background is restored from buffer which is only changed by total redraw, so only the window itself may differ
+		auto top = dynamic_cast<CIntObject *>(objsToBlit.back());
+		invalidate(top ? top->pos : Rect(screen));
+	}
+}
+
+bool CGuiHandler::updateScreenTexture()
+{
+	// screen is split into tiles, only tiles covered by invalidated areas are compared with uploaded pixels
+	// and runs of changed ones are uploaded - most frames change just the cursor or an animation
+	const int TILE_SIZE = 64;
+	const int bpp = screen->format->BytesPerPixel;
+	const size_t screenSize = screen->h * screen->pitch;
+	auto pixels = static_cast<const ui8 *>(screen->pixels);
+
+	if(uploadedScreen.size() != screenSize)
+	{
+		uploadedScreen.resize(screenSize);
+		fullUploadRequested = true;
+	}
+
+	if(fullUploadRequested)
+	{
+		std::memcpy(uploadedScreen.data(), pixels, screenSize);
+		CSDL_Ext::update(screen);
+		fullUploadRequested = false;
+		dirtyAreas.clear();
+		return true;
+	}
+
+	if(dirtyAreas.empty())
+		return false;
+
+	const int columns = (screen->w + TILE_SIZE - 1) / TILE_SIZE;
+	const int rows = (screen->h + TILE_SIZE - 1) / TILE_SIZE;
+	std::vector<bool> dirtyTiles(columns * rows, false);
+	for(const Rect & dirty : dirtyAreas)
+	{
+		const Rect area = dirty & Rect(screen);
+		if(area.w <= 0 || area.h <= 0)
+			continue;
+		for(int row = area.y / TILE_SIZE; row <= (area.y + area.h - 1) / TILE_SIZE; row++)
+			for(int column = area.x / TILE_SIZE; column <= (area.x + area.w - 1) / TILE_SIZE; column++)
+				dirtyTiles[row * columns + column] = true;
+	}
+	dirtyAreas.clear();
+
+	auto tileChanged = [&](int x, int y, int w, int h) -> bool
+	{
+		if(!dirtyTiles[(y / TILE_SIZE) * columns + x / TILE_SIZE])
+			return false;
+
+		for(int row = y; row < y + h; row++)
+		{
+			size_t offset = row * screen->pitch + x * bpp;
+			if(std::memcmp(pixels + offset, uploadedScreen.data() + offset, w * bpp))
+				return true;
+		}
+		return false;
+	};
+
+	bool changed = false;
+	for(int y = 0; y < screen->h; y += TILE_SIZE)
+	{
+		const int h = std::min(TILE_SIZE, screen->h - y);
+		int x = 0;
+		while(x < screen->w)
+		{
+			if(!tileChanged(x, y, std::min(TILE_SIZE, screen->w - x), h))
+			{
+				x += TILE_SIZE;
+				continue;
+			}
+
+			// neighbouring changed tiles are uploaded together
+			int end = x + TILE_SIZE;
+			while(end < screen->w && tileChanged(end, y, std::min(TILE_SIZE, screen->w - end), h))
+				end += TILE_SIZE;
+			vstd::amin(end, screen->w);
+
+			Rect area(x, y, end - x, h);
+			for(int row = y; row < y + h; row++)
+			{
+				size_t offset = row * screen->pitch + x * bpp;
+				std::memcpy(uploadedScreen.data() + offset, pixels + offset, area.w * bpp);
+			}
+			if(0 != SDL_UpdateTexture(screenTexture, &area, pixels + y * screen->pitch + x * bpp, screen->pitch))
+				logGlobal->error("%s SDL_UpdateTexture %s", __FUNCTION__, SDL_GetError());
+
+			changed = true;
+			x = end;
+		}
+	}
+	return changed;
+}
+
+void CGuiHandler::invalidate(const Rect & area)
+{
+	if(area.w > 0 && area.h > 0)
+		dirtyAreas.push_back(area);
+}
+
+void CGuiHandler::invalidateAll()
+{
+	fullUploadRequested = true;
 }
 
 void CGuiHandler::handleMoveInterested(const SDL_MouseMotionEvent & motion)
@@ -459,12 +567,13 @@ void CGuiHandler::renderFrame()
 		if (settings["general"]["showfps"].Bool())
 			drawFPSCounter();
 
-		// draw the mouse cursor and update the screen
-		CCS->curh->render();
-
-		SDL_RenderCopy(mainRenderer, screenTexture, nullptr, nullptr);
+		// draw the mouse cursor and update the screen, frames without any visible change are not presented at all
+		if(CCS->curh->render())
+		{
+			SDL_RenderCopy(mainRenderer, screenTexture, nullptr, nullptr);
 
-		SDL_RenderPresent(mainRenderer);
+			SDL_RenderPresent(mainRenderer);
+		}
 	}
 
 	mainFPSmng->framerateDelay(); // holds a constant FPS
@@ -472,7 +581,7 @@ void CGuiHandler::renderFrame()
 
 
 CGuiHandler::CGuiHandler()
-	: lastClick(-500, -500),lastClickTime(0), defActionsDef(0), captureChildren(false)
+	: fullUploadRequested(true), lastClick(-500, -500),lastClickTime(0), defActionsDef(0), captureChildren(false)
 {
 	continueEventHandling = true;
 	curInt = nullptr;
@@ -505,6 +614,7 @@ void CGuiHandler::drawFPSCounter()
 	SDL_FillRect(screen, &overlay, black);
 	std::string fps = boost::lexical_cast<std::string>(mainFPSmng->fps);
 	graphics->fonts[FONT_BIG]->renderTextLeft(screen, fps, yellow, Point(10, 10));
+	invalidate(overlay);
 }
 
 SDL_Keycode CGuiHandler::arrowToNum(SDL_Keycode key)
@@ -64,6 +64,10 @@ private:
 	               textInterested;
 
 
+	std::vector<ui8> uploadedScreen; //copy of screen pixels as they were last uploaded to screenTexture
+	std::vector<Rect> dirtyAreas; //parts of screen drawn since last upload, only these are compared with uploaded copy
+	bool fullUploadRequested;
+
 	void handleMouseButtonClick(CIntObjectList & interestedObjs, EIntObjMouseBtnType btn, bool isPressed);
 	void processLists(const ui16 activityFlag, std::function<void (std::list<CIntObject*> *)> cb);
 public:
@@ -92,6 +96,10 @@ public:
 	void totalRedraw(); //forces total redraw (using showAll), sets a flag, method gets called at the end of the rendering
 	void simpleRedraw(); //update only top interface and draw background from buffer, sets a flag, method gets called at the end of the rendering
 
+	bool updateScreenTexture(); //uploads changed parts of invalidated areas of screen to screenTexture, returns false if there was no change
+	void invalidate(const Rect & area); //area of screen was drawn to and has to be checked for changes in next upload
+	void invalidateAll(); //whole screen will be uploaded and presented in next frame, for cases when renderer may have lost its content
+
 	void popInt(IShowActivatable *top); //removes given interface from the top and activates next
 	void popIntTotally(IShowActivatable *top); //deactivates, deletes, removes given interface from the top and activates next
 	void pushInt(IShowActivatable *newInt); //deactivate old top interface, activates this one and pushes to the top
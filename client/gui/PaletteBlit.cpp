@@ -0,0 +1,211 @@
+/*
+ * PaletteBlit.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "PaletteBlit.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define VCMI_BLIT_SSE2
+	#include <emmintrin.h>
+
+	// AVX2 kernel is compiled regardless of compiler flags and used only if CPU supports it
+	#if defined(_MSC_VER)
+		#define VCMI_BLIT_AVX2
+		#define VCMI_TARGET_AVX2
+		#include <immintrin.h>
+		#include <intrin.h>
+	#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+		#define VCMI_BLIT_AVX2
+		#define VCMI_TARGET_AVX2 __attribute__((target("avx2")))
+		#include <immintrin.h>
+	#endif
+#endif
+
+namespace PaletteBlit
+{
+
+void blitRowScalar(ui32 * dst, const ui8 * src, const ui32 * palette, int width)
+{
+	for(int x = 0; x < width; x++)
+	{
+		const ui32 color = palette[src[x]];
+		const ui32 alpha = color >> 24;
+
+		if(alpha == 0)
+			continue;
+
+		if(alpha == 255)
+		{
+			dst[x] = color;
+			continue;
+		}
+
+		// d + ((s - d) * a >> 8) as computed by ColorPutter, rewritten without negative values
+		ui32 result = 0xFF000000;
+		for(int shift = 0; shift < 24; shift += 8)
+		{
+			const ui32 s = (color >> shift) & 0xFF;
+			const ui32 d = (dst[x] >> shift) & 0xFF;
+			result |= ((d * (256 - alpha) + s * alpha) >> 8) << shift;
+		}
+		dst[x] = result;
+	}
+}
+
+#ifdef VCMI_BLIT_SSE2
+
+static inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/// Blends 4 pixels, channels are widened to 16 bits where d * (256 - a) + s * a can't overflow
+static inline __m128i blendSSE2(__m128i s, __m128i d, __m128i alpha)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(256);
+
+	const __m128i alpha16 = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+	const __m128i alphaLo = _mm_unpacklo_epi32(alpha16, alpha16);
+	const __m128i alphaHi = _mm_unpackhi_epi32(alpha16, alpha16);
+
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, alphaLo)),
+							   _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), alphaLo));
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, alphaHi)),
+							   _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), alphaHi));
+
+	const __m128i blended = _mm_or_si128(_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)),
+										 _mm_set1_epi32(static_cast<int>(0xFF000000)));
+
+	const __m128i opaque = _mm_cmpeq_epi32(alpha, _mm_set1_epi32(255));
+	const __m128i transparent = _mm_cmpeq_epi32(alpha, zero);
+	return selectSSE2(transparent, d, selectSSE2(opaque, s, blended));
+}
+
+static void blitRowSSE2(ui32 * dst, const ui8 * src, const ui32 * palette, int width)
+{
+	int x = 0;
+	for(; x + 4 <= width; x += 4)
+	{
+		const __m128i s = _mm_setr_epi32(palette[src[x]], palette[src[x + 1]], palette[src[x + 2]], palette[src[x + 3]]);
+		const __m128i alpha = _mm_srli_epi32(s, 24);
+
+		// sprites consist mostly of fully transparent and fully opaque areas
+		const int transparent = _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128()));
+		if(transparent == 0xFFFF)
+			continue;
+
+		auto target = reinterpret_cast<__m128i *>(dst + x);
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_set1_epi32(255))) == 0xFFFF)
+			_mm_storeu_si128(target, s);
+		else
+			_mm_storeu_si128(target, blendSSE2(s, _mm_loadu_si128(target), alpha));
+	}
+	blitRowScalar(dst + x, src + x, palette, width - x);
+}
+
+#endif // VCMI_BLIT_SSE2
+
+#ifdef VCMI_BLIT_AVX2
+
+VCMI_TARGET_AVX2 static inline __m256i selectAVX2(__m256i mask, __m256i a, __m256i b)
+{
+	return _mm256_or_si256(_mm256_and_si256(mask, a), _mm256_andnot_si256(mask, b));
+}
+
+/// Same as blendSSE2 for 8 pixels, unpacking and packing work within 128-bit lanes so pixel order is preserved
+VCMI_TARGET_AVX2 static inline __m256i blendAVX2(__m256i s, __m256i d, __m256i alpha)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i full = _mm256_set1_epi16(256);
+
+	const __m256i alpha16 = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+	const __m256i alphaLo = _mm256_unpacklo_epi32(alpha16, alpha16);
+	const __m256i alphaHi = _mm256_unpackhi_epi32(alpha16, alpha16);
+
+	__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, alphaLo)),
+								  _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), alphaLo));
+	__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, alphaHi)),
+								  _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), alphaHi));
+
+	const __m256i blended = _mm256_or_si256(_mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)),
+											_mm256_set1_epi32(static_cast<int>(0xFF000000)));
+
+	const __m256i opaque = _mm256_cmpeq_epi32(alpha, _mm256_set1_epi32(255));
+	const __m256i transparent = _mm256_cmpeq_epi32(alpha, zero);
+	return selectAVX2(transparent, d, selectAVX2(opaque, s, blended));
+}
+
+VCMI_TARGET_AVX2 static void blitRowAVX2(ui32 * dst, const ui8 * src, const ui32 * palette, int width)
+{
+	int x = 0;
+	for(; x + 8 <= width; x += 8)
+	{
+		const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x)));
+		const __m256i s = _mm256_i32gather_epi32(reinterpret_cast<const int *>(palette), indices, 4);
+		const __m256i alpha = _mm256_srli_epi32(s, 24);
+
+		if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_setzero_si256())) == -1)
+			continue;
+
+		auto target = reinterpret_cast<__m256i *>(dst + x);
+		if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_set1_epi32(255))) == -1)
+			_mm256_storeu_si256(target, s);
+		else
+			_mm256_storeu_si256(target, blendAVX2(s, _mm256_loadu_si256(target), alpha));
+	}
+	blitRowSSE2(dst + x, src + x, palette, width - x);
+}
+
+static bool cpuSupportsAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7)
+		return false;
+
+	// AVX state has to be enabled by OS as well
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if(!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // VCMI_BLIT_AVX2
+
+std::vector<std::pair<std::string, TRowBlitter>> getAvailableRowBlitters()
+{
+	std::vector<std::pair<std::string, TRowBlitter>> ret;
+	ret.push_back(std::make_pair("scalar", &blitRowScalar));
+#ifdef VCMI_BLIT_SSE2
+	ret.push_back(std::make_pair("SSE2", &blitRowSSE2));
+#endif
+#ifdef VCMI_BLIT_AVX2
+	if(cpuSupportsAVX2())
+		ret.push_back(std::make_pair("AVX2", &blitRowAVX2));
+#endif
+	return ret;
+}
+
+TRowBlitter getRowBlitter()
+{
+	static const TRowBlitter best = getAvailableRowBlitters().back().second;
+	return best;
+}
+
+}
@@ -0,0 +1,34 @@
+/*
+ * PaletteBlit.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+/// Kernels drawing rows of 8 bpp paletted pixels onto 32 bpp pixels.
+/// Results are exactly the same as of ColorPutter<4, +1>::PutColorAlphaSwitch: fully transparent
+/// pixels are skipped, opaque ones are copied, others are blended and become opaque.
+/// Vectorized kernels are selected at runtime according to instruction sets supported by CPU.
+namespace PaletteBlit
+{
+	/// Palette entries are 32-bit words in the same layout as destination pixels
+	typedef void (*TRowBlitter)(ui32 * dst, const ui8 * src, const ui32 * palette, int width);
+
+	/// Converts color into palette entry, alpha is always stored in the highest byte
+	inline ui32 makePaletteEntry(ui8 r, ui8 g, ui8 b, ui8 a)
+	{
+		return (ui32(a) << 24) | (ui32(r) << 16) | (ui32(g) << 8) | ui32(b);
+	}
+
+	void blitRowScalar(ui32 * dst, const ui8 * src, const ui32 * palette, int width);
+
+	/// Fastest kernel supported by this CPU
+	TRowBlitter getRowBlitter();
+
+	/// All kernels supported by this CPU together with their names, from the slowest one
+	std::vector<std::pair<std::string, TRowBlitter>> getAvailableRowBlitters();
+}
@@ -10,6 +10,8 @@
 #include "StdInc.h"
 #include "SDL_Extensions.h"
 #include "SDL_Pixels.h"
+#include "PaletteBlit.h"
+#include "CGuiHandler.h"
 
 #include "../CGameInfo.h"
 #include "../CMessage.h"
@@ -25,8 +27,18 @@ const SDL_Color Colors::DEFAULT_KEY_COLOR = {0, 255, 255, 0};
 void SDL_UpdateRect(SDL_Surface *surface, int x, int y, int w, int h)
 {
 	Rect rect(x,y,w,h);
-	if(0 !=SDL_UpdateTexture(screenTexture, &rect, surface->pixels, surface->pitch))
-		logGlobal->error("%sSDL_UpdateTexture %s", __FUNCTION__, SDL_GetError());
+	if(surface == screen)
+	{
+		//uploaded through GUI handler, so that its copy of uploaded screen stays valid
+		GH.invalidate(rect);
+		GH.updateScreenTexture();
+	}
+	else
+	{
+		if(0 !=SDL_UpdateTexture(screenTexture, &rect, surface->pixels, surface->pitch))
+			logGlobal->error("%sSDL_UpdateTexture %s", __FUNCTION__, SDL_GetError());
+		GH.invalidateAll(); //texture holds pixels which are not on screen
+	}
 
 	SDL_RenderClear(mainRenderer);
 	if(0 != SDL_RenderCopy(mainRenderer, screenTexture, NULL, NULL))
@@ -301,15 +313,28 @@ int CSDL_Ext::blit8bppAlphaTo24bppT(const SDL_Surface * src, const SDL_Rect * sr
 			Uint8 *colory = (Uint8*)src->pixels + srcy*src->pitch + srcx;
 			Uint8 *py = (Uint8*)dst->pixels + dstRect->y*dst->pitch + dstRect->x*bpp;
 
-			for(int y=h; y; y--, colory+=src->pitch, py+=dst->pitch)
+			if(bpp == 4) //screen format, used by almost all blits - handled by vectorized kernels
 			{
-				Uint8 *color = colory;
-				Uint8 *p = py;
+				ui32 palette[256] = {0};
+				for(int i = 0; i < std::min(src->format->palette->ncolors, 256); i++)
+					palette[i] = PaletteBlit::makePaletteEntry(colors[i].r, colors[i].g, colors[i].b, colors[i].a);
 
-				for(int x = w; x; x--)
+				const PaletteBlit::TRowBlitter blitRow = PaletteBlit::getRowBlitter();
+				for(int y=h; y; y--, colory+=src->pitch, py+=dst->pitch)
+					blitRow(reinterpret_cast<ui32 *>(py), colory, palette, w);
+			}
+			else
+			{
+				for(int y=h; y; y--, colory+=src->pitch, py+=dst->pitch)
 				{
-					const SDL_Color &tbc = colors[*color++]; //color to blit
-					ColorPutter<bpp, +1>::PutColorAlphaSwitch(p, tbc.r, tbc.g, tbc.b, tbc.a);
+					Uint8 *color = colory;
+					Uint8 *p = py;
+
+					for(int x = w; x; x--)
+					{
+						const SDL_Color &tbc = colors[*color++]; //color to blit
+						ColorPutter<bpp, +1>::PutColorAlphaSwitch(p, tbc.r, tbc.g, tbc.b, tbc.a);
+					}
 				}
 			}
 			SDL_UnlockSurface(dst);
@@ -32,6 +32,204 @@
 
 #define ADVOPT (conf.go()->ac)
 
+/// Palette ranges of terrain and river types rotated by one color in every updateWater call
+struct PaletteCycle
+{
+	CMapHandler::TFlippedCache CMapHandler::* images;
+	int type; //index in images
+	std::vector<std::pair<ui32, ui32>> ranges; //first color and number of colors, shifted in this order
+};
+
+static const PaletteCycle PALETTE_CYCLES[] =
+{
+	{&CMapHandler::terrainImages, 7, {{246, 9}}}, //lava
+	{&CMapHandler::terrainImages, 8, {{229, 12}, {242, 14}}}, //water
+	{&CMapHandler::riverImages, 0, {{183, 12}, {195, 6}}}, //clear river
+	{&CMapHandler::riverImages, 2, {{228, 12}, {183, 6}, {240, 6}}}, //muddy river
+	{&CMapHandler::riverImages, 3, {{240, 9}}} //lava river
+};
+
+/// number of updateWater calls after which images of given type look the same again
+static ui32 getPaletteCycleLength(CMapHandler::TFlippedCache CMapHandler::* images, int type)
+{
+	ui32 length = 1;
+	for(auto & cycle : PALETTE_CYCLES)
+	{
+		if(cycle.images != images || cycle.type != type)
+			continue;
+
+		for(auto & range : cycle.ranges)
+		{
+			ui32 gcd = length, b = range.second;
+			while(b)
+			{
+				const ui32 rest = gcd % b;
+				gcd = b;
+				b = rest;
+			}
+			length = length / gcd * range.second;
+		}
+	}
+	return length;
+}
+
+/**
+ * Terrain, river and road frames converted to screen format, so that drawing a tile
+ * is a plain 32 bpp blit instead of a palette lookup for every pixel.
+ *
+ * Every type has its own sheet with one cell per view (row) and rotation (column).
+ * Types with animated palette have a sheet per phase of their color cycle, phases are
+ * converted on first use from current state of images. Cycles longer than MAX_PHASES
+ * (water) keep only the sheet of current phase.
+ */
+class CMapHandler::CTrueColorAtlas
+{
+	struct Sheet
+	{
+		std::vector<std::array<IImage *, 4>> frames; //[view, rotation], not owned
+		ui32 cycleLength;
+		int cellW, cellH;
+		std::map<ui32, SDL_Surface *> phases;
+	};
+
+	struct Location
+	{
+		Sheet * sheet;
+		int view;
+		int rotation;
+	};
+
+	//longest cycle kept whole, whole water cycle would take ~45 MB
+	static const ui32 MAX_PHASES = 12;
+
+	std::vector<std::unique_ptr<Sheet>> sheets;
+	std::unordered_map<const IImage *, Location> locations;
+
+	SDL_Surface * convert(const Sheet & sheet) const;
+	void freePhases(Sheet & sheet);
+public:
+	~CTrueColorAtlas();
+
+	/// adds all frames of given types, cycleLengths gives length of color cycle for each type
+	void addFrames(const TFlippedCache & images, const std::vector<ui32> & cycleLengths);
+	/// same as IImage::draw, returns false if image is not in atlas or can't be converted
+	bool draw(const IImage * image, ui32 phase, const SDL_Rect * src, SDL_Surface * target, const SDL_Rect * dest);
+};
+
+CMapHandler::CTrueColorAtlas::~CTrueColorAtlas()
+{
+	for(auto & sheet : sheets)
+		freePhases(*sheet);
+}
+
+void CMapHandler::CTrueColorAtlas::freePhases(Sheet & sheet)
+{
+	for(auto & phase : sheet.phases)
+		SDL_FreeSurface(phase.second);
+	sheet.phases.clear();
+}
+
+void CMapHandler::CTrueColorAtlas::addFrames(const TFlippedCache & images, const std::vector<ui32> & cycleLengths)
+{
+	for(size_t type = 0; type < images.size(); type++)
+	{
+		auto sheet = make_unique<Sheet>();
+		sheet->frames = images[type];
+		sheet->cycleLength = cycleLengths.at(type);
+		sheet->cellW = sheet->cellH = 0;
+
+		for(size_t view = 0; view < sheet->frames.size(); view++)
+		{
+			for(int rotation = 0; rotation < 4; rotation++)
+			{
+				const IImage * image = sheet->frames[view][rotation];
+				vstd::amax(sheet->cellW, image->width());
+				vstd::amax(sheet->cellH, image->height());
+				locations[image] = Location{sheet.get(), (int)view, rotation};
+			}
+		}
+		sheets.push_back(std::move(sheet));
+	}
+}
+
+SDL_Surface * CMapHandler::CTrueColorAtlas::convert(const Sheet & sheet) const
+{
+	SDL_Surface * ret = CSDL_Ext::newSurface(4 * sheet.cellW, sheet.frames.size() * sheet.cellH, screen);
+	SDL_FillRect(ret, nullptr, 0);
+	const ui32 amask = ret->format->Amask;
+	bool opaque = true;
+
+	for(size_t view = 0; view < sheet.frames.size(); view++)
+	{
+		for(int rotation = 0; rotation < 4; rotation++)
+		{
+			SDL_Surface * frame = sheet.frames[view][rotation]->toScreenFormat();
+			if(!frame)
+			{
+				SDL_FreeSurface(ret);
+				return nullptr;
+			}
+
+			const int w = std::min(frame->w, sheet.cellW);
+			for(int y = 0; y < std::min(frame->h, sheet.cellH); y++)
+			{
+				const ui32 * src = (const ui32 *)((const ui8 *)frame->pixels + y * frame->pitch);
+				ui32 * dst = (ui32 *)((ui8 *)ret->pixels + (view * sheet.cellH + y) * ret->pitch) + rotation * sheet.cellW;
+				memcpy(dst, src, w * 4);
+				for(int x = 0; x < w && opaque; x++)
+					opaque = (src[x] & amask) == amask;
+			}
+			opaque = opaque && frame->w >= sheet.cellW && frame->h >= sheet.cellH;
+			SDL_FreeSurface(frame);
+		}
+	}
+
+	// fully opaque sheets (most of terrain) are copied without blending
+	SDL_SetSurfaceBlendMode(ret, opaque ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+	return ret;
+}
+
+bool CMapHandler::CTrueColorAtlas::draw(const IImage * image, ui32 phase, const SDL_Rect * src, SDL_Surface * target, const SDL_Rect * dest)
+{
+	auto location = locations.find(image);
+	if(location == locations.end())
+		return false;
+
+	Sheet & sheet = *location->second.sheet;
+	phase %= sheet.cycleLength;
+
+	auto converted = sheet.phases.find(phase);
+	if(converted == sheet.phases.end())
+	{
+		// phases are shown in order, so in longer cycle a cached phase would be evicted before it comes again
+		if(sheet.cycleLength > MAX_PHASES)
+			freePhases(sheet);
+		converted = sheet.phases.insert(std::make_pair(phase, convert(sheet))).first;
+	}
+	if(!converted->second)
+		return false;
+
+	// source rect is relative to whole image, same as in IImage::draw
+	Rect sourceRect(0, 0, sheet.cellW, sheet.cellH);
+	Rect destRect(0, 0, sheet.cellW, sheet.cellH);
+	if(src)
+	{
+		sourceRect = Rect(*src) & sourceRect;
+		destRect.x = sourceRect.x - src->x;
+		destRect.y = sourceRect.y - src->y;
+	}
+	if(dest)
+	{
+		destRect.x += dest->x;
+		destRect.y += dest->y;
+	}
+	sourceRect.x += location->second.rotation * sheet.cellW;
+	sourceRect.y += location->second.view * sheet.cellH;
+
+	SDL_UpperBlit(converted->second, &sourceRect, target, &destRect);
+	return true;
+}
+
 static bool objectBlitOrderSorter(const TerrainTileObject & a, const TerrainTileObject & b)
 {
 	return CMapHandler::compareObjectBlitOrder(a.obj, b.obj);
@@ -216,6 +414,17 @@ void CMapHandler::initTerrainGraphics()
 	loadFlipped(3, roadAnimations, roadImages, ROAD_FILES);
 	loadFlipped(4, riverAnimations, riverImages, RIVER_FILES);
 
+	std::vector<ui32> terrainCycles(terrainImages.size(), 1), roadCycles(roadImages.size(), 1), riverCycles(riverImages.size(), 1);
+	for(size_t i = 0; i < terrainCycles.size(); i++)
+		terrainCycles[i] = getPaletteCycleLength(&CMapHandler::terrainImages, i);
+	for(size_t i = 0; i < riverCycles.size(); i++)
+		riverCycles[i] = getPaletteCycleLength(&CMapHandler::riverImages, i);
+
+	atlas = make_unique<CTrueColorAtlas>();
+	atlas->addFrames(terrainImages, terrainCycles);
+	atlas->addFrames(roadImages, roadCycles);
+	atlas->addFrames(riverImages, riverCycles);
+
 	// Create enough room for the whole map and its frame
 
 	ttiles.resize(sizes.x, frameW, frameW);
@@ -382,10 +591,86 @@ void CMapHandler::init()
 
 	prepareFOWDefs();
 	initTerrainGraphics();
+	initTerrainChunks();
 	initBorderGraphics();
 	logGlobal->info("\tPreparing FoW, terrain, roads, rivers, borders: %d ms", th.getDiff());
 	initObjectRects();
 	logGlobal->info("\tMaking object rects: %d ms", th.getDiff());
+
+	worldViewCacheThread = make_unique<boost::thread>(&CMapHandler::prepareWorldViewCache, this);
+}
+
+void CMapHandler::prepareWorldViewCache()
+{
+	// same as in CAdvMapInt::fworldViewScale*x, default zoom level first
+	static const std::vector<float> WORLD_VIEW_SCALES = { 0.36f, 0.22f, 0.5f };
+
+	std::vector<std::pair<EMapCacheType, const IImage *>> images;
+
+	auto addFlipped = [&images](EMapCacheType type, const TFlippedCache & cache)
+	{
+		for(auto & views : cache)
+			for(auto & rotations : views)
+				for(const IImage * image : rotations)
+					images.push_back(std::make_pair(type, image));
+	};
+
+	addFlipped(EMapCacheType::TERRAIN, terrainImages);
+	addFlipped(EMapCacheType::RIVERS, riverImages);
+	addFlipped(EMapCacheType::ROADS, roadImages);
+	for(const IImage * image : FoWfullHide)
+		images.push_back(std::make_pair(EMapCacheType::FOW, image));
+	for(const IImage * image : FoWpartialHide)
+		images.push_back(std::make_pair(EMapCacheType::FOW, image));
+	for(const IImage * image : egdeImages)
+		images.push_back(std::make_pair(EMapCacheType::FRAME, image));
+
+	CStopWatch timer;
+	for(float scale : WORLD_VIEW_SCALES)
+	{
+		for(auto & image : images)
+		{
+			boost::this_thread::interruption_point();
+
+			if(cache.contains(scale, image.first, image.second))
+				continue;
+
+			std::unique_ptr<IImage> scaled;
+			{
+				boost::unique_lock<boost::mutex> lock(terrainPaletteMx);
+				scaled = image.second->scaleFast(scale);
+			}
+			cache.add(scale, image.first, image.second, std::move(scaled));
+		}
+	}
+	logAnim->debug("World view cache: %d images scaled in %d ms", images.size() * WORLD_VIEW_SCALES.size(), timer.getDiff());
+}
+
+void CMapHandler::initTerrainChunks()
+{
+	terrainChunksX = (sizes.x + TERRAIN_CHUNK_SIZE - 1) / TERRAIN_CHUNK_SIZE;
+	terrainChunksY = (sizes.y + TERRAIN_CHUNK_SIZE - 1) / TERRAIN_CHUNK_SIZE;
+	terrainChunks.resize(terrainChunksX * terrainChunksY * sizes.z);
+}
+
+void CMapHandler::evictTerrainChunk()
+{
+	if(renderedTerrainChunks < MAX_TERRAIN_CHUNKS)
+		return;
+
+	TerrainChunk * oldest = nullptr;
+	for(auto & chunk : terrainChunks)
+	{
+		if(chunk.surface && (!oldest || chunk.lastUse < oldest->lastUse))
+			oldest = &chunk;
+	}
+
+	if(oldest)
+	{
+		SDL_FreeSurface(oldest->surface);
+		oldest->surface = nullptr;
+		renderedTerrainChunks--;
+	}
 }
 
 CMapHandler::CMapBlitter *CMapHandler::resolveBlitter(const MapDrawingInfo * info) const
@@ -400,6 +685,11 @@ CMapHandler::CMapBlitter *CMapHandler::resolveBlitter(const MapDrawingInfo * inf
 
 void CMapHandler::CMapNormalBlitter::drawElement(EMapCacheType cacheType, const IImage * source, SDL_Rect * sourceRect, SDL_Surface * targetSurf, SDL_Rect * destRect) const
 {
+	if(cacheType == EMapCacheType::TERRAIN || cacheType == EMapCacheType::RIVERS || cacheType == EMapCacheType::ROADS)
+	{
+		if(parent->atlas->draw(source, parent->waterPhase, sourceRect, targetSurf, destRect))
+			return;
+	}
 	source->draw(targetSurf, destRect, sourceRect);
 }
 
@@ -462,6 +752,78 @@ SDL_Rect CMapHandler::CMapNormalBlitter::clip(SDL_Surface * targetSurf) const
 	return prevClip;
 }
 
+bool CMapHandler::CMapNormalBlitter::drawTerrainLayer(SDL_Surface * targetSurf)
+{
+	// terrain is drawn for all tiles, hidden ones are covered by opaque fog of war later
+	const int chunkSize = TERRAIN_CHUNK_SIZE;
+	const int firstX = std::max(0, topTile.x) / chunkSize;
+	const int firstY = std::max(0, topTile.y) / chunkSize;
+	const int lastX = (std::min(parent->sizes.x, topTile.x + tileCount.x) - 1) / chunkSize;
+	const int lastY = (std::min(parent->sizes.y, topTile.y + tileCount.y) - 1) / chunkSize;
+
+	for(int chunkY = firstY; chunkY <= lastY; chunkY++)
+	{
+		for(int chunkX = firstX; chunkX <= lastX; chunkX++)
+		{
+			SDL_Surface * chunk = requestTerrainChunk(chunkX, chunkY);
+			Rect destRect(initPos.x + (chunkX * chunkSize - topTile.x) * tileSize, initPos.y + (chunkY * chunkSize - topTile.y) * tileSize, chunk->w, chunk->h);
+			SDL_UpperBlit(chunk, nullptr, targetSurf, &destRect);
+		}
+	}
+	return true;
+}
+
+SDL_Surface * CMapHandler::CMapNormalBlitter::requestTerrainChunk(int chunkX, int chunkY)
+{
+	TerrainChunk & chunk = parent->terrainChunks[(topTile.z * parent->terrainChunksY + chunkY) * parent->terrainChunksX + chunkX];
+	chunk.lastUse = ++parent->terrainChunkUses;
+
+	if(chunk.surface && (!chunk.animated || chunk.waterPhase == parent->waterPhase))
+		return chunk.surface;
+
+	const int3 firstTile(chunkX * TERRAIN_CHUNK_SIZE, chunkY * TERRAIN_CHUNK_SIZE, topTile.z);
+	const int chunkSize = TERRAIN_CHUNK_SIZE;
+	const int width = std::min(chunkSize, parent->sizes.x - firstTile.x);
+	const int height = std::min(chunkSize, parent->sizes.y - firstTile.y);
+
+	if(!chunk.surface)
+	{
+		parent->evictTerrainChunk();
+		chunk.surface = CSDL_Ext::newSurface(width * tileSize, height * tileSize, screen);
+		SDL_SetSurfaceBlendMode(chunk.surface, SDL_BLENDMODE_NONE);
+		parent->renderedTerrainChunks++;
+	}
+	SDL_FillRect(chunk.surface, nullptr, 0);
+
+	chunk.animated = false;
+	chunk.waterPhase = parent->waterPhase;
+
+	pos.z = firstTile.z;
+	for(pos.x = firstTile.x, realPos.x = 0; pos.x < firstTile.x + width; pos.x++, realPos.x += tileSize)
+	{
+		for(pos.y = firstTile.y, realPos.y = 0; pos.y < firstTile.y + height; pos.y++, realPos.y += tileSize)
+		{
+			realTileRect.x = realPos.x;
+			realTileRect.y = realPos.y;
+
+			const TerrainTile2 & tile = parent->ttiles[pos.x][pos.y][pos.z];
+			const TerrainTile & tinfo = parent->map->getTile(pos);
+			const TerrainTile * tinfoUpper = pos.y > 0 ? &parent->map->getTile(int3(pos.x, pos.y - 1, pos.z)) : nullptr;
+
+			drawTileTerrain(chunk.surface, tinfo, tile);
+			if (tinfo.riverType)
+				drawRiver(chunk.surface, tinfo);
+			drawRoad(chunk.surface, tinfo, tinfoUpper);
+
+			if(getPaletteCycleLength(&CMapHandler::terrainImages, tinfo.terType) > 1)
+				chunk.animated = true;
+			if(tinfo.riverType && getPaletteCycleLength(&CMapHandler::riverImages, tinfo.riverType - 1) > 1)
+				chunk.animated = true;
+		}
+	}
+	return chunk.surface;
+}
+
 CMapHandler::CMapNormalBlitter::CMapNormalBlitter(CMapHandler * parent)
 	: CMapBlitter(parent)
 {
@@ -846,6 +1208,8 @@ void CMapHandler::CMapBlitter::blit(SDL_Surface * targetSurf, const MapDrawingIn
 	init(info);
 	auto prevClip = clip(targetSurf);
 
+	const bool terrainDrawn = drawTerrainLayer(targetSurf);
+
 	pos = int3(0, 0, topTile.z);
 
 	for (realPos.x = initPos.x, pos.x = topTile.x; pos.x < topTile.x + tileCount.x; pos.x++, realPos.x += tileSize)
@@ -867,7 +1231,7 @@ void CMapHandler::CMapBlitter::blit(SDL_Surface * targetSurf, const MapDrawingIn
 			const TerrainTile & tinfo = parent->map->getTile(pos);
 			const TerrainTile * tinfoUpper = pos.y > 0 ? &parent->map->getTile(int3(pos.x, pos.y - 1, pos.z)) : nullptr;
 
-			if(isVisible || info->showAllTerrain)
+			if(!terrainDrawn && (isVisible || info->showAllTerrain))
 			{
 				drawTileTerrain(targetSurf, tinfo, tile);
 				if (tinfo.riverType)
@@ -1320,53 +1684,37 @@ bool CMapHandler::canStartHeroMovement()
 
 void CMapHandler::updateWater() //shift colors in palettes of water tiles
 {
-	for(auto & elem : terrainImages[7])
-	{
-		for(IImage * img : elem)
-			img->shiftPalette(246, 9);
-	}
+	boost::unique_lock<boost::mutex> lock(terrainPaletteMx);
+	waterPhase++;
 
-	for(auto & elem : terrainImages[8])
+	for(auto & cycle : PALETTE_CYCLES)
 	{
-		for(IImage * img : elem)
+		for(auto & elem : (this->*cycle.images)[cycle.type])
 		{
-			img->shiftPalette(229, 12);
-			img->shiftPalette(242, 14);
-		}
-	}
-
-	for(auto & elem : riverImages[0])
-	{
-		for(IImage * img : elem)
-		{
-			img->shiftPalette(183, 12);
-			img->shiftPalette(195, 6);
-		}
-	}
-
-	for(auto & elem : riverImages[2])
-	{
-		for(IImage * img : elem)
-		{
-			img->shiftPalette(228, 12);
-			img->shiftPalette(183, 6);
-			img->shiftPalette(240, 6);
+			for(IImage * img : elem)
+			{
+				for(auto & range : cycle.ranges)
+					img->shiftPalette(range.first, range.second);
+			}
 		}
 	}
-
-	for(auto & elem : riverImages[3])
-	{
-		for(IImage * img : elem)
-			img->shiftPalette(240, 9);
-	}
 }
 
 CMapHandler::~CMapHandler()
 {
+	if(worldViewCacheThread)
+	{
+		worldViewCacheThread->interrupt();
+		worldViewCacheThread->join();
+	}
+
 	delete normalBlitter;
 	delete worldViewBlitter;
 	delete puzzleViewBlitter;
 
+	for(auto & chunk : terrainChunks)
+		SDL_FreeSurface(chunk.surface);
+
 	for (auto & elem : fadeAnims)
 	{
 		delete elem.second.second;
@@ -1380,6 +1728,10 @@ CMapHandler::CMapHandler()
 	worldViewBlitter = new CMapWorldViewBlitter(this);
 	puzzleViewBlitter = new CMapPuzzleViewBlitter(this);
 	fadeAnimCounter = 0;
+	waterPhase = 0;
+	terrainChunksX = terrainChunksY = 0;
+	renderedTerrainChunks = 0;
+	terrainChunkUses = 0;
 	map = nullptr;
 	tilesW = tilesH = 0;
 	offsetX = offsetY = 0;
@@ -1422,39 +1774,125 @@ void CMapHandler::discardWorldViewCache()
 CMapHandler::CMapCache::CMapCache()
 {
 	worldViewCachedScale = 0;
+	usedMemory = 0;
+	redraws = 0;
+}
+
+int CMapHandler::CMapCache::scaleKey(float scale)
+{
+	return (int)round(scale * 1000);
 }
 
 void CMapHandler::CMapCache::discardWorldViewCache()
 {
-	for(auto & cache : data)
-		cache.clear();
+	boost::unique_lock<boost::mutex> lock(mx);
+	data.clear();
+	usedMemory = 0;
 	logAnim->debug("Discarded world view cache");
 }
 
 void CMapHandler::CMapCache::updateWorldViewScale(float scale)
 {
-	if (fabs(scale - worldViewCachedScale) > 0.001f)
-		discardWorldViewCache();
 	worldViewCachedScale = scale;
+	redraws++;
+	evict();
 }
 
-IImage * CMapHandler::CMapCache::requestWorldViewCacheOrCreate(CMapHandler::EMapCacheType type, const IImage * fullSurface)
+void CMapHandler::CMapCache::evict()
 {
-	intptr_t key = (intptr_t) fullSurface;
-	auto & cache = data[(ui8)type];
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(usedMemory <= MEMORY_BUDGET)
+		return;
 
-	auto iter = cache.find(key);
-	if(iter == cache.end())
+	struct Candidate
 	{
-		auto scaled = fullSurface->scaleFast(worldViewCachedScale);
-		IImage * ret = scaled.get();
-		cache[key] = std::move(scaled);
-		return ret;
+		ui32 lastUse;
+		std::unordered_map<intptr_t, Entry> * images;
+		intptr_t key;
+	};
+	std::vector<Candidate> candidates;
+
+	for(auto & scale : data)
+	{
+		for(auto & images : scale.second)
+		{
+			for(auto & image : images)
+			{
+				if(image.second.lastUse != redraws)
+					candidates.push_back(Candidate{image.second.lastUse, &images, image.first});
+			}
+		}
 	}
-	else
+
+	boost::sort(candidates, [](const Candidate & a, const Candidate & b)
 	{
-		return (*iter).second.get();
+		return a.lastUse < b.lastUse;
+	});
+
+	// free a bit more than needed, so that eviction does not happen on every redraw
+	size_t evicted = 0;
+	for(auto & candidate : candidates)
+	{
+		if(usedMemory <= MEMORY_BUDGET * 3 / 4)
+			break;
+		auto iter = candidate.images->find(candidate.key);
+		usedMemory -= iter->second.size;
+		candidate.images->erase(iter);
+		evicted++;
 	}
+	logAnim->debug("World view cache: evicted %d images", evicted);
+}
+
+void CMapHandler::CMapCache::insert(int scale, EMapCacheType type, intptr_t key, std::unique_ptr<IImage> scaled)
+{
+	Entry & entry = data[scale][(ui8)type][key];
+	usedMemory -= entry.image ? entry.size : 0;
+
+	entry.size = scaled ? scaled->width() * scaled->height() * 4 : 0;
+	entry.lastUse = 0;
+	entry.image = std::move(scaled);
+	usedMemory += entry.size;
+}
+
+IImage * CMapHandler::CMapCache::requestWorldViewCacheOrCreate(CMapHandler::EMapCacheType type, const IImage * fullSurface)
+{
+	intptr_t key = (intptr_t) fullSurface;
+	const int scale = scaleKey(worldViewCachedScale);
+
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		auto & cache = data[scale][(ui8)type];
+
+		auto iter = cache.find(key);
+		if(iter != cache.end())
+		{
+			iter->second.lastUse = redraws;
+			return iter->second.image.get();
+		}
+	}
+
+	// image was not scaled in advance, e.g. map object
+	auto scaled = fullSurface->scaleFast(worldViewCachedScale);
+	IImage * ret = scaled.get();
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	insert(scale, type, key, std::move(scaled));
+	data[scale][(ui8)type][key].lastUse = redraws;
+	return ret;
+}
+
+bool CMapHandler::CMapCache::contains(float scale, EMapCacheType type, const IImage * fullSurface)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	auto iter = data.find(scaleKey(scale));
+	return iter != data.end() && iter->second[(ui8)type].count((intptr_t)fullSurface);
+}
+
+void CMapHandler::CMapCache::add(float scale, EMapCacheType type, const IImage * fullSurface, std::unique_ptr<IImage> scaled)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(!data[scaleKey(scale)][(ui8)type].count((intptr_t)fullSurface))
+		insert(scaleKey(scale), type, (intptr_t)fullSurface, std::move(scaled));
 }
 
 bool CMapHandler::compareObjectBlitOrder(const CGObjectInstance * a, const CGObjectInstance * b)
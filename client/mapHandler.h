@@ -156,19 +156,41 @@ class CMapHandler
 		TERRAIN, OBJECTS, ROADS, RIVERS, FOW, HEROES, HERO_FLAGS, FRAME, AFTER_LAST
 	};
 
-	/// temporarily caches rescaled frames for map world view redrawing
+	/// caches rescaled frames for map world view redrawing, for all zoom levels at once and across world view toggles
 	class CMapCache
 	{
-		std::array< std::map<intptr_t, std::unique_ptr<IImage>>, (ui8)EMapCacheType::AFTER_LAST> data;
+		struct Entry
+		{
+			std::unique_ptr<IImage> image;
+			size_t size; //approximate memory taken by image, in bytes
+			ui32 lastUse; //number of redraw which used image for the last time
+		};
+		typedef std::array<std::unordered_map<intptr_t, Entry>, (ui8)EMapCacheType::AFTER_LAST> TScaleCache;
+
+		static const size_t MEMORY_BUDGET = 64 * 1024 * 1024;
+
+		boost::mutex mx; //guards data, images are also added by world view cache thread
+		std::map<int, TScaleCache> data; //[scale in thousandths][type][source image]
 		float worldViewCachedScale;
+		size_t usedMemory;
+		ui32 redraws;
+
+		static int scaleKey(float scale);
+		/// frees least recently used images until cache fits into its budget, images used in current redraw are kept
+		void evict();
+		void insert(int scale, EMapCacheType type, intptr_t key, std::unique_ptr<IImage> scaled);
 	public:
 		CMapCache();
 		/// destroys all cached data (frees surfaces)
 		void discardWorldViewCache();
-		/// updates scale and determines if currently cached data is still valid
+		/// starts new redraw with given scale, frees old images if cache is over its budget
 		void updateWorldViewScale(float scale);
 		/// asks for cached data; @returns cached data if found, new scaled surface otherwise, may return nullptr in case of scaling error
 		IImage * requestWorldViewCacheOrCreate(EMapCacheType type, const IImage * fullSurface);
+		/// @returns true if image is already cached for given scale
+		bool contains(float scale, EMapCacheType type, const IImage * fullSurface);
+		/// adds image scaled in advance, does nothing if it is already cached
+		void add(float scale, EMapCacheType type, const IImage * fullSurface, std::unique_ptr<IImage> scaled);
 	};
 
 	/// helper struct to pass around resolved bitmaps of an object; images can be nullptr if object doesn't have bitmap of that type
@@ -185,6 +207,17 @@ class CMapHandler
 		{}
 	};
 
+	/// terrain, rivers and roads of TERRAIN_CHUNK_SIZE x TERRAIN_CHUNK_SIZE tiles, rendered once and reused by normal blitter
+	struct TerrainChunk
+	{
+		SDL_Surface * surface; //nullptr if chunk was not rendered yet or was evicted
+		ui32 waterPhase; //value of CMapHandler::waterPhase surface was rendered with
+		bool animated; //chunk has tiles with animated palette and needs rendering on every water update
+		ui32 lastUse;
+
+		TerrainChunk() : surface(nullptr), waterPhase(0), animated(false), lastUse(0) {}
+	};
+
 	class CMapBlitter
 	{
 	protected:
@@ -212,6 +245,8 @@ class CMapHandler
 		virtual void drawRiver(SDL_Surface * targetSurf, const TerrainTile & tinfo) const;
 		/// draws a road segment on current tile
 		virtual void drawRoad(SDL_Surface * targetSurf, const TerrainTile & tinfo, const TerrainTile * tinfoUpper) const;
+		/// draws terrain, rivers and roads of whole viewport at once; @returns false if blitter draws them tile by tile instead
+		virtual bool drawTerrainLayer(SDL_Surface * targetSurf) { return false; }
 		/// draws all objects on current tile (higher-level logic, unlike other draw*** methods)
 		virtual void drawObjects(SDL_Surface * targetSurf, const TerrainTile2 & tile) const;
 		virtual void drawObject(SDL_Surface * targetSurf, const IImage * source, SDL_Rect * sourceRect, bool moving) const;
@@ -269,6 +304,9 @@ class CMapHandler
 		void drawTileOverlay(SDL_Surface * targetSurf,const TerrainTile2 & tile) const override {}
 		void init(const MapDrawingInfo * info) override;
 		SDL_Rect clip(SDL_Surface * targetSurf) const override;
+		bool drawTerrainLayer(SDL_Surface * targetSurf) override;
+		/// renders given chunk if it is not cached or its water animation is outdated
+		SDL_Surface * requestTerrainChunk(int chunkX, int chunkY);
 	public:
 		CMapNormalBlitter(CMapHandler * parent);
 		virtual ~CMapNormalBlitter(){}
@@ -300,6 +338,7 @@ class CMapHandler
 
 		void drawObjects(SDL_Surface * targetSurf, const TerrainTile2 & tile) const override;
 		void drawFow(SDL_Surface * targetSurf) const override {} // skipping FoW in puzzle view
+		bool drawTerrainLayer(SDL_Surface * targetSurf) override { return false; } // cached chunks ignore visibility, draw tile by tile
 		void postProcessing(SDL_Surface * targetSurf) const override;
 		bool canDrawObject(const CGObjectInstance * obj) const override;
 		bool canDrawCurrentTile() const override { return true; }
@@ -308,6 +347,23 @@ class CMapHandler
 	};
 
 	CMapCache cache;
+	std::unique_ptr<boost::thread> worldViewCacheThread;
+	boost::mutex terrainPaletteMx; //held by updateWater while shifting palettes, so that world view cache thread never scales half-shifted image
+	class CTrueColorAtlas;
+	std::unique_ptr<CTrueColorAtlas> atlas; //terrain, river and road frames in screen format, used by normal blitter
+	ui32 waterPhase; //number of palette shifts done by updateWater
+
+	static const int TERRAIN_CHUNK_SIZE = 8; //in tiles
+	static const size_t MAX_TERRAIN_CHUNKS = 256; //rendered chunks kept at once, 256 KB each
+	std::vector<TerrainChunk> terrainChunks; //[level][chunk y][chunk x]
+	int terrainChunksX, terrainChunksY;
+	size_t renderedTerrainChunks;
+	ui32 terrainChunkUses; //counter for least recently used eviction
+	void initTerrainChunks();
+	/// scales terrain, rivers, roads, fog of war and map edges for all world view zoom levels, runs in separate thread
+	void prepareWorldViewCache();
+	/// frees least recently used chunk if there are too many rendered
+	void evictTerrainChunk();
 	CMapBlitter * normalBlitter;
 	CMapBlitter * worldViewBlitter;
 	CMapBlitter * puzzleViewBlitter;
@@ -721,7 +721,6 @@ void CAdvMapInt::fshowOverview()
 void CAdvMapInt::fworldViewBack()
 {
 	changeMode(EAdvMapMode::NORMAL);
-	CGI->mh->discardWorldViewCache();
 
 	auto hero = curHero();
 	if (hero)
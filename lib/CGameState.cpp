@@ -693,7 +693,8 @@ CGameState::CGameState()
 CGameState::~CGameState()
 {
 	map.dellNull();
-	curB.dellNull();
+	for(auto & battle : currentBattles)
+		battle.second.dellNull();
 	//delete scenarioOps; //TODO: fix for loading ind delete
 	//delete initialOpts;
 	delete applierGs;
@@ -1812,9 +1813,7 @@ void CGameState::initVisitingAndGarrisonedHeroes()
 
 BFieldType CGameState::battleGetBattlefieldType(int3 tile, CRandomGenerator & rand)
 {
-	if(!tile.valid() && curB)
-		tile = curB->tile;
-	else if(!tile.valid() && !curB)
+	if(!tile.valid())
 		return BFieldType::NONE;
 
 	const TerrainTile &t = map->getTile(tile);
@@ -1856,7 +1855,12 @@ BFieldType CGameState::battleGetBattlefieldType(int3 tile, CRandomGenerator & ra
 	if(map->isCoastalTile(tile)) //coastal tile is always ground
 		return BFieldType::SAND_SHORE;
 
-	switch(t.terType)
+	return battleGetBattlefieldType(t.terType, rand);
+}
+
+BFieldType CGameState::battleGetBattlefieldType(ETerrainType terrain, CRandomGenerator & rand)
+{
+	switch(terrain)
 	{
 	case ETerrainType::DIRT:
 		return BFieldType(rand.nextInt(3, 5));
@@ -1966,6 +1970,58 @@ void CGameState::apply(CPack *pack)
 	applierGs->getApplier(typ)->applyOnGS(this,pack);
 }
 
+BattleInfo * CGameState::getBattle(BattleID battle)
+{
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	auto i = currentBattles.find(battle);
+	if(i == currentBattles.end())
+		return nullptr;
+	return i->second;
+}
+
+const BattleInfo * CGameState::getBattle(BattleID battle) const
+{
+	return const_cast<CGameState *>(this)->getBattle(battle);
+}
+
+BattleInfo * CGameState::getBattleOf(PlayerColor player)
+{
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	for(auto & battle : currentBattles)
+	{
+		for(auto & side : battle.second->sides)
+		{
+			if(side.color == player)
+				return battle.second;
+		}
+	}
+	return nullptr;
+}
+
+const BattleInfo * CGameState::getBattleOf(PlayerColor player) const
+{
+	return const_cast<CGameState *>(this)->getBattleOf(player);
+}
+
+void CGameState::addBattle(BattleInfo * battle)
+{
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	assert(!vstd::contains(currentBattles, battle->battleID));
+	currentBattles[battle->battleID] = battle;
+}
+
+void CGameState::removeBattle(BattleID battle)
+{
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	currentBattles.erase(battle);
+}
+
+bool CGameState::isBattleInProgress() const
+{
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	return !currentBattles.empty();
+}
+
 void CGameState::calculatePaths(const CGHeroInstance *hero, CPathsInfo &out)
 {
 	CPathfinder pathfinder(out, this, hero);
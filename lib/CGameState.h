@@ -156,7 +156,8 @@ public:
 
 	ConstTransitivePtr<StartInfo> scenarioOps, initialOpts; //second one is a copy of settings received from pregame (not randomized)
 	PlayerColor currentPlayer; //ID of player currently having turn
-	ConstTransitivePtr<BattleInfo> curB; //current battle
+	std::map<BattleID, ConstTransitivePtr<BattleInfo>> currentBattles; //all battles that are being fought right now, guarded by battlesMx
+	mutable boost::mutex battlesMx; //battles start and end on their own threads while others look them up
 	ui32 day; //total number of days in game
 	ConstTransitivePtr<CMap> map;
 	std::map<PlayerColor, PlayerState> players;
@@ -169,7 +170,15 @@ public:
 	void giveHeroArtifact(CGHeroInstance *h, ArtifactID aid);
 
 	void apply(CPack *pack);
+	BattleInfo * getBattle(BattleID battle); //nullptr if there is no such battle
+	const BattleInfo * getBattle(BattleID battle) const;
+	BattleInfo * getBattleOf(PlayerColor player); //battle in which given player takes part, nullptr if none
+	const BattleInfo * getBattleOf(PlayerColor player) const;
+	void addBattle(BattleInfo * battle);
+	void removeBattle(BattleID battle);
+	bool isBattleInProgress() const;
 	BFieldType battleGetBattlefieldType(int3 tile, CRandomGenerator & rand);
+	static BFieldType battleGetBattlefieldType(ETerrainType terrain, CRandomGenerator & rand); //battlefield of open terrain of given type
 	UpgradeInfo getUpgradeInfo(const CStackInstance &stack);
 	PlayerRelations::PlayerRelations getPlayerRelations(PlayerColor color1, PlayerColor color2);
 	bool checkForVisitableDir(const int3 & src, const int3 & dst) const; //check if src tile is visitable from dst tile
@@ -217,6 +217,19 @@ class QueryID : public BaseForID<QueryID, si32>
 	}
 };
 
+class BattleID : public BaseForID<BattleID, si32>
+{
+	INSTID_LIKE_CLASS_COMMON(BattleID, si32)
+
+	DLL_LINKAGE static const BattleID NONE;
+
+	BattleID & operator++()
+	{
+		++num;
+		return *this;
+	}
+};
+
 class ObjectInstanceID : public BaseForID<ObjectInstanceID, si32>
 {
 	INSTID_LIKE_CLASS_COMMON(ObjectInstanceID, si32)
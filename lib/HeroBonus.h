@@ -643,7 +643,7 @@ private:
 	static const bool cachingEnabled;
 	mutable BonusList cachedBonuses;
 	mutable int cachedLast;
-	static int treeChanged;
+	static std::atomic<int> treeChanged; //bumped by any thread changing tree, read by all others
 
 	// Setting a value to cachingStr before getting any bonuses caches the result for later requests.
 	// This string needs to be unique, that's why it has to be setted in the following manner:
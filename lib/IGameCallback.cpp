@@ -21,6 +21,7 @@
 #include "serializer/BinaryDeserializer.h"
 #include "serializer/BinarySerializer.h"
 #include "serializer/CLoadIntegrityValidator.h"
+#include "serializer/CSaveSnapshot.h"
 #include "rmg/CMapGenOptions.h"
 #include "mapping/CCampaignHandler.h"
 #include "mapObjects/CObjectClassesHandler.h"
@@ -189,6 +190,7 @@ void CPrivilagedInfoCallback::saveCommonState(Saver &out) const
 template DLL_LINKAGE void CPrivilagedInfoCallback::loadCommonState<CLoadIntegrityValidator>(CLoadIntegrityValidator&);
 template DLL_LINKAGE void CPrivilagedInfoCallback::loadCommonState<CLoadFile>(CLoadFile&);
 template DLL_LINKAGE void CPrivilagedInfoCallback::saveCommonState<CSaveFile>(CSaveFile&) const;
+template DLL_LINKAGE void CPrivilagedInfoCallback::saveCommonState<CSaveSnapshot>(CSaveSnapshot&) const;
 
 TerrainTile * CNonConstInfoCallback::getTile( int3 pos )
 {
@@ -177,17 +177,20 @@ struct PlayerCheated : public CPackForClient
 
 struct YourTurn : public CPackForClient
 {
-	YourTurn(){}
+	YourTurn() : joinsTurn(false){}
 	void applyCl(CClient *cl);
 	DLL_LINKAGE void applyGs(CGameState *gs);
 
 	PlayerColor player;
 	boost::optional<ui8> daysWithoutCastle;
+	bool joinsTurn; //player makes turn together with current player, which stays unchanged
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & player;
 		h & daysWithoutCastle;
+		if(version >= 781)
+			h & joinsTurn;
 	}
 };
 
@@ -1363,6 +1366,8 @@ struct BattleStart : public CPackForClient
 
 struct BattleNextRound : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleNextRound():round(0){};
 	void applyFirstCl(CClient *cl);
 	void applyCl(CClient *cl);
@@ -1371,12 +1376,15 @@ struct BattleNextRound : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & round;
 	}
 };
 
 struct BattleSetActiveStack : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleSetActiveStack()
 	{
 		stack = 0;
@@ -1391,6 +1399,7 @@ struct BattleSetActiveStack : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stack;
 		h & askPlayerInterface;
 	}
@@ -1400,6 +1409,8 @@ struct BattleResult : public CPackForClient
 {
 	enum EResult {NORMAL = 0, ESCAPE = 1, SURRENDER = 2};
 
+	BattleID battleID;
+
 	BattleResult()
 		: result(NORMAL), winner(2)
 	{
@@ -1417,6 +1428,7 @@ struct BattleResult : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & result;
 		h & winner;
 		h & casualties[0];
@@ -1428,6 +1440,8 @@ struct BattleResult : public CPackForClient
 
 struct BattleStackMoved : public CPackForClient
 {
+	BattleID battleID;
+
 	ui32 stack;
 	std::vector<BattleHex> tilesToMove;
 	ui8 distance, teleporting;
@@ -1438,6 +1452,7 @@ struct BattleStackMoved : public CPackForClient
 	void applyGs(CGameState *gs);
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stack;
 		h & tilesToMove;
 		h & distance;
@@ -1446,6 +1461,8 @@ struct BattleStackMoved : public CPackForClient
 
 struct StacksHealedOrResurrected : public CPackForClient
 {
+	BattleID battleID;
+
 	StacksHealedOrResurrected()
 		:lifeDrain(false), tentHealing(false), drainedFrom(0), cure(false)
 	{}
@@ -1461,6 +1478,7 @@ struct StacksHealedOrResurrected : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & healedStacks;
 		h & lifeDrain;
 		h & tentHealing;
@@ -1471,6 +1489,8 @@ struct StacksHealedOrResurrected : public CPackForClient
 
 struct BattleStackAttacked : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleStackAttacked():
 		stackAttacked(0), attackerID(0),
 		killedAmount(0), damageAmount(0),
@@ -1522,6 +1542,7 @@ struct BattleStackAttacked : public CPackForClient
 	}
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stackAttacked;
 		h & attackerID;
 		h & newHealth;
@@ -1540,6 +1561,8 @@ struct BattleStackAttacked : public CPackForClient
 
 struct BattleAttack : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleAttack()
 		: stackAttacking(0), flags(0), spellID(SpellID::NONE)
 	{};
@@ -1584,6 +1607,7 @@ struct BattleAttack : public CPackForClient
 	}
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & bsa;
 		h & stackAttacking;
 		h & flags;
@@ -1593,6 +1617,8 @@ struct BattleAttack : public CPackForClient
 
 struct StartAction : public CPackForClient
 {
+	BattleID battleID;
+
 	StartAction(){};
 	StartAction(const BattleAction &act){ba = act; };
 	void applyFirstCl(CClient *cl);
@@ -1601,22 +1627,28 @@ struct StartAction : public CPackForClient
 	BattleAction ba;
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & ba;
 	}
 };
 
 struct EndAction : public CPackForClient
 {
+	BattleID battleID;
+
 	EndAction(){};
 	void applyCl(CClient *cl);
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 	}
 };
 
 struct BattleSpellCast : public CPackForClient
 {
+	BattleID battleID;
+
 	///custom effect (resistance, reflection, etc)
 	struct CustomEffect
 	{
@@ -1657,6 +1689,7 @@ struct BattleSpellCast : public CPackForClient
 	std::vector<MetaString> battleLog;
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & side;
 		h & id;
 		h & skill;
@@ -1673,6 +1706,8 @@ struct BattleSpellCast : public CPackForClient
 
 struct SetStackEffect : public CPackForClient
 {
+	BattleID battleID;
+
 	SetStackEffect(){};
 	DLL_LINKAGE void applyGs(CGameState *gs);
 	void applyCl(CClient *cl);
@@ -1690,6 +1725,7 @@ struct SetStackEffect : public CPackForClient
 	std::vector<MetaString> battleLog;
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stacks;
 		h & effect;
 		h & uniqueBonuses;
@@ -1701,6 +1737,8 @@ struct SetStackEffect : public CPackForClient
 
 struct StacksInjured : public CPackForClient
 {
+	BattleID battleID;
+
 	StacksInjured(){}
 	DLL_LINKAGE void applyGs(CGameState *gs);
 	void applyCl(CClient *cl);
@@ -1708,12 +1746,15 @@ struct StacksInjured : public CPackForClient
 	std::vector<BattleStackAttacked> stacks;
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stacks;
 	}
 };
 
 struct BattleResultsApplied : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleResultsApplied(){}
 
 	PlayerColor player1, player2;
@@ -1721,6 +1762,7 @@ struct BattleResultsApplied : public CPackForClient
 	void applyCl(CClient *cl);
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & player1;
 		h & player2;
 	}
@@ -1728,6 +1770,8 @@ struct BattleResultsApplied : public CPackForClient
 
 struct ObstaclesRemoved : public CPackForClient
 {
+	BattleID battleID;
+
 	ObstaclesRemoved(){}
 
 	DLL_LINKAGE void applyGs(CGameState *gs);
@@ -1737,12 +1781,15 @@ struct ObstaclesRemoved : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & obstacles;
 	}
 };
 
 struct ELF_VISIBILITY CatapultAttack : public CPackForClient
 {
+	BattleID battleID;
+
 	struct AttackInfo
 	{
 		si16 destinationTile;
@@ -1771,6 +1818,7 @@ struct ELF_VISIBILITY CatapultAttack : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & attackedParts;
 		h & attacker;
 	}
@@ -1778,6 +1826,8 @@ struct ELF_VISIBILITY CatapultAttack : public CPackForClient
 
 struct BattleStacksRemoved : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleStacksRemoved(){}
 
 	DLL_LINKAGE void applyGs(CGameState *gs);
@@ -1787,12 +1837,15 @@ struct BattleStacksRemoved : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stackIDs;
 	}
 };
 
 struct BattleStackAdded : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleStackAdded()
 		: side(0), amount(0), pos(0), summoned(0), newStackID(0)
 	{};
@@ -1811,6 +1864,7 @@ struct BattleStackAdded : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & side;
 		h & creID;
 		h & amount;
@@ -1821,6 +1875,8 @@ struct BattleStackAdded : public CPackForClient
 
 struct BattleSetStackProperty : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleSetStackProperty()
 		: stackID(0), which(CASTS), val(0), absolute(0)
 	{};
@@ -1836,6 +1892,7 @@ struct BattleSetStackProperty : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stackID;
 		h & which;
 		h & val;
@@ -1846,6 +1903,8 @@ struct BattleSetStackProperty : public CPackForClient
 ///activated at the beginning of turn
 struct BattleTriggerEffect : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleTriggerEffect()
 		: stackID(0), effect(0), val(0), additionalInfo(0)
 	{};
@@ -1860,6 +1919,7 @@ struct BattleTriggerEffect : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & stackID;
 		h & effect;
 		h & val;
@@ -1869,6 +1929,8 @@ struct BattleTriggerEffect : public CPackForClient
 
 struct BattleObstaclePlaced : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleObstaclePlaced(){};
 
 	DLL_LINKAGE void applyGs(CGameState *gs); //effect
@@ -1878,12 +1940,15 @@ struct BattleObstaclePlaced : public CPackForClient
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & obstacle;
 	}
 };
 
 struct BattleUpdateGateState : public CPackForClient
 {
+	BattleID battleID;
+
 	BattleUpdateGateState():state(EGateState::NONE){};
 
 	void applyFirstCl(CClient *cl);
@@ -1893,6 +1958,7 @@ struct BattleUpdateGateState : public CPackForClient
 	EGateState state;
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & state;
 	}
 };
@@ -2021,6 +2087,38 @@ struct MoveHero : public CPackForServer
 	}
 };
 
+struct HeroPathStep
+{
+	HeroPathStep():transit(false){};
+	HeroPathStep(const int3 &Dest, bool Transit) : dest(Dest), transit(Transit) {};
+	int3 dest; //same format as in MoveHero
+	bool transit;
+
+	template <typename Handler> void serialize(Handler &h, const int version)
+	{
+		h & dest;
+		h & transit;
+	}
+};
+
+/// moves hero through several tiles at once, walking stops early when hero can't continue without player's decision
+struct MoveHeroPath : public CPackForServer
+{
+	MoveHeroPath():stopOnNewGuard(false){};
+	MoveHeroPath(const std::vector<HeroPathStep> &Steps, ObjectInstanceID HID, bool StopOnNewGuard) : steps(Steps), hid(HID), stopOnNewGuard(StopOnNewGuard) {};
+	std::vector<HeroPathStep> steps;
+	ObjectInstanceID hid;
+	bool stopOnNewGuard; //stop before tile guarded by monster which player did not see when path was sent
+
+	bool applyGh(CGameHandler *gh);
+	template <typename Handler> void serialize(Handler &h, const int version)
+	{
+		h & steps;
+		h & hid;
+		h & stopOnNewGuard;
+	}
+};
+
 struct CastleTeleportHero : public CPackForServer
 {
 	CastleTeleportHero():source(0){};
@@ -2285,26 +2383,32 @@ struct QueryReply : public CPackForServer
 struct MakeAction : public CPackForServer
 {
 	MakeAction(){};
-	MakeAction(const BattleAction &BA):ba(BA){};
+	MakeAction(const BattleAction &BA, BattleID BattleID):ba(BA),battleID(BattleID){};
 	BattleAction ba;
+	BattleID battleID; //player may be in several battles at once (neutral player)
 
 	bool applyGh(CGameHandler *gh);
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & ba;
+		if(version >= 782)
+			h & battleID;
 	}
 };
 
 struct MakeCustomAction : public CPackForServer
 {
 	MakeCustomAction(){};
-	MakeCustomAction(const BattleAction &BA):ba(BA){};
+	MakeCustomAction(const BattleAction &BA, BattleID BattleID):ba(BA),battleID(BattleID){};
 	BattleAction ba;
+	BattleID battleID;
 
 	bool applyGh(CGameHandler *gh);
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & ba;
+		if(version >= 782)
+			h & battleID;
 	}
 };
 
@@ -1226,21 +1226,23 @@ DLL_LINKAGE void CommanderLevelUp::applyGs (CGameState *gs)
 
 DLL_LINKAGE void BattleStart::applyGs(CGameState *gs)
 {
-	gs->curB = info;
-	gs->curB->localInit();
+	gs->addBattle(info);
+	info->localInit();
 }
 
 DLL_LINKAGE void BattleNextRound::applyGs(CGameState *gs)
 {
+	BattleInfo * battle = gs->getBattle(battleID);
+	battle->revision++;
 	for (int i = 0; i < 2; ++i)
 	{
-		gs->curB->sides[i].castSpellsCount = 0;
-		vstd::amax(--gs->curB->sides[i].enchanterCounter, 0);
+		battle->sides[i].castSpellsCount = 0;
+		vstd::amax(--battle->sides[i].enchanterCounter, 0);
 	}
 
-	gs->curB->round = round;
+	battle->round = round;
 
-	for(CStack *s : gs->curB->stacks)
+	for(CStack *s : battle->stacks)
 	{
 		s->state -= EBattleStackState::DEFENDING;
 		s->state -= EBattleStackState::WAITING;
@@ -1262,14 +1264,15 @@ DLL_LINKAGE void BattleNextRound::applyGs(CGameState *gs)
 		}
 	}
 
-	for(auto &obst : gs->curB->obstacles)
+	for(auto &obst : battle->obstacles)
 		obst->battleTurnPassed();
 }
 
 DLL_LINKAGE void BattleSetActiveStack::applyGs(CGameState *gs)
 {
-	gs->curB->activeStack = stack;
-	CStack *st = gs->curB->getStack(stack);
+	BattleInfo * battle = gs->getBattle(battleID);
+	battle->activeStack = stack;
+	CStack *st = battle->getStack(stack);
 
 	//remove bonuses that last until when stack gets new turn
 	st->popBonuses(Bonus::UntilGetsTurn);
@@ -1280,7 +1283,8 @@ DLL_LINKAGE void BattleSetActiveStack::applyGs(CGameState *gs)
 
 DLL_LINKAGE void BattleTriggerEffect::applyGs(CGameState *gs)
 {
-	CStack * st = gs->curB->getStack(stackID);
+	BattleInfo * battle = gs->getBattle(battleID);
+	CStack * st = battle->getStack(stackID);
 	assert(st);
 	switch(effect)
 	{
@@ -1319,18 +1323,25 @@ DLL_LINKAGE void BattleTriggerEffect::applyGs(CGameState *gs)
 
 DLL_LINKAGE void BattleObstaclePlaced::applyGs(CGameState *gs)
 {
-	gs->curB->obstacles.push_back(obstacle);
+	BattleInfo * battle = gs->getBattle(battleID);
+	battle->revision++;
+	battle->obstacles.push_back(obstacle);
 }
 
 DLL_LINKAGE void BattleUpdateGateState::applyGs(CGameState *gs)
 {
-	if(gs->curB)
-		gs->curB->si.gateState = state;
+	BattleInfo * battle = gs->getBattle(battleID);
+	if(battle)
+	{
+		battle->si.gateState = state;
+		battle->revision++;
+	}
 }
 
 void BattleResult::applyGs(CGameState *gs)
 {
-	for (CStack *s : gs->curB->stacks)
+	BattleInfo * battle = gs->getBattle(battleID);
+	for (CStack *s : battle->stacks)
 	{
 		if (s->base && s->base->armyObj && vstd::contains(s->state, EBattleStackState::SUMMONED))
 		{
@@ -1339,13 +1350,13 @@ void BattleResult::applyGs(CGameState *gs)
 			const_cast<CArmedInstance*>(s->base->armyObj)->eraseStack(s->slot);
 		}
 	}
-	for (auto & elem : gs->curB->stacks)
+	for (auto & elem : battle->stacks)
 		delete elem;
 
 
 	for(int i = 0; i < 2; ++i)
 	{
-		if(auto h = gs->curB->battleGetFightingHero(i))
+		if(auto h = battle->battleGetFightingHero(i))
 		{
 			h->popBonuses(Bonus::OneBattle); 	//remove any "until next battle" bonuses
 			if (h->commander && h->commander->alive)
@@ -1362,25 +1373,28 @@ void BattleResult::applyGs(CGameState *gs)
 	{
 		for(int i = 0; i < 2; i++)
 			if(exp[i])
-				gs->curB->battleGetArmyObject(i)->giveStackExp(exp[i]);
+				battle->battleGetArmyObject(i)->giveStackExp(exp[i]);
 
 		CBonusSystemNode::treeHasChanged();
 	}
 
 	for(int i = 0; i < 2; i++)
-		gs->curB->battleGetArmyObject(i)->battle = nullptr;
+		battle->battleGetArmyObject(i)->battle = nullptr;
 
-	gs->curB.dellNull();
+	gs->removeBattle(battleID);
+	delete battle;
 }
 
 void BattleStackMoved::applyGs(CGameState *gs)
 {
-	CStack *s = gs->curB->getStack(stack);
+	BattleInfo * battle = gs->getBattle(battleID);
+	battle->revision++;
+	CStack *s = battle->getStack(stack);
 	assert(s);
 	BattleHex dest = tilesToMove.back();
 
 	//if unit ended movement on quicksands that were created by enemy, that quicksand patch becomes visible for owner
-	for(auto &oi : gs->curB->obstacles)
+	for(auto &oi : battle->obstacles)
 	{
 		if(oi->obstacleType == CObstacleInstance::QUICKSAND
 		&& vstd::contains(oi->getAffectedTiles(), tilesToMove.back()))
@@ -1396,7 +1410,9 @@ void BattleStackMoved::applyGs(CGameState *gs)
 
 DLL_LINKAGE void BattleStackAttacked::applyGs(CGameState *gs)
 {
-	CStack * at = gs->curB->getStack(stackAttacked);
+	BattleInfo * battle = gs->getBattle(battleID);
+	battle->revision++;
+	CStack * at = battle->getStack(stackAttacked);
 	assert(at);
 	at->popBonuses(Bonus::UntilBeingAttacked);
 
@@ -1412,7 +1428,7 @@ DLL_LINKAGE void BattleStackAttacked::applyGs(CGameState *gs)
 		if(at->cloneID >= 0)
 		{
 			//remove clone as well
-			CStack * clone = gs->curB->getStack(at->cloneID);
+			CStack * clone = battle->getStack(at->cloneID);
 			if(clone)
 				clone->makeGhost();
 
@@ -1421,7 +1437,10 @@ DLL_LINKAGE void BattleStackAttacked::applyGs(CGameState *gs)
 	}
 	//life drain handling
 	for(auto & elem : healedStacks)
+	{
+		elem.battleID = battleID;
 		elem.applyGs(gs);
+	}
 
 	if(willRebirth())
 	{
@@ -1447,7 +1466,7 @@ DLL_LINKAGE void BattleStackAttacked::applyGs(CGameState *gs)
 		//"hide" killed creatures instead so we keep info about it
 		at->makeGhost();
 
-		for(CStack * s : gs->curB->stacks)
+		for(CStack * s : battle->stacks)
 		{
 			if(s->cloneID == at->ID)
 				s->cloneID = -1;
@@ -1461,7 +1480,8 @@ DLL_LINKAGE void BattleStackAttacked::applyGs(CGameState *gs)
 
 DLL_LINKAGE void BattleAttack::applyGs(CGameState * gs)
 {
-	CStack * attacker = gs->curB->getStack(stackAttacking);
+	BattleInfo * battle = gs->getBattle(battleID);
+	CStack * attacker = battle->getStack(stackAttacking);
 	assert(attacker);
 
 	if(counter())
@@ -1471,22 +1491,26 @@ DLL_LINKAGE void BattleAttack::applyGs(CGameState * gs)
 		attacker->shots.use();
 
 	for(BattleStackAttacked & stackAttacked : bsa)
+	{
+		stackAttacked.battleID = battleID;
 		stackAttacked.applyGs(gs);
+	}
 
 	attacker->popBonuses(Bonus::UntilAttack);
 }
 
 DLL_LINKAGE void StartAction::applyGs(CGameState *gs)
 {
-	CStack *st = gs->curB->getStack(ba.stackNumber);
+	BattleInfo * battle = gs->getBattle(battleID);
+	CStack *st = battle->getStack(ba.stackNumber);
 
 	if(ba.actionType == Battle::END_TACTIC_PHASE)
 	{
-		gs->curB->tacticDistance = 0;
+		battle->tacticDistance = 0;
 		return;
 	}
 
-	if(gs->curB->tacticDistance)
+	if(battle->tacticDistance)
 	{
 		// moves in tactics phase do not affect creature status
 		// (tactics stack queue is managed by client)
@@ -1499,7 +1523,7 @@ DLL_LINKAGE void StartAction::applyGs(CGameState *gs)
 	}
 	else
 	{
-		gs->curB->sides[ba.side].usedSpellsHistory.push_back(SpellID(ba.additionalInfo).toSpell());
+		battle->sides[ba.side].usedSpellsHistory.push_back(SpellID(ba.additionalInfo).toSpell());
 	}
 
 	switch(ba.actionType)
@@ -1527,11 +1551,13 @@ DLL_LINKAGE void StartAction::applyGs(CGameState *gs)
 
 DLL_LINKAGE void BattleSpellCast::applyGs(CGameState *gs)
 {
-	assert(gs->curB);
+	BattleInfo * battle = gs->getBattle(battleID);
+	assert(battle);
+	battle->revision++;
 
 	const CSpell * spell = SpellID(id).toSpell();
 
-	spell->applyBattle(gs->curB, this);
+	spell->applyBattle(battle, this);
 }
 
 void actualizeEffect(CStack * s, const Bonus & ef)
@@ -1558,6 +1584,7 @@ void actualizeEffect(CStack * s, const std::vector<Bonus> & ef)
 
 DLL_LINKAGE void SetStackEffect::applyGs(CGameState *gs)
 {
+	BattleInfo * battle = gs->getBattle(battleID);
 	if(effect.empty() && cumulativeEffects.empty())
 	{
 		logGlobal->error("Trying to apply SetStackEffect with no effects");
@@ -1583,7 +1610,7 @@ DLL_LINKAGE void SetStackEffect::applyGs(CGameState *gs)
 
 	for(ui32 id : stacks)
 	{
-		CStack *s = gs->curB->getStack(id);
+		CStack *s = battle->getStack(id);
 		if(s)
 		{
 			for(const Bonus & fromEffect : effect)
@@ -1597,7 +1624,7 @@ DLL_LINKAGE void SetStackEffect::applyGs(CGameState *gs)
 
 	for(auto & para : uniqueBonuses)
 	{
-		CStack *s = gs->curB->getStack(para.first);
+		CStack *s = battle->getStack(para.first);
 		if(s)
 			processEffect(s, para.second, false);
 		else
@@ -1606,7 +1633,7 @@ DLL_LINKAGE void SetStackEffect::applyGs(CGameState *gs)
 
 	for(auto & para : cumulativeUniqueBonuses)
 	{
-		CStack *s = gs->curB->getStack(para.first);
+		CStack *s = battle->getStack(para.first);
 		if(s)
 			processEffect(s, para.second, true);
 		else
@@ -1617,18 +1644,23 @@ DLL_LINKAGE void SetStackEffect::applyGs(CGameState *gs)
 DLL_LINKAGE void StacksInjured::applyGs(CGameState *gs)
 {
 	for(BattleStackAttacked stackAttacked : stacks)
+	{
+		stackAttacked.battleID = battleID;
 		stackAttacked.applyGs(gs);
+	}
 }
 
 DLL_LINKAGE void StacksHealedOrResurrected::applyGs(CGameState *gs)
 {
+	BattleInfo * battle = gs->getBattle(battleID);
+	battle->revision++;
 	for(auto & elem : healedStacks)
 	{
-		CStack * changedStack = gs->curB->getStack(elem.stackId, false);
+		CStack * changedStack = battle->getStack(elem.stackId, false);
 		assert(changedStack);
 
 		//checking if we resurrect a stack that is under a living stack
-		auto accessibility = gs->curB->getAccesibility();
+		auto accessibility = battle->getAccesibility();
 
 		if(!changedStack->alive() && !accessibility.accessible(changedStack->position, changedStack))
 		{
@@ -1686,15 +1718,17 @@ DLL_LINKAGE void StacksHealedOrResurrected::applyGs(CGameState *gs)
 
 DLL_LINKAGE void ObstaclesRemoved::applyGs(CGameState *gs)
 {
-	if(gs->curB) //if there is a battle
+	BattleInfo * battle = gs->getBattle(battleID);
+	if(battle) //if there is a battle
 	{
+		battle->revision++;
 		for(const si32 rem_obst :obstacles)
 		{
-			for(int i=0; i<gs->curB->obstacles.size(); ++i)
+			for(int i=0; i<battle->obstacles.size(); ++i)
 			{
-				if(gs->curB->obstacles[i]->uniqueID == rem_obst) //remove this obstacle
+				if(battle->obstacles[i]->uniqueID == rem_obst) //remove this obstacle
 				{
-					gs->curB->obstacles.erase(gs->curB->obstacles.begin() + i);
+					battle->obstacles.erase(battle->obstacles.begin() + i);
 					break;
 				}
 			}
@@ -1714,12 +1748,14 @@ DLL_LINKAGE CatapultAttack::~CatapultAttack()
 
 DLL_LINKAGE void CatapultAttack::applyGs(CGameState *gs)
 {
-	if(gs->curB && gs->curB->town && gs->curB->town->fortLevel() != CGTownInstance::NONE) //if there is a battle and it's a siege
+	BattleInfo * battle = gs->getBattle(battleID);
+	if(battle && battle->town && battle->town->fortLevel() != CGTownInstance::NONE) //if there is a battle and it's a siege
 	{
+		battle->revision++;
 		for(const auto &it :attackedParts)
 		{
-			gs->curB->si.wallState[it.attackedPart] =
-			        SiegeInfo::applyDamage(EWallState::EWallState(gs->curB->si.wallState[it.attackedPart]), it.damageDealt);
+			battle->si.wallState[it.attackedPart] =
+			        SiegeInfo::applyDamage(EWallState::EWallState(battle->si.wallState[it.attackedPart]), it.damageDealt);
 		}
 	}
 }
@@ -1746,18 +1782,20 @@ DLL_LINKAGE std::string CatapultAttack::toString() const
 
 DLL_LINKAGE void BattleStacksRemoved::applyGs(CGameState *gs)
 {
-	if(!gs->curB)
+	BattleInfo * battle = gs->getBattle(battleID);
+	if(!battle)
 		return;
 
+	battle->revision++;
 	while(!stackIDs.empty())
 	{
 		ui32 rem_stack = *stackIDs.begin();
 
-		for(int b=0; b<gs->curB->stacks.size(); ++b) //find it in vector of stacks
+		for(int b=0; b<battle->stacks.size(); ++b) //find it in vector of stacks
 		{
-			if(gs->curB->stacks[b]->ID == rem_stack) //if found
+			if(battle->stacks[b]->ID == rem_stack) //if found
 			{
-				CStack * toRemove = gs->curB->stacks[b];
+				CStack * toRemove = battle->stacks[b];
 
 				toRemove->state.erase(EBattleStackState::ALIVE);
 				toRemove->state.erase(EBattleStackState::GHOST_PENDING);
@@ -1773,7 +1811,7 @@ DLL_LINKAGE void BattleStacksRemoved::applyGs(CGameState *gs)
 				}
 
 				//cleanup remaining clone links if any
-				for(CStack * s : gs->curB->stacks)
+				for(CStack * s : battle->stacks)
 				{
 					if(s->cloneID == toRemove->ID)
 						s->cloneID = -1;
@@ -1789,6 +1827,8 @@ DLL_LINKAGE void BattleStacksRemoved::applyGs(CGameState *gs)
 
 DLL_LINKAGE void BattleStackAdded::applyGs(CGameState *gs)
 {
+	BattleInfo * battle = gs->getBattle(battleID);
+	battle->revision++;
 	newStackID = 0;
 	if(!BattleHex(pos).isValid())
 	{
@@ -1797,19 +1837,20 @@ DLL_LINKAGE void BattleStackAdded::applyGs(CGameState *gs)
 	}
 
 	CStackBasicDescriptor csbd(creID, amount);
-	CStack * addedStack = gs->curB->generateNewStack(csbd, side, SlotID::SUMMONED_SLOT_PLACEHOLDER, pos); //TODO: netpacks?
+	CStack * addedStack = battle->generateNewStack(csbd, side, SlotID::SUMMONED_SLOT_PLACEHOLDER, pos); //TODO: netpacks?
 	if(summoned)
 		addedStack->state.insert(EBattleStackState::SUMMONED);
 
-	addedStack->localInit(gs->curB.get());
-	gs->curB->stacks.push_back(addedStack);
+	addedStack->localInit(battle);
+	battle->stacks.push_back(addedStack);
 
 	newStackID = addedStack->ID;
 }
 
 DLL_LINKAGE void BattleSetStackProperty::applyGs(CGameState * gs)
 {
-	CStack * stack = gs->curB->getStack(stackID);
+	BattleInfo * battle = gs->getBattle(battleID);
+	CStack * stack = battle->getStack(stackID);
 	switch(which)
 	{
 		case CASTS:
@@ -1822,7 +1863,7 @@ DLL_LINKAGE void BattleSetStackProperty::applyGs(CGameState * gs)
 		}
 		case ENCHANTER_COUNTER:
 		{
-			auto & counter = gs->curB->sides[gs->curB->whatSide(stack->owner)].enchanterCounter;
+			auto & counter = battle->sides[battle->whatSide(stack->owner)].enchanterCounter;
 			if(absolute)
 				counter = val;
 			else
@@ -1859,7 +1900,8 @@ DLL_LINKAGE void PlayerCheated::applyGs(CGameState *gs)
 
 DLL_LINKAGE void YourTurn::applyGs(CGameState *gs)
 {
-	gs->currentPlayer = player;
+	if(!joinsTurn)
+		gs->currentPlayer = player;
 
 	auto & playerState = gs->players[player];
 	playerState.daysWithoutCastle = daysWithoutCastle;
@@ -20,8 +20,11 @@ bool AccessibilityInfo::accessible(BattleHex tile, const CStack * stack) const
 bool AccessibilityInfo::accessible(BattleHex tile, bool doubleWide, ui8 side) const
 {
 	// All hexes that stack would cover if standing on tile have to be accessible.
-	for(auto hex : CStack::getHexes(tile, doubleWide, side))
+	// Same hexes as CStack::getHexes, checked in place as this is called for every tile visited by BFS.
+	const BattleHex hexes[2] = {tile, side == BattleSide::ATTACKER ? tile - 1 : tile + 1};
+	for(int i = 0; i < (doubleWide ? 2 : 1); i++)
 	{
+		const BattleHex hex = hexes[i];
 		// If the hex is out of range then the tile isn't accessible
 		if(!hex.isValid())
 			return false;
@@ -35,3 +38,12 @@ bool AccessibilityInfo::accessible(BattleHex tile, bool doubleWide, ui8 side) co
 	}
 	return true;
 }
+
+TBattleHexMask AccessibilityInfo::accessibleMask(bool doubleWide, ui8 side) const
+{
+	TBattleHexMask ret;
+	for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+		if(accessible(hex, doubleWide, side))
+			ret.set(hex);
+	return ret;
+}
@@ -27,9 +27,11 @@ enum class EAccessibility
 
 
 typedef std::array<EAccessibility, GameConstants::BFIELD_SIZE> TAccessibilityArray;
+typedef std::bitset<GameConstants::BFIELD_SIZE> TBattleHexMask;
 
 struct DLL_LINKAGE AccessibilityInfo : TAccessibilityArray
 {
 	bool accessible(BattleHex tile, const CStack * stack) const; //checks for both tiles if stack is double wide
 	bool accessible(BattleHex tile, bool doubleWide, ui8 side) const; //checks for both tiles if stack is double wide
+	TBattleHexMask accessibleMask(bool doubleWide, ui8 side) const; //all tiles where stack of given shape and side can stand
 };
@@ -129,11 +129,44 @@ BattleHex BattleHex::operator+(BattleHex::EDir dir) const
 std::vector<BattleHex> BattleHex::neighbouringTiles() const
 {
 	std::vector<BattleHex> ret;
-	for(EDir dir = EDir(0); dir <= EDir(5); dir = EDir(dir+1))
-		checkAndPush(cloneInDirection(dir, false), ret);
+	if(isValid())
+	{
+		for(BattleHex neighbour : getNeighbouringTiles())
+			if(neighbour.isValid())
+				ret.push_back(neighbour);
+	}
+	else
+	{
+		for(EDir dir = EDir(0); dir <= EDir(5); dir = EDir(dir+1))
+			checkAndPush(cloneInDirection(dir, false), ret);
+	}
 	return ret;
 }
 
+const BattleHex::NeighbouringTiles & BattleHex::getNeighbouringTiles() const
+{
+	//battlefield never changes its shape so neighbours of all hexes are computed once
+	static const std::array<NeighbouringTiles, GameConstants::BFIELD_SIZE> neighbours = []()
+	{
+		std::array<NeighbouringTiles, GameConstants::BFIELD_SIZE> ret;
+		for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+		{
+			ret[hex].fill(BattleHex::INVALID);
+			size_t count = 0;
+			for(EDir dir = EDir(0); dir <= EDir(5); dir = EDir(dir+1))
+			{
+				BattleHex neighbour = BattleHex(hex).cloneInDirection(dir, false);
+				if(neighbour.isAvailable())
+					ret[hex][count++] = neighbour;
+			}
+		}
+		return ret;
+	}();
+
+	assert(isValid());
+	return neighbours[hex];
+}
+
 signed char BattleHex::mutualPosition(BattleHex hex1, BattleHex hex2)
 {
 	for(EDir dir = EDir(0); dir <= EDir(5); dir = EDir(dir+1))
@@ -25,6 +25,9 @@ typedef boost::optional<ui8> BattleSideOpt;
 // for battle stacks' positions
 struct DLL_LINKAGE BattleHex //TODO: decide if this should be changed to class for better code design
 {
+	//available neighbours in direction order, unused entries at the end are INVALID
+	typedef std::array<BattleHex, 6> NeighbouringTiles;
+
 	si16 hex;
 	static const si16 INVALID = -1;
 	enum EDir
@@ -57,6 +60,7 @@ struct DLL_LINKAGE BattleHex //TODO: decide if this should be changed to class f
 	BattleHex cloneInDirection(EDir dir, bool hasToBeValid = true) const;
 	BattleHex operator+(EDir dir) const;
 	std::vector<BattleHex> neighbouringTiles() const;
+	const NeighbouringTiles & getNeighbouringTiles() const; //precomputed, doesn't allocate; hex has to be valid
 	static signed char mutualPosition(BattleHex hex1, BattleHex hex2);
 	static char getDistance(BattleHex hex1, BattleHex hex2);
 	static void checkAndPush(BattleHex tile, std::vector<BattleHex> & ret);
@@ -675,6 +675,38 @@ ui8 BattleInfo::whatSide(PlayerColor player) const
 	return -1;
 }
 
+ReachabilityInfo BattleInfo::getCachedReachability(BattlePerspective::BattlePerspective viewer, const ReachabilityInfo::Parameters & params, const std::function<ReachabilityInfo()> & calculate) const
+{
+	//AI may ask for distances from many different positions, don't let cache grow without limit
+	static const size_t MAX_CACHED_REACHABILITIES = 512;
+
+	const auto key = std::make_pair(viewer, params);
+	ui32 calculatedRevision;
+	{
+		TLockGuard lock(reachabilityMx);
+		if(reachabilityRevision != revision || reachabilityCache.size() >= MAX_CACHED_REACHABILITIES)
+		{
+			reachabilityCache.clear();
+			reachabilityRevision = revision;
+		}
+
+		auto iter = reachabilityCache.find(key);
+		if(iter != reachabilityCache.end())
+			return iter->second;
+
+		calculatedRevision = revision;
+	}
+
+	//calculation itself is done without lock, other threads may query reachability for other stacks meanwhile
+	ReachabilityInfo ret = calculate();
+
+	TLockGuard lock(reachabilityMx);
+	if(reachabilityRevision == calculatedRevision && revision == calculatedRevision)
+		reachabilityCache[key] = ret;
+
+	return ret;
+}
+
 int BattleInfo::getIdForNewStack() const
 {
 	if(stacks.size())
@@ -730,7 +762,7 @@ CStack * BattleInfo::getStack(int stackID, bool onlyAlive)
 BattleInfo::BattleInfo()
 	: round(-1), activeStack(-1), selectedStack(-1), town(nullptr), tile(-1,-1,-1),
 	battlefieldType(BFieldType::NONE), terrainType(ETerrainType::WRONG),
-	tacticsSide(0), tacticDistance(0)
+	tacticsSide(0), tacticDistance(0), revision(0), reachabilityRevision(0)
 {
 	setBattle(this);
 	setNodeType(BATTLE);
@@ -20,6 +20,7 @@ class CStackBasicDescriptor;
 
 struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallback
 {
+	BattleID battleID; //identifies battle in CGameState, several battles may be fought at the same time
 	std::array<SideInBattle, 2> sides; //sides[0] - attacker, sides[1] - defender
 	si32 round, activeStack, selectedStack;
 	const CGTownInstance * town; //used during town siege, nullptr if this is not a siege (note that fortless town IS also a siege)
@@ -34,8 +35,11 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	ui8 tacticsSide; //which side is requested to play tactics phase
 	ui8 tacticDistance; //how many hexes we can go forward (1 = only hexes adjacent to margin line)
 
+	ui32 revision; //increased whenever stacks, obstacles or walls change, not serialized
+
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
+		h & battleID;
 		h & sides;
 		h & round;
 		h & activeStack;
@@ -87,8 +91,16 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	PlayerColor theOtherPlayer(PlayerColor player) const;
 	ui8 whatSide(PlayerColor player) const;
 
+	/// Returns reachability calculated for given viewer and parameters in current revision, calculates it only if there is none
+	ReachabilityInfo getCachedReachability(BattlePerspective::BattlePerspective viewer, const ReachabilityInfo::Parameters & params, const std::function<ReachabilityInfo()> & calculate) const;
+
 	static BattlefieldBI::BattlefieldBI battlefieldTypeToBI(BFieldType bfieldType); //converts above to ERM BI format
 	static int battlefieldTypeToTerrain(int bfieldType); //converts above to ERM BI format
+
+private:
+	mutable boost::mutex reachabilityMx;
+	mutable ui32 reachabilityRevision; //revision of cached reachabilities
+	mutable std::map<std::pair<BattlePerspective::BattlePerspective, ReachabilityInfo::Parameters>, ReachabilityInfo> reachabilityCache;
 };
 
 
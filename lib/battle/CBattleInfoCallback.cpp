@@ -881,10 +881,9 @@ AccessibilityInfo CBattleInfoCallback::getAccesibility() const
 	}
 
 	//special battlefields with logically unavailable tiles
-	std::vector<BattleHex> impassableHexes;
 	if(battleGetBattlefieldType().num == BFieldType::SHIP_TO_SHIP)
 	{
-		impassableHexes =
+		static const int impassableHexes[] =
 		{
 			6, 7, 8, 9,
 			24, 25, 26,
@@ -896,9 +895,9 @@ AccessibilityInfo CBattleInfoCallback::getAccesibility() const
 			159, 160, 161, 162, 163,
 			176, 177, 178, 179, 180
 		};
+		for(auto hex : impassableHexes)
+			ret[hex] = EAccessibility::UNAVAILABLE;
 	}
-	for(auto hex : impassableHexes)
-		ret[hex] = EAccessibility::UNAVAILABLE;
 
 	//gate -> should be before stacks
 	if(battleGetSiegeLevel() > 0)
@@ -986,34 +985,39 @@ ReachabilityInfo CBattleInfoCallback::makeBFS(const AccessibilityInfo &accessibi
 	if(!params.startPosition.isValid()) //if got call for arrow turrets
 		return ret;
 
-	const std::set<BattleHex> quicksands = getStoppers(params.perspective);
-	//const bool twoHexCreature = params.doubleWide;
+	TBattleHexMask quicksands;
+	for(auto hex : getStoppers(params.perspective))
+		quicksands.set(hex);
+
+	const TBattleHexMask accessible = accessibility.accessibleMask(params.doubleWide, params.side);
 
-	std::queue<BattleHex> hexq; //bfs queue
+	//bfs queue; every hex gets its final distance when first reached, so it is enqueued at most once
+	std::array<BattleHex, GameConstants::BFIELD_SIZE> hexq;
+	size_t queueBegin = 0, queueEnd = 0;
 
 	//first element
-	hexq.push(params.startPosition);
+	hexq[queueEnd++] = params.startPosition;
 	ret.distances[params.startPosition] = 0;
 
-	while(!hexq.empty()) //bfs loop
+	while(queueBegin != queueEnd) //bfs loop
 	{
-		const BattleHex curHex = hexq.front();
-		hexq.pop();
+		const BattleHex curHex = hexq[queueBegin++];
 
 		//walking stack can't step past the quicksands
 		//TODO what if second hex of two-hex creature enters quicksand
-		if(curHex != params.startPosition && vstd::contains(quicksands, curHex))
+		if(curHex != params.startPosition && quicksands.test(curHex))
 			continue;
 
 		const int costToNeighbour = ret.distances[curHex] + 1;
-		for(BattleHex neighbour : curHex.neighbouringTiles())
+		for(BattleHex neighbour : curHex.getNeighbouringTiles())
 		{
-			const bool accessible = accessibility.accessible(neighbour, params.doubleWide, params.side);
-			const int costFoundSoFar = ret.distances[neighbour];
+			if(!neighbour.isValid())
+				break;
 
-			if(accessible && costToNeighbour < costFoundSoFar)
+			if(accessible.test(neighbour) && costToNeighbour < ret.distances[neighbour])
 			{
-				hexq.push(neighbour);
+				assert(queueEnd < hexq.size());
+				hexq[queueEnd++] = neighbour;
 				ret.distances[neighbour] = costToNeighbour;
 				ret.predecessors[neighbour] = curHex;
 			}
@@ -1119,10 +1123,19 @@ ReachabilityInfo CBattleInfoCallback::getReachability(const CStack *stack) const
 
 ReachabilityInfo CBattleInfoCallback::getReachability(const ReachabilityInfo::Parameters &params) const
 {
-	if(params.flying)
-		return getFlyingReachability(params);
-	else
-		return makeBFS(getAccesibility(params.knownAccessible), params);
+	auto calculate = [&]() -> ReachabilityInfo
+	{
+		if(params.flying)
+			return getFlyingReachability(params);
+		else
+			return makeBFS(getAccesibility(params.knownAccessible), params);
+	};
+
+	if(!duringBattle())
+		return calculate();
+
+	//visible obstacles depend on who is asking, so viewer is part of the key as well
+	return getBattle()->getCachedReachability(battleGetMySide(), params, calculate);
 }
 
 ReachabilityInfo CBattleInfoCallback::getFlyingReachability(const ReachabilityInfo::Parameters &params) const
@@ -14,6 +14,12 @@
 #include "../NetPacks.h"
 #include "../mapObjects/CGTownInstance.h"
 
+BattleID CBattleInfoEssentials::battleGetID() const
+{
+	RETURN_IF_NOT_BATTLE(BattleID::NONE);
+	return getBattle()->battleID;
+}
+
 ETerrainType CBattleInfoEssentials::battleTerrainType() const
 {
 	RETURN_IF_NOT_BATTLE(ETerrainType::WRONG);
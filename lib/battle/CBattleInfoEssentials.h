@@ -46,6 +46,8 @@ public:
 
 	BattlePerspective::BattlePerspective battleGetMySide() const;
 
+	BattleID battleGetID() const; //returns BattleID::NONE if not in battle
+
 	ETerrainType battleTerrainType() const;
 	BFieldType battleGetBattlefieldType() const;
 	std::vector<std::shared_ptr<const CObstacleInstance> > battleGetAllObstacles(boost::optional<BattlePerspective::BattlePerspective> perspective = boost::none) const; //returns all obstacles on the battlefield
@@ -16,6 +16,7 @@ class CGameState;
 struct BattleInfo;
 
 class CBattleInfoEssentials;
+class CBattleInfoCallback;
 
 //Basic class for various callbacks (interfaces called by players to get info about game and so forth)
 class DLL_LINKAGE CCallbackBase
@@ -38,5 +39,6 @@ public:
 	boost::optional<PlayerColor> getPlayerID() const;
 
 	friend class CBattleInfoEssentials;
+	friend class CBattleInfoCallback;
 };
 
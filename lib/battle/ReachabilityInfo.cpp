@@ -32,6 +32,12 @@ ReachabilityInfo::Parameters::Parameters(const CStack * Stack)
 	knownAccessible = stack->getHexes();
 }
 
+bool ReachabilityInfo::Parameters::operator<(const Parameters & other) const
+{
+	return std::tie(startPosition, perspective, side, doubleWide, flying, knownAccessible)
+		< std::tie(other.startPosition, other.perspective, other.side, other.doubleWide, other.flying, other.knownAccessible);
+}
+
 ReachabilityInfo::ReachabilityInfo()
 {
 	distances.fill(INFINITE_DIST);
@@ -37,6 +37,8 @@ struct DLL_LINKAGE ReachabilityInfo
 
 		Parameters();
 		Parameters(const CStack * Stack);
+
+		bool operator<(const Parameters & other) const; //compares everything but stack, used as key for cached reachability
 	};
 
 	Parameters params;
@@ -18,6 +18,12 @@
 
 #include <cstdio>
 
+#ifdef VCMI_WINDOWS
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
 ///copied from ioapi.c due to linker issues on MSVS
 
 #include "../minizip/ioapi.h"
@@ -243,6 +249,13 @@ bool FileStream::CreateFile(const boost::filesystem::path& filename)
 	return result;
 }
 
+void FileStream::syncToDisk()
+{
+	flush();
+	if(!(*this)->syncToDisk())
+		throw std::ios_base::failure("could not sync file to disk");
+}
+
 FileBuf::FileBuf(const boost::filesystem::path& filename, std::ios_base::openmode mode)
 {
 	auto openmode = [mode]() -> std::basic_string<CharType>
@@ -286,6 +299,17 @@ FileBuf::FileBuf(const boost::filesystem::path& filename, std::ios_base::openmod
 	}
 }
 
+bool FileBuf::syncToDisk()
+{
+	if(std::fflush(GETFILE))
+		return false;
+#ifdef VCMI_WINDOWS
+	return _commit(_fileno(GETFILE)) == 0;
+#else
+	return fsync(fileno(GETFILE)) == 0;
+#endif
+}
+
 void FileBuf::close()
 {
     std::fclose(GETFILE);
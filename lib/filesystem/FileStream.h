@@ -27,6 +27,9 @@ public:
 	std::streamsize write(const char* s, std::streamsize n);
 	std::streamoff  seek(std::streamoff off, std::ios_base::seekdir way);
 
+	/// Forces OS to write all buffered data to the storage device
+	bool syncToDisk();
+
 	void close();
 private:
 	void* filePtr;
@@ -48,5 +51,8 @@ public:
 
 	static bool CreateFile(const boost::filesystem::path& filename);
 
+	/// Flushes stream and waits until written data reach the storage device
+	void syncToDisk();
+
 	static zlib_filefunc64_def* GetMinizipFilefunc();
 };
@@ -0,0 +1,227 @@
+/*
+ * CMapInfoCache.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CMapInfoCache.h"
+
+#include "CMapService.h"
+#include "../CCreatureHandler.h"
+#include "../CHeroHandler.h"
+#include "../rmg/CMapGenOptions.h"
+#include "../CThreadHelper.h"
+#include "../filesystem/Filesystem.h"
+#include "../serializer/BinaryDeserializer.h"
+#include "../serializer/BinarySerializer.h"
+
+static const std::string MAP_INDEX_MAGIC = "VCMIMAPIDX";
+
+CMapInfoCache::Entry::Entry():
+	fileSize(-1), lastWriteTime(-1)
+{
+}
+
+CMapInfoCache::CMapInfoCache(const boost::filesystem::path & indexFile):
+	indexFile(indexFile), changed(false)
+{
+	load();
+}
+
+void CMapInfoCache::load()
+{
+	if(!boost::filesystem::exists(indexFile))
+		return;
+
+	try
+	{
+		CLoadFile lf(indexFile);
+		lf.checkMagicBytes(MAP_INDEX_MAGIC);
+		lf >> maps >> saves;
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->warn("Map index %s is outdated or broken and will be rebuilt: %s", indexFile.string(), e.what());
+		maps.clear();
+		saves.clear();
+		changed = true;
+	}
+}
+
+void CMapInfoCache::save()
+{
+	if(!changed)
+		return;
+
+	try
+	{
+		CSaveFile sf(indexFile);
+		sf.putMagicBytes(MAP_INDEX_MAGIC);
+		sf << maps << saves;
+		changed = false;
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->error("Failed to write map index %s: %s", indexFile.string(), e.what());
+	}
+}
+
+std::vector<std::string> CMapInfoCache::update(TIndex & index, const std::unordered_set<ResourceID> & files, const TParser & parser)
+{
+	struct Job
+	{
+		const ResourceID * file;
+		Entry entry;
+		bool success;
+	};
+
+	std::vector<std::string> ret;
+	std::vector<Job> jobs;
+	std::set<std::string> present;
+
+	for(auto & file : files)
+	{
+		present.insert(file.getName());
+
+		si64 fileSize = -1;
+		si64 lastWriteTime = -1;
+		auto path = CResourceHandler::get()->getResourceName(file);
+		if(path)
+		{
+			boost::system::error_code ec;
+			auto size = boost::filesystem::file_size(*path, ec);
+			auto time = boost::filesystem::last_write_time(*path, ec);
+			if(!ec)
+			{
+				fileSize = size;
+				lastWriteTime = time;
+			}
+		}
+
+		auto iter = index.find(file.getName());
+		// files without physical location (e.g. inside archives) can't be validated and are always parsed
+		if(iter != index.end() && fileSize >= 0 && iter->second.fileSize == fileSize && iter->second.lastWriteTime == lastWriteTime)
+		{
+			ret.push_back(file.getName());
+			continue;
+		}
+
+		Job job;
+		job.file = &file;
+		job.entry.fileSize = fileSize;
+		job.entry.lastWriteTime = lastWriteTime;
+		job.success = false;
+		jobs.push_back(std::move(job));
+	}
+
+	std::vector<Task> tasks;
+	for(auto & job : jobs)
+	{
+		tasks.push_back([&job, &parser]()
+		{
+			try
+			{
+				parser(*job.file, job.entry);
+				job.success = true;
+			}
+			catch(const std::exception & e)
+			{
+				logGlobal->error("Failed to read header of %s: %s", job.file->getName(), e.what());
+			}
+		});
+	}
+
+	if(!tasks.empty())
+	{
+		CThreadHelper th(&tasks, std::max<ui32>(1, boost::thread::hardware_concurrency()));
+		th.run();
+	}
+
+	const size_t upToDate = ret.size();
+
+	for(auto & job : jobs)
+	{
+		const std::string name = job.file->getName();
+		if(job.success)
+		{
+			index[name] = std::move(job.entry);
+			ret.push_back(name);
+		}
+		else
+		{
+			index.erase(name);
+		}
+		changed = true;
+	}
+
+	for(auto iter = index.begin(); iter != index.end();)
+	{
+		if(present.count(iter->first))
+		{
+			++iter;
+		}
+		else
+		{
+			iter = index.erase(iter);
+			changed = true;
+		}
+	}
+
+	logGlobal->debug("Map index: %d headers up to date, %d parsed", upToDate, jobs.size());
+	return ret;
+}
+
+std::vector<CMapInfo> CMapInfoCache::getMaps(const std::unordered_set<ResourceID> & files)
+{
+	auto parser = [](const ResourceID & file, Entry & entry)
+	{
+		entry.mapHeader = *CMapService::loadMapHeader(ResourceID(file.getName(), EResType::MAP));
+	};
+
+	std::vector<CMapInfo> ret;
+	for(auto & name : update(maps, files, parser))
+	{
+		CMapInfo mapInfo;
+		mapInfo.fileURI = name;
+		mapInfo.mapHeader = make_unique<CMapHeader>(maps.at(name).mapHeader);
+		mapInfo.countPlayers();
+		ret.push_back(std::move(mapInfo));
+	}
+	return ret;
+}
+
+std::vector<CMapInfo> CMapInfoCache::getSaves(const std::unordered_set<ResourceID> & files)
+{
+	auto parser = [](const ResourceID & file, Entry & entry)
+	{
+		CLoadFile lf(*CResourceHandler::get()->getResourceName(file), MINIMAL_SERIALIZATION_VERSION);
+		lf.checkMagicBytes(SAVEGAME_MAGIC);
+
+		StartInfo * scenarioOpts = nullptr; //to be created by serialiser
+		lf >> entry.mapHeader >> scenarioOpts;
+		entry.scenarioOpts.reset(scenarioOpts);
+		if(!scenarioOpts)
+			throw std::runtime_error("savegame has no start info");
+	};
+
+	std::vector<CMapInfo> ret;
+	for(auto & name : update(saves, files, parser))
+	{
+		const Entry & entry = saves.at(name);
+
+		CMapInfo mapInfo;
+		mapInfo.fileURI = name;
+		mapInfo.mapHeader = make_unique<CMapHeader>(entry.mapHeader);
+		mapInfo.scenarioOpts = new StartInfo(*entry.scenarioOpts);
+		mapInfo.countPlayers();
+
+		std::time_t time = entry.lastWriteTime;
+		mapInfo.date = std::asctime(std::localtime(&time));
+		ret.push_back(std::move(mapInfo));
+	}
+	return ret;
+}
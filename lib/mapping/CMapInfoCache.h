@@ -0,0 +1,68 @@
+/*
+ * CMapInfoCache.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "CMapInfo.h"
+#include "../StartInfo.h"
+#include "../filesystem/ResourceID.h"
+
+/**
+ * Persistent index of map and savegame headers shown in scenario selection.
+ *
+ * Every header is stored together with size and modification time of its file.
+ * Only files which are not yet in the index or were changed on disk since are
+ * parsed again, in parallel. Index is stored in the user cache directory and
+ * silently rebuilt if it is missing or was written by another format version.
+ */
+class DLL_LINKAGE CMapInfoCache
+{
+public:
+	CMapInfoCache(const boost::filesystem::path & indexFile);
+
+	/// Returns headers of all given maps, maps which can't be parsed are skipped
+	std::vector<CMapInfo> getMaps(const std::unordered_set<ResourceID> & files);
+	/// Returns headers and start options of all given savegames, broken saves are skipped
+	std::vector<CMapInfo> getSaves(const std::unordered_set<ResourceID> & files);
+
+	/// Writes index back to disk if any entry was added, updated or removed
+	void save();
+
+private:
+	struct Entry
+	{
+		si64 fileSize;
+		si64 lastWriteTime;
+		CMapHeader mapHeader;
+		std::unique_ptr<StartInfo> scenarioOpts; //only present for savegames
+
+		Entry();
+
+		template <typename Handler> void serialize(Handler & h, const int version)
+		{
+			h & fileSize;
+			h & lastWriteTime;
+			h & mapHeader;
+			h & scenarioOpts;
+		}
+	};
+
+	typedef std::map<std::string, Entry> TIndex;
+	typedef std::function<void(const ResourceID &, Entry &)> TParser;
+
+	boost::filesystem::path indexFile;
+	TIndex maps;
+	TIndex saves;
+	bool changed;
+
+	void load();
+
+	/// Brings index up to date with given files and returns names of files with valid entries
+	std::vector<std::string> update(TIndex & index, const std::unordered_set<ResourceID> & files, const TParser & parser);
+};
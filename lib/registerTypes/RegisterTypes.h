@@ -319,6 +319,7 @@ void registerTypesServerPacks(Serializer &s)
 	s.template registerType<CPackForServer, EndTurn>();
 	s.template registerType<CPackForServer, DismissHero>();
 	s.template registerType<CPackForServer, MoveHero>();
+	s.template registerType<CPackForServer, MoveHeroPath>();
 	s.template registerType<CPackForServer, ArrangeStacks>();
 	s.template registerType<CPackForServer, DisbandCreature>();
 	s.template registerType<CPackForServer, BuildStructure>();
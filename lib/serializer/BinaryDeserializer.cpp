@@ -13,10 +13,16 @@
 
 #include "../registerTypes/RegisterTypes.h"
 
+#include <zlib.h>
+
 extern template void registerTypes<BinaryDeserializer>(BinaryDeserializer & s);
 
+static const int inflateBlockSize = 1 << 16;
+/// First format version that stores everything after the header deflate-compressed
+static const ui32 COMPRESSED_FORMAT_VERSION = 779;
+
 CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion)
-	: serializer(this)
+	: inflateState(nullptr), serializer(this)
 {
 	registerTypes(serializer);
 	openNextFile(fname, minimalVersion);
@@ -24,19 +30,51 @@ CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion)
 
 CLoadFile::~CLoadFile()
 {
+	clear();
 }
 
 int CLoadFile::read(void * data, unsigned size)
 {
+	if(inflateState)
+		return readCompressed(data, size);
+
 	sfile->read((char*)data,size);
 	return size;
 }
 
+int CLoadFile::readCompressed(void * data, unsigned size)
+{
+	inflateState->next_out = (Bytef *)data;
+	inflateState->avail_out = size;
+
+	while(inflateState->avail_out != 0)
+	{
+		if(inflateState->avail_in == 0)
+		{
+			// read directly from buffer - partial read at the end of file must not trigger stream exceptions
+			auto availSize = sfile->rdbuf()->sgetn((char *)compressedBuffer.data(), compressedBuffer.size());
+			if(availSize <= 0)
+				THROW_FORMAT("Error: unexpected end of file %s!", fName);
+
+			inflateState->next_in = compressedBuffer.data();
+			inflateState->avail_in = availSize;
+		}
+
+		int ret = inflate(inflateState, Z_NO_FLUSH);
+		if(ret == Z_STREAM_END && inflateState->avail_out != 0)
+			THROW_FORMAT("Error: unexpected end of compressed data in %s!", fName);
+		if(ret != Z_OK && ret != Z_STREAM_END)
+			THROW_FORMAT("Error: decompression of %s failed: %s", fName % (inflateState->msg ? inflateState->msg : "unknown error"));
+	}
+	return size;
+}
+
 void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalVersion)
 {
 	assert(!serializer.reverseEndianess);
 	assert(minimalVersion <= SERIALIZATION_VERSION);
 
+	clear();
 	try
 	{
 		fName = fname.string();
@@ -72,6 +110,22 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 			else
 				THROW_FORMAT("Error: too new file format (%s)!", fName);
 		}
+
+		if(serializer.fileVersion >= COMPRESSED_FORMAT_VERSION)
+		{
+			inflateState = new z_stream();
+			inflateState->zalloc = Z_NULL;
+			inflateState->zfree = Z_NULL;
+			inflateState->opaque = Z_NULL;
+			inflateState->avail_in = 0;
+			inflateState->next_in = Z_NULL;
+			if(inflateInit(inflateState) != Z_OK)
+			{
+				vstd::clear_pointer(inflateState);
+				throw std::runtime_error("Failed to initialize inflate!");
+			}
+			compressedBuffer.resize(inflateBlockSize);
+		}
 	}
 	catch(...)
 	{
@@ -89,6 +143,11 @@ void CLoadFile::reportState(vstd::CLoggerBase * out)
 
 void CLoadFile::clear()
 {
+	if(inflateState)
+	{
+		inflateEnd(inflateState);
+		vstd::clear_pointer(inflateState);
+	}
 	sfile = nullptr;
 	fName.clear();
 	serializer.fileVersion = 0;
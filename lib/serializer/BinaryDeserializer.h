@@ -16,6 +16,7 @@
 
 class CStackInstance;
 class FileStream;
+struct z_stream_s;
 
 class DLL_LINKAGE CLoaderBase
 {
@@ -161,9 +162,10 @@ public:
 	bool reverseEndianess; //if source has different endianness than us, we reverse bytes
 	si32 fileVersion;
 
-	std::map<ui32, void*> loadedPointers;
-	std::map<ui32, const std::type_info*> loadedPointersTypes;
-	std::map<const void*, boost::any> loadedSharedPointers;
+	/// Pointer ids are given out consecutively by the serializer, so loaded pointers are indexed directly by their id
+	std::vector<void*> loadedPointers;
+	std::vector<const std::type_info*> loadedPointersTypes;
+	std::unordered_map<const void*, boost::any> loadedSharedPointers;
 	bool smartPointerSerialization;
 	bool saving;
 
@@ -282,14 +284,12 @@ public:
 		if(smartPointerSerialization)
 		{
 			load( pid ); //get the id
-			std::map<ui32, void*>::iterator i = loadedPointers.find(pid); //lookup
-
-			if(i != loadedPointers.end())
+			if(pid < loadedPointers.size() && loadedPointers[pid])
 			{
 				// We already got this pointer
 				// Cast it in case we are loading it to a non-first base pointer
-				assert(loadedPointersTypes.count(pid));
-				data = reinterpret_cast<T>(typeList.castRaw(i->second, loadedPointersTypes.at(pid), &typeid(typename std::remove_const<typename std::remove_pointer<T>::type>::type)));
+				assert(loadedPointersTypes[pid]);
+				data = reinterpret_cast<T>(typeList.castRaw(loadedPointers[pid], loadedPointersTypes[pid], &typeid(typename std::remove_const<typename std::remove_pointer<T>::type>::type)));
 				return;
 			}
 		}
@@ -325,8 +325,18 @@ public:
 	{
 		if(smartPointerSerialization && pid != 0xffffffff)
 		{
+			if(pid > loadedPointers.size()) //ids are given in order of saving, so a new pointer can only take the next one
+			{
+				reader->reportState(logGlobal);
+				throw std::runtime_error("Invalid pointer id " + std::to_string(pid) + " after " + std::to_string(loadedPointers.size()) + " loaded pointers");
+			}
+			if(pid == loadedPointers.size())
+			{
+				loadedPointers.push_back(nullptr);
+				loadedPointersTypes.push_back(nullptr);
+			}
 			loadedPointersTypes[pid] = &typeid(T);
-			loadedPointers[pid] = (void*)ptr; //add loaded pointer to our lookup map; cast is to avoid errors with const T* pt
+			loadedPointers[pid] = (void*)ptr; //add loaded pointer to our lookup table; cast is to avoid errors with const T* pt
 		}
 	}
 
@@ -508,8 +518,13 @@ public:
 	}
 };
 
+/// Reads savegame file. Files of current format are decompressed on the fly, older uncompressed ones are still supported
 class DLL_LINKAGE CLoadFile : public IBinaryReader
 {
+	z_stream_s * inflateState;
+	std::vector<ui8> compressedBuffer;
+
+	int readCompressed(void * data, unsigned size); //throws!
 public:
 	BinaryDeserializer serializer;
 
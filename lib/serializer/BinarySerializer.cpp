@@ -13,10 +13,14 @@
 
 #include "../registerTypes/RegisterTypes.h"
 
+#include <zlib.h>
+
 extern template void registerTypes<BinarySerializer>(BinarySerializer & s);
 
+static const int deflateBlockSize = 1 << 16;
+
 CSaveFile::CSaveFile(const boost::filesystem::path &fname)
-	: serializer(this)
+	: deflateState(nullptr), serializer(this)
 {
 	registerTypes(serializer);
 	openNextFile(fname);
@@ -24,16 +28,64 @@ CSaveFile::CSaveFile(const boost::filesystem::path &fname)
 
 CSaveFile::~CSaveFile()
 {
+	try
+	{
+		close();
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error("Failed to finish writing savegame: %s", e.what());
+	}
 }
 
 int CSaveFile::write(const void * data, unsigned size)
 {
-	sfile->write((char *)data,size);
+	if(!deflateState)
+	{
+		sfile->write((char *)data,size);
+		return size;
+	}
+
+	deflateState->next_in = (Bytef *)data;
+	deflateState->avail_in = size;
+	writeCompressed(Z_NO_FLUSH);
 	return size;
 }
 
+void CSaveFile::writeCompressed(int flush)
+{
+	int ret;
+	do
+	{
+		deflateState->next_out = compressedBuffer.data();
+		deflateState->avail_out = compressedBuffer.size();
+
+		ret = deflate(deflateState, flush);
+		if(ret == Z_STREAM_ERROR)
+			throw std::runtime_error("Compression error while writing " + fName.string());
+
+		sfile->write((char *)compressedBuffer.data(), compressedBuffer.size() - deflateState->avail_out);
+	}
+	while(deflateState->avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+}
+
+void CSaveFile::finishCompression()
+{
+	if(!deflateState)
+		return;
+
+	deflateState->next_in = Z_NULL;
+	deflateState->avail_in = 0;
+	writeCompressed(Z_FINISH);
+
+	deflateEnd(deflateState);
+	vstd::clear_pointer(deflateState);
+}
+
 void CSaveFile::openNextFile(const boost::filesystem::path &fname)
 {
+	close();
+
 	fName = fname;
 	try
 	{
@@ -45,6 +97,18 @@ void CSaveFile::openNextFile(const boost::filesystem::path &fname)
 
 		sfile->write("VCMI",4); //write magic identifier
 		serializer & SERIALIZATION_VERSION; //write format version
+
+		// fast compression level - savegames are written often and shrink several times even so
+		deflateState = new z_stream();
+		deflateState->zalloc = Z_NULL;
+		deflateState->zfree = Z_NULL;
+		deflateState->opaque = Z_NULL;
+		if(deflateInit(deflateState, Z_BEST_SPEED) != Z_OK)
+		{
+			vstd::clear_pointer(deflateState);
+			throw std::runtime_error("Failed to initialize deflate!");
+		}
+		compressedBuffer.resize(deflateBlockSize);
 	}
 	catch(...)
 	{
@@ -54,6 +118,41 @@ void CSaveFile::openNextFile(const boost::filesystem::path &fname)
 	}
 }
 
+void CSaveFile::close(bool syncToDisk)
+{
+	if(!sfile)
+		return;
+
+	try
+	{
+		finishCompression();
+		if(syncToDisk)
+			sfile->syncToDisk();
+		else
+			sfile->flush();
+	}
+	catch(...)
+	{
+		clear();
+		throw;
+	}
+	clear();
+}
+
+void CSaveFile::flush()
+{
+	if(!sfile)
+		return;
+
+	if(deflateState)
+	{
+		deflateState->next_in = Z_NULL;
+		deflateState->avail_in = 0;
+		writeCompressed(Z_SYNC_FLUSH);
+	}
+	sfile->flush();
+}
+
 void CSaveFile::reportState(vstd::CLoggerBase * out)
 {
 	out->debug("CSaveFile");
@@ -65,6 +164,11 @@ void CSaveFile::reportState(vstd::CLoggerBase * out)
 
 void CSaveFile::clear()
 {
+	if(deflateState)
+	{
+		deflateEnd(deflateState);
+		vstd::clear_pointer(deflateState);
+	}
 	fName.clear();
 	sfile = nullptr;
 }
@@ -13,6 +13,7 @@
 #include "../mapObjects/CArmedInstance.h"
 
 class FileStream;
+struct z_stream_s;
 
 class DLL_LINKAGE CSaverBase
 {
@@ -109,7 +110,7 @@ class DLL_LINKAGE BinarySerializer : public CSaverBase
 	CApplier<CBasicPointerSaver> applier;
 
 public:
-	std::map<const void*, ui32> savedPointers;
+	std::unordered_map<const void*, ui32> savedPointers;
 
 	bool smartPointerSerialization;
 	bool saving;
@@ -208,7 +209,7 @@ public:
 			// We might have an object that has multiple inheritance and store it via the non-first base pointer.
 			// Therefore, all pointers need to be normalized to the actual object address.
 			auto actualPointer = typeList.castToMostDerived(data);
-			std::map<const void*,ui32>::iterator i = savedPointers.find(actualPointer);
+			auto i = savedPointers.find(actualPointer);
 			if(i != savedPointers.end())
 			{
 				//this pointer has been already serialized - write only it's id
@@ -218,7 +219,7 @@ public:
 
 			//give id to this pointer
 			ui32 pid = (ui32)savedPointers.size();
-			savedPointers[actualPointer] = pid;
+			savedPointers.insert(std::make_pair(actualPointer, pid));
 			save(pid);
 		}
 
@@ -346,8 +347,14 @@ public:
 	}
 };
 
+/// Writes savegame file. Everything after format version is deflate-compressed on the fly
 class DLL_LINKAGE CSaveFile : public IBinaryWriter
 {
+	z_stream_s * deflateState;
+	std::vector<ui8> compressedBuffer;
+
+	void writeCompressed(int flush);
+	void finishCompression(); //throws!
 public:
 	BinarySerializer serializer;
 
@@ -359,6 +366,8 @@ public:
 	int write(const void * data, unsigned size) override;
 
 	void openNextFile(const boost::filesystem::path &fname); //throws!
+	void close(bool syncToDisk = false); //throws! flushes all pending data, file must be closed this way to report write errors
+	void flush(); //throws! data written so far can be read even if file is never closed, slightly worsens compression
 	void clear();
 	void reportState(vstd::CLoggerBase * out) override;
 
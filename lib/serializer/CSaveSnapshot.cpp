@@ -0,0 +1,122 @@
+/*
+ * CSaveSnapshot.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CSaveSnapshot.h"
+
+#include "../CThreadHelper.h"
+#include "../registerTypes/RegisterTypes.h"
+
+extern template void registerTypes<BinarySerializer>(BinarySerializer & s);
+
+CSaveSnapshot::CSaveSnapshot()
+	: serializer(this)
+{
+	registerTypes(serializer);
+}
+
+int CSaveSnapshot::write(const void * data, unsigned size)
+{
+	auto bytes = static_cast<const ui8 *>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+	return size;
+}
+
+void CSaveSnapshot::putMagicBytes(const std::string & text)
+{
+	write(text.c_str(), text.length());
+}
+
+void CSaveSnapshot::writeToFile(const boost::filesystem::path & fname) const
+{
+	// write into temporary file first so crash in the middle of writing won't destroy previous save
+	auto tempName = fname;
+	tempName += ".tmp";
+	{
+		CSaveFile file(tempName);
+		file.write(buffer.data(), buffer.size());
+		file.close(true);
+	}
+	boost::filesystem::rename(tempName, fname);
+}
+
+CBackgroundSaver::CBackgroundSaver()
+	: terminating(false)
+{
+	thread = boost::thread(&CBackgroundSaver::run, this);
+}
+
+CBackgroundSaver::~CBackgroundSaver()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		terminating = true;
+	}
+	cond.notify_all();
+	thread.join();
+}
+
+void CBackgroundSaver::save(std::unique_ptr<CSaveSnapshot> snapshot, const boost::filesystem::path & fname)
+{
+	Job job;
+	job.snapshot = std::move(snapshot);
+	job.fname = fname;
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		jobs.push_back(std::move(job));
+	}
+	cond.notify_all();
+}
+
+void CBackgroundSaver::waitForPendingWrites()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	while(!jobs.empty())
+		cond.wait(lock);
+}
+
+void CBackgroundSaver::run()
+{
+	setThreadName("CBackgroundSaver::run");
+
+	while(true)
+	{
+		Job * job;
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			while(jobs.empty() && !terminating)
+				cond.wait(lock);
+
+			if(jobs.empty())
+				return;
+			job = &jobs.front(); //deque keeps references valid while other jobs are added
+		}
+
+		try
+		{
+			auto start = boost::posix_time::microsec_clock::universal_time();
+			job->snapshot->writeToFile(job->fname);
+			auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+
+			logGlobal->info("Game has been saved to %s: %d KB of data written as %d KB in %d ms",
+				job->fname.string(), job->snapshot->buffer.size() / 1024,
+				boost::filesystem::file_size(job->fname) / 1024, duration.total_milliseconds());
+		}
+		catch(std::exception & e)
+		{
+			logGlobal->error("Failed to write save %s: %s", job->fname.string(), e.what());
+		}
+
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			jobs.pop_front();
+		}
+		cond.notify_all();
+	}
+}
@@ -0,0 +1,67 @@
+/*
+ * CSaveSnapshot.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "BinarySerializer.h"
+
+/// Serializes savegame into memory buffer instead of file.
+/// This is much faster than CSaveFile since neither compression nor disk access is involved,
+/// so game state needs to be locked only for short time. Snapshot can be written to disk later.
+class DLL_LINKAGE CSaveSnapshot : public IBinaryWriter
+{
+public:
+	BinarySerializer serializer;
+	std::vector<ui8> buffer;
+
+	CSaveSnapshot();
+	int write(const void * data, unsigned size) override;
+
+	void putMagicBytes(const std::string & text);
+
+	/// Writes snapshot to disk in the same format as CSaveFile does and waits until it reaches the storage.
+	/// Existing file is replaced only once new one is completely written. Safe to call from any thread
+	void writeToFile(const boost::filesystem::path & fname) const; //throws!
+
+	template<class T>
+	CSaveSnapshot & operator<<(const T & t)
+	{
+		serializer & t;
+		return * this;
+	}
+};
+
+/// Writes save snapshots on a dedicated thread, one by one in the order of submission.
+/// Size and duration of every write are reported to the log
+class DLL_LINKAGE CBackgroundSaver : public boost::noncopyable
+{
+public:
+	CBackgroundSaver();
+	~CBackgroundSaver(); //waits until all pending snapshots are written
+
+	void save(std::unique_ptr<CSaveSnapshot> snapshot, const boost::filesystem::path & fname);
+
+	/// Blocks until all already submitted snapshots are written
+	void waitForPendingWrites();
+
+private:
+	struct Job
+	{
+		std::unique_ptr<CSaveSnapshot> snapshot;
+		boost::filesystem::path fname;
+	};
+
+	boost::mutex mx;
+	boost::condition_variable cond;
+	std::deque<Job> jobs; //front job is the one being written
+	bool terminating;
+	boost::thread thread;
+
+	void run();
+};
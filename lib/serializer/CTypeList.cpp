@@ -109,6 +109,33 @@ std::vector<CTypeList::TypeInfoPtr> CTypeList::castSequence(const std::type_info
 	return castSequence(getTypeDescriptor(from), getTypeDescriptor(to));
 }
 
+const CTypeList::TCasterSequence & CTypeList::casterSequence(const std::type_info *from, const std::type_info *to) const
+{
+	const TCastKey key(from, to);
+	{
+		TSharedLock cacheLock(castCacheMx);
+		auto i = castCache.find(key);
+		if(i != castCache.end())
+			return i->second;
+	}
+
+	auto typesSequence = castSequence(from, to);
+
+	TCasterSequence ret;
+	for(int i = 0; i < static_cast<int>(typesSequence.size()) - 1; i++)
+	{
+		auto castingPair = std::make_pair(typesSequence[i], typesSequence[i + 1]);
+		auto caster = casters.find(castingPair);
+		if(caster == casters.end())
+			THROW_FORMAT("Cannot find caster for conversion %s -> %s which is needed to cast %s -> %s", castingPair.first->name % castingPair.second->name % from->name() % to->name());
+
+		ret.push_back(caster->second.get());
+	}
+
+	TUniqueLock cacheLock(castCacheMx);
+	return castCache.insert(std::make_pair(key, std::move(ret))).first->second;
+}
+
 CTypeList::TypeInfoPtr CTypeList::getTypeDescriptor(const std::type_info *type, bool throws) const
 {
 	auto i = typeInfos.find(type);
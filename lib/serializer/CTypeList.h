@@ -80,29 +80,39 @@ private:
 	std::map<const std::type_info *, TypeInfoPtr, TypeComparer> typeInfos;
 	std::map<std::pair<TypeInfoPtr, TypeInfoPtr>, std::unique_ptr<const IPointerCaster>> casters; //for each pair <Base, Der> we provide a caster (each registered relations creates a single entry here)
 
+	typedef std::vector<const IPointerCaster *> TCasterSequence;
+	typedef std::pair<const std::type_info *, const std::type_info *> TCastKey;
+
+	struct CastKeyHash
+	{
+		size_t operator()(const TCastKey & key) const
+		{
+			size_t ret = std::hash<const void *>()(key.first);
+			boost::hash_combine(ret, key.second);
+			return ret;
+		}
+	};
+
+	mutable TMutex castCacheMx;
+	mutable std::unordered_map<TCastKey, TCasterSequence, CastKeyHash> castCache; //resolved casters for every pair of types that was already casted
+
 	/// Returns sequence of types starting from "from" and ending on "to". Every next type is derived from the previous.
 	/// Throws if there is no link registered.
 	std::vector<TypeInfoPtr> castSequence(TypeInfoPtr from, TypeInfoPtr to) const;
 	std::vector<TypeInfoPtr> castSequence(const std::type_info *from, const std::type_info *to) const;
 
+	/// Returns casters that need to be applied one after another to cast "from" to "to".
+	/// Path through the class hierarchy is searched only once for each pair of types. Must be called with mx locked.
+	const TCasterSequence & casterSequence(const std::type_info *from, const std::type_info *to) const;
+
 	template<boost::any(IPointerCaster::*CastingFunction)(const boost::any &) const>
 	boost::any castHelper(boost::any inputPtr, const std::type_info *fromArg, const std::type_info *toArg) const
 	{
 		TSharedLock lock(mx);
-		auto typesSequence = castSequence(fromArg, toArg);
 
 		boost::any ptr = inputPtr;
-		for(int i = 0; i < static_cast<int>(typesSequence.size()) - 1; i++)
-		{
-			auto &from = typesSequence[i];
-			auto &to = typesSequence[i + 1];
-			auto castingPair = std::make_pair(from, to);
-			if(!casters.count(castingPair))
-				THROW_FORMAT("Cannot find caster for conversion %s -> %s which is needed to cast %s -> %s", from->name % to->name % fromArg->name() % toArg->name());
-
-			auto &caster = casters.at(castingPair);
-			ptr = (*caster.*CastingFunction)(ptr); //Why does unique_ptr not have operator->* ..?
-		}
+		for(auto caster : casterSequence(fromArg, toArg))
+			ptr = (caster->*CastingFunction)(ptr);
 
 		return ptr;
 	}
@@ -137,6 +147,9 @@ public:
 		dti->parents.push_back(bti);
 		casters[std::make_pair(bti, dti)] = make_unique<const PointerCaster<Base, Derived>>();
 		casters[std::make_pair(dti, bti)] = make_unique<const PointerCaster<Derived, Base>>();
+
+		TUniqueLock cacheLock(castCacheMx);
+		castCache.clear();
 	}
 
 	ui16 getTypeID(const std::type_info *type, bool throws = false) const;
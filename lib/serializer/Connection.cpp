@@ -254,6 +254,7 @@ void CConnection::enableSmartPointerSerialization()
 void CConnection::prepareForSendingHeroes()
 {
 	iser.loadedPointers.clear();
+	iser.loadedPointersTypes.clear();
 	oser.savedPointers.clear();
 	disableSmartVectorMemberSerialization();
 	enableSmartPointerSerialization();
@@ -263,6 +264,7 @@ void CConnection::prepareForSendingHeroes()
 void CConnection::enterPregameConnectionMode()
 {
 	iser.loadedPointers.clear();
+	iser.loadedPointersTypes.clear();
 	oser.savedPointers.clear();
 	disableSmartVectorMemberSerialization();
 	disableSmartPointerSerialization();
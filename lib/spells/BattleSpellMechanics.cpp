@@ -30,6 +30,7 @@ void HealingSpellMechanics::applyBattleEffects(const SpellCastEnvironment * env,
 
 	int hpGained = calculateHealedHP(env, parameters, ctx);
 	StacksHealedOrResurrected shr;
+	shr.battleID = parameters.cb->battleID;
 	shr.lifeDrain = false;
 	shr.tentHealing = false;
 
@@ -138,6 +139,7 @@ void CloneMechanics::applyBattleEffects(const SpellCastEnvironment * env, const
 	}
 
 	BattleStackAdded bsa;
+	bsa.battleID = parameters.cb->battleID;
 	bsa.creID = clonedStack->type->idNumber;
 	bsa.side = parameters.casterSide;
 	bsa.summoned = true;
@@ -146,6 +148,7 @@ void CloneMechanics::applyBattleEffects(const SpellCastEnvironment * env, const
 	env->sendAndApply(&bsa);
 
 	BattleSetStackProperty ssp;
+	ssp.battleID = parameters.cb->battleID;
 	ssp.stackID = bsa.newStackID;//we know stack ID after apply
 	ssp.which = BattleSetStackProperty::CLONED;
 	ssp.val = 0;
@@ -159,6 +162,7 @@ void CloneMechanics::applyBattleEffects(const SpellCastEnvironment * env, const
 	env->sendAndApply(&ssp);
 
 	SetStackEffect sse;
+	sse.battleID = parameters.cb->battleID;
 	sse.stacks.push_back(bsa.newStackID);
 	Bonus lifeTimeMarker(Bonus::N_TURNS, Bonus::NONE, Bonus::SPELL_EFFECT, 0, owner->id.num);
 	lifeTimeMarker.turnsRemain = parameters.enchantPower;
@@ -272,6 +276,7 @@ void DispellMechanics::applyBattleEffects(const SpellCastEnvironment * env, cons
 	{
 		//expert DISPELL also removes spell-created obstacles
 		ObstaclesRemoved packet;
+		packet.battleID = parameters.cb->battleID;
 
 		for(const auto obstacle : parameters.cb->obstacles)
 		{
@@ -324,6 +329,7 @@ void EarthquakeMechanics::applyBattleEffects(const SpellCastEnvironment * env, c
 	const int targetsToAttack = 2 + std::max<int>(parameters.spellLvl - 1, 0);
 
 	CatapultAttack ca;
+	ca.battleID = parameters.cb->battleID;
 	ca.attacker = -1;
 
 	for(int i = 0; i < targetsToAttack; i++)
@@ -363,6 +369,7 @@ void EarthquakeMechanics::applyBattleEffects(const SpellCastEnvironment * env, c
 		if(posRemove != BattleHex::INVALID)
 		{
 			BattleStacksRemoved bsr;
+			bsr.battleID = parameters.cb->battleID;
 			for(auto & elem : parameters.cb->stacks)
 			{
 				if(elem->position == posRemove)
@@ -518,6 +525,7 @@ void ObstacleMechanics::placeObstacle(const SpellCastEnvironment * env, const Ba
 	obstacle->uniqueID = obstacleIdToGive;
 
 	BattleObstaclePlaced bop;
+	bop.battleID = parameters.cb->battleID;
 	bop.obstacle = obstacle;
 	env->sendAndApply(&bop);
 }
@@ -714,6 +722,7 @@ void RemoveObstacleMechanics::applyBattleEffects(const SpellCastEnvironment * en
 	if(!obstacleToRemove.empty())
 	{
 		ObstaclesRemoved obr;
+		obr.battleID = parameters.cb->battleID;
 		bool complain = true;
 		for(auto & i : obstacleToRemove)
 		{
@@ -875,6 +884,7 @@ void SacrificeMechanics::applyBattleEffects(const SpellCastEnvironment * env, co
 	RisingSpellMechanics::applyBattleEffects(env, parameters, ctx);
 	//it is safe to remove even active stack
 	BattleStacksRemoved bsr;
+	bsr.battleID = parameters.cb->battleID;
 	bsr.stackIDs.insert(victim->ID);
 	env->sendAndApply(&bsr);
 }
@@ -1010,6 +1020,7 @@ ESpellCastProblem::ESpellCastProblem SummonMechanics::canBeCast(const CBattleInf
 void SummonMechanics::applyBattleEffects(const SpellCastEnvironment * env, const BattleSpellCastParameters & parameters, SpellCastContext & ctx) const
 {
 	BattleStackAdded bsa;
+	bsa.battleID = parameters.cb->battleID;
 	bsa.creID = creatureToSummon;
 	bsa.side = parameters.casterSide;
 	bsa.summoned = true;
@@ -1065,6 +1076,7 @@ void TeleportMechanics::applyBattleEffects(const SpellCastEnvironment * env, con
 		}
 
 		BattleStackMoved bsm;
+		bsm.battleID = parameters.cb->battleID;
 		bsm.distance = -1;
 		bsm.stack = target->ID;
 		std::vector<BattleHex> tiles;
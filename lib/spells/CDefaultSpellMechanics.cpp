@@ -117,11 +117,36 @@ namespace SRSLPraserHelpers
 
 		return ret;
 	}
+
+	//farther rings are completely outside of battlefield
+	static const int RING_COUNT = GameConstants::BFIELD_WIDTH + GameConstants::BFIELD_HEIGHT;
+
+	//hexes in given distance from center, rings around all tiles are computed once
+	static const TBattleHexMask & getRing(BattleHex center, int distance)
+	{
+		static const std::vector<TBattleHexMask> rings = []()
+		{
+			std::vector<TBattleHexMask> ret(GameConstants::BFIELD_SIZE * RING_COUNT);
+			for(int hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+				for(int ring = 0; ring < RING_COUNT; ring++)
+					for(auto tile : getInRange(hex, ring, ring))
+						ret[hex * RING_COUNT + ring].set(tile);
+			return ret;
+		}();
+		static const TBattleHexMask noHexes;
+
+		assert(center.isValid());
+		if(distance < 0 || distance >= RING_COUNT)
+			return noHexes;
+		return rings[center * RING_COUNT + distance];
+	}
 }
 
 SpellCastContext::SpellCastContext(const DefaultSpellMechanics * mechanics_, const SpellCastEnvironment * env_, const BattleSpellCastParameters & parameters_):
 	mechanics(mechanics_), env(env_), attackedCres(), sc(), si(), parameters(parameters_), otherHero(nullptr), spellCost(0), damageToDisplay(0)
 {
+	sc.battleID = parameters.cb->battleID;
+	si.battleID = parameters.cb->battleID;
 	sc.side = parameters.casterSide;
 	sc.id = mechanics->owner->id;
 	sc.skill = parameters.spellLvl;
@@ -242,6 +267,7 @@ void SpellCastContext::afterCast()
 		assert(parameters.casterStack);
 
 		BattleSetStackProperty ssp;
+		ssp.battleID = parameters.cb->battleID;
 		ssp.stackID = parameters.casterStack->ID;
 		ssp.which = BattleSetStackProperty::CASTS;
 		ssp.val = -1;
@@ -475,6 +501,7 @@ void DefaultSpellMechanics::defaultDamageEffect(const SpellCastEnvironment * env
 void DefaultSpellMechanics::defaultTimedEffect(const SpellCastEnvironment * env, const BattleSpellCastParameters & parameters, SpellCastContext & ctx) const
 {
 	SetStackEffect sse;
+	sse.battleID = parameters.cb->battleID;
 	//get default spell duration (spell power with bonuses for heroes)
 	int duration = parameters.enchantPower;
 	//generate actual stack bonuses
@@ -574,59 +601,23 @@ std::vector<BattleHex> DefaultSpellMechanics::rangeInHexes(BattleHex centralHex,
 	using namespace SRSLPraserHelpers;
 
 	std::vector<BattleHex> ret;
-	std::string rng = owner->getLevelInfo(schoolLvl).range + ','; //copy + artificial comma for easier handling
 
-	if(rng.size() >= 2 && rng[0] != 'X') //there is at least one hex in range (+artificial comma)
+	for(const auto & layer : owner->getLevelInfo(schoolLvl).rangeLayers)
 	{
-		std::string number1, number2;
-		int beg, end;
-		bool readingFirst = true;
-		for(auto & elem : rng)
+		if(centralHex.isValid())
 		{
-			if(std::isdigit(elem) ) //reading number
-			{
-				if(readingFirst)
-					number1 += elem;
-				else
-					number2 += elem;
-			}
-			else if(elem == ',') //comma
-			{
-				//calculating variables
-				if(readingFirst)
-				{
-					beg = atoi(number1.c_str());
-					number1 = "";
-				}
-				else
-				{
-					end = atoi(number2.c_str());
-					number2 = "";
-				}
-				//obtaining new hexes
-				std::set<ui16> curLayer;
-				if(readingFirst)
-				{
-					curLayer = getInRange(centralHex, beg, beg);
-				}
-				else
-				{
-					curLayer = getInRange(centralHex, beg, end);
-					readingFirst = true;
-				}
-				//adding abtained hexes
-				for(auto & curLayer_it : curLayer)
-				{
-					ret.push_back(curLayer_it);
-				}
+			TBattleHexMask area;
+			for(int distance = layer.first; distance <= layer.second; distance++)
+				area |= getRing(centralHex, distance);
 
-			}
-			else if(elem == '-') //dash
-			{
-				beg = atoi(number1.c_str());
-				number1 = "";
-				readingFirst = false;
-			}
+			for(int hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+				if(area.test(hex))
+					ret.push_back(hex);
+		}
+		else
+		{
+			for(auto hex : getInRange(centralHex, layer.first, layer.second))
+				ret.push_back(hex);
 		}
 	}
 
@@ -704,11 +695,29 @@ std::vector<const CStack *> DefaultSpellMechanics::calculateAffectedStacks(const
 	}
 	else //custom range from attackedHexes
 	{
+		TBattleHexMask area;
 		for(BattleHex hex : attackedHexes)
+			if(hex.isValid())
+				area.set(hex);
+
+		//same as asking battleGetStackByPos for every hex: each hex in range is taken by first stack standing there
+		for(const CStack * st : cb->battleGetAllStacks(true))
 		{
-			if(const CStack * st = cb->battleGetStackByPos(hex, ti.onlyAlive))
-				if(mainFilter(st))
-					attackedCres.insert(st);
+			if(ti.onlyAlive && !st->alive())
+				continue;
+
+			bool firstOnAnyHex = false;
+			for(BattleHex hex : st->getHexes())
+			{
+				if(hex.isValid() && area.test(hex))
+				{
+					area.reset(hex);
+					firstOnAnyHex = true;
+				}
+			}
+
+			if(firstOnAnyHex && mainFilter(st))
+				attackedCres.insert(st);
 		}
 	}
 
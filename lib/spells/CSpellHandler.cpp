@@ -85,7 +85,7 @@ namespace SpellConfig
 CSpell::LevelInfo::LevelInfo()
 	:description(""),cost(0),power(0),AIValue(0),smartTarget(true), clearTarget(false), clearAffected(false), range("0")
 {
-
+	parseRange();
 }
 
 CSpell::LevelInfo::~LevelInfo()
@@ -93,6 +93,27 @@ CSpell::LevelInfo::~LevelInfo()
 
 }
 
+void CSpell::LevelInfo::parseRange()
+{
+	//range is comma separated list of distances ("1") or distance intervals ("0-2"), "X" means whole battlefield
+	rangeLayers.clear();
+	if(range.empty() || range[0] == 'X')
+		return;
+
+	std::vector<std::string> parts;
+	boost::split(parts, range, boost::is_any_of(","));
+	for(const auto & part : parts)
+	{
+		if(part.empty())
+			continue;
+
+		const size_t dash = part.find('-');
+		const int first = atoi(part.substr(0, dash).c_str());
+		const int last = dash == std::string::npos ? first : atoi(part.substr(dash + 1).c_str());
+		rangeLayers.push_back(std::make_pair(first, last));
+	}
+}
+
 ///CSpell
 CSpell::CSpell():
 	id(SpellID::NONE), level(0),
@@ -1006,6 +1027,7 @@ CSpell * CSpellHandler::loadFromJson(const JsonNode & json, const std::string &
 		levelObject.clearTarget   = levelNode["targetModifier"]["clearTarget"].Bool();
 		levelObject.clearAffected = levelNode["targetModifier"]["clearAffected"].Bool();
 		levelObject.range         = levelNode["range"].String();
+		levelObject.parseRange();
 
 		for(const auto & elem : levelNode["effects"].Struct())
 		{
@@ -124,7 +124,7 @@ public:
 		std::string selectProjectile(const double angle) const;
 	} animationInfo;
 public:
-	struct LevelInfo
+	struct DLL_LINKAGE LevelInfo
 	{
 		std::string description; //descriptions of spell for skill level
 		si32 cost;
@@ -135,6 +135,7 @@ public:
 		bool clearTarget;
 		bool clearAffected;
 		std::string range;
+		std::vector<std::pair<int, int>> rangeLayers; //range parsed to rings around central hex, first and last distance of each part
 
 		std::vector<std::shared_ptr<Bonus>> effects;
 		std::vector<std::shared_ptr<Bonus>> cumulativeEffects;
@@ -142,6 +143,8 @@ public:
 		LevelInfo();
 		~LevelInfo();
 
+		void parseRange(); //updates rangeLayers, has to be called whenever range changes
+
 		template <typename Handler> void serialize(Handler &h, const int version)
 		{
 			h & description;
@@ -150,6 +153,8 @@ public:
 			h & AIValue;
 			h & smartTarget;
 			h & range;
+			if(!h.saving)
+				parseRange();
 
 			if(version >= 773)
 			{
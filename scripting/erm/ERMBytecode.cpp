@@ -0,0 +1,617 @@
+/*
+ * ERMBytecode.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "ERMBytecode.h"
+
+#include "ERMInterpreter.h"
+
+using namespace VERMInterpreter;
+
+namespace
+{
+	int & intVar(ERMInterpreter * erm, const Operand & op)
+	{
+		switch(op.kind)
+		{
+		case Operand::GLOBAL:
+			return *static_cast<int *>(op.address);
+		case Operand::FUNC_PARAM:
+			if(!erm->curFunc)
+				throw EIexpProblem("Function parameters cannot be used outside a function!");
+			return erm->curFunc->getParam(op.value);
+		case Operand::FUNC_LOCAL:
+			return (erm->curFunc ? erm->curFunc : erm->getFuncVars(0))->getLocal(op.value); //global set outside functions
+		case Operand::TRIGGER_LOCAL:
+			if(!erm->curTrigger)
+				throw EIexpProblem("Trigger local variables cannot be used outside triggers!");
+			return erm->curTrigger->ermLocalVars.getYvar(op.value);
+		default:
+			throw EInterpreterError("Operand is not an integer variable!");
+		}
+	}
+
+	int intValue(ERMInterpreter * erm, const Operand & op)
+	{
+		switch(op.kind)
+		{
+		case Operand::CONSTANT:
+			return op.value;
+		case Operand::CHAIN:
+			return erm->getVar(op.chain->varsym, op.chain->val).getInt();
+		default:
+			return intVar(erm, op);
+		}
+	}
+
+	double & floatVar(ERMInterpreter * erm, const Operand & op)
+	{
+		switch(op.kind)
+		{
+		case Operand::FUNC_FLOAT:
+			if(!erm->curFunc)
+				throw EIexpProblem("Function context not available!");
+			return erm->curFunc->getFloat(op.value);
+		case Operand::TRIGGER_FLOAT:
+			if(!erm->curTrigger)
+				throw EIexpProblem("No trigger context available!");
+			return erm->curTrigger->ermLocalVars.getEvar(op.value);
+		default:
+			throw EInterpreterError("Operand is not a floating point variable!");
+		}
+	}
+
+	double floatValue(ERMInterpreter * erm, const Operand & op)
+	{
+		if(op.kind == Operand::CHAIN)
+			return erm->getVar(op.chain->varsym, op.chain->val).getFloat();
+		return floatVar(erm, op);
+	}
+
+	std::string & stringVar(ERMInterpreter * erm, const Operand & op)
+	{
+		switch(op.kind)
+		{
+		case Operand::GLOBAL:
+			return *static_cast<std::string *>(op.address);
+		case Operand::FUNC_STRING:
+			if(!erm->curFunc)
+				throw EIexpProblem("Function local string variables cannot be used outside functions!");
+			return erm->curFunc->getString(op.value);
+		default:
+			throw EInterpreterError("Operand is not a string variable!");
+		}
+	}
+
+	std::string stringValue(ERMInterpreter * erm, const Operand & op)
+	{
+		if(op.kind == Operand::CHAIN)
+			return erm->getVar(op.chain->varsym, op.chain->val).getString();
+		return stringVar(erm, op);
+	}
+
+	template<typename T>
+	bool compare(const T & lhs, const T & rhs, ConditionTerm::ECompare cmp)
+	{
+		switch(cmp)
+		{
+		case ConditionTerm::LT:
+			return lhs < rhs;
+		case ConditionTerm::GT:
+			return lhs > rhs;
+		case ConditionTerm::LE:
+			return lhs <= rhs;
+		case ConditionTerm::GE:
+			return lhs >= rhs;
+		case ConditionTerm::EQ:
+			return lhs == rhs;
+		case ConditionTerm::NE:
+			return lhs != rhs;
+		default:
+			throw EInterpreterError("Wrong comparison in compiled condition!");
+		}
+	}
+}
+
+void Bytecode::run(ERMInterpreter * erm) const
+{
+	//identifier of the VR receiver being executed
+	int * intTarget = nullptr;
+	double * floatTarget = nullptr;
+	std::string * stringTarget = nullptr;
+
+	size_t pc = 0;
+	while(pc < code.size())
+	{
+		const Instruction & ins = code[pc++];
+		switch(ins.opcode)
+		{
+		case Instruction::JUMP_UNLESS:
+			if(!checkCondition(erm, ins.a, ins.a + ins.b))
+				pc = ins.c;
+			break;
+		case Instruction::SELECT_INT:
+			intTarget = &intVar(erm, operands[ins.a]);
+			break;
+		case Instruction::SELECT_FLOAT:
+			floatTarget = &floatVar(erm, operands[ins.a]);
+			break;
+		case Instruction::SELECT_STRING:
+			stringTarget = &stringVar(erm, operands[ins.a]);
+			break;
+		case Instruction::SET_INT:
+			*intTarget = intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::ADD_INT:
+			*intTarget += intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::SUB_INT:
+			*intTarget -= intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::MUL_INT:
+			*intTarget *= intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::DIV_INT:
+			*intTarget /= intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::MOD_INT:
+			*intTarget %= intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::AND_INT:
+			*intTarget &= intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::OR_INT:
+			*intTarget |= intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::XOR_INT:
+			*intTarget ^= intValue(erm, operands[ins.a]);
+			break;
+		case Instruction::SET_FLOAT:
+			*floatTarget = floatValue(erm, operands[ins.a]);
+			break;
+		case Instruction::ADD_FLOAT:
+			*floatTarget += floatValue(erm, operands[ins.a]);
+			break;
+		case Instruction::SUB_FLOAT:
+			*floatTarget -= floatValue(erm, operands[ins.a]);
+			break;
+		case Instruction::MUL_FLOAT:
+			*floatTarget *= floatValue(erm, operands[ins.a]);
+			break;
+		case Instruction::DIV_FLOAT:
+			*floatTarget /= floatValue(erm, operands[ins.a]);
+			break;
+		case Instruction::SET_STRING:
+			*stringTarget = stringValue(erm, operands[ins.a]);
+			break;
+		case Instruction::APPEND_STRING:
+			*stringTarget += stringValue(erm, operands[ins.a]);
+			break;
+		case Instruction::SET_STRING_CONSTANT:
+			*stringTarget = strings[ins.a];
+			break;
+		case Instruction::CALL_FUNCTION:
+			{
+				int funNum = intValue(erm, operands[ins.a]),
+					startVal = intValue(erm, operands[ins.a + 1]),
+					stopVal = intValue(erm, operands[ins.a + 2]),
+					increment = intValue(erm, operands[ins.a + 3]);
+				erm->callFunction(funNum, startVal, stopVal, increment);
+			}
+			break;
+		case Instruction::INTERPRET_LINE:
+			erm->executeLine(*lines[ins.a]);
+			break;
+		default:
+			throw EInterpreterError("Wrong opcode in compiled trigger!");
+		}
+	}
+}
+
+bool Bytecode::checkCondition(ERMInterpreter * erm, int term, int end) const
+{
+	const ConditionTerm & ct = conditionTerms[term];
+	bool ret;
+	if(ct.compare == ConditionTerm::FLAG)
+	{
+		ret = *ct.flag;
+	}
+	else
+	{
+		const Operand & lhs = operands[ct.lhs], & rhs = operands[ct.rhs];
+		switch(lhs.type)
+		{
+		case Operand::INT:
+			ret = compare(intValue(erm, lhs), intValue(erm, rhs), ct.compare);
+			break;
+		case Operand::FLOAT:
+			ret = compare(floatValue(erm, lhs), floatValue(erm, rhs), ct.compare);
+			break;
+		default:
+			ret = compare(stringValue(erm, lhs), stringValue(erm, rhs), ct.compare);
+			break;
+		}
+	}
+
+	if(term + 1 < end)
+	{
+		bool rhs = checkCondition(erm, term + 1, end);
+		switch(ct.connective)
+		{
+		case '&':
+			ret &= rhs;
+			break;
+		case '|':
+			ret |= rhs;
+			break;
+		default:
+			ret ^= rhs;
+			break;
+		}
+	}
+	return ret;
+}
+
+BytecodeCompiler::BytecodeCompiler(ERMInterpreter * Erm) : erm(Erm), out(std::make_shared<Bytecode>()),
+	compiledLines(0), interpretedLines(0)
+{}
+
+void BytecodeCompiler::compileLine(const ERM::TLine & line)
+{
+	if(line.which() == 1) //erm
+	{
+		const ERM::TERMline & ermline = boost::get<ERM::TERMline>(line);
+		if(ermline.which() != 0)
+			return; //comment or nothing
+
+		//roll back whatever was emitted for a line that turns out not to be compilable
+		const size_t codeSize = out->code.size(), operandsSize = out->operands.size(),
+			termsSize = out->conditionTerms.size(), stringsSize = out->strings.size();
+		if(compileCommand(boost::get<ERM::Tcommand>(ermline)))
+		{
+			compiledLines++;
+			return;
+		}
+		out->code.erase(out->code.begin() + codeSize, out->code.end());
+		out->operands.resize(operandsSize);
+		out->conditionTerms.resize(termsSize);
+		out->strings.resize(stringsSize);
+	}
+
+	out->code.push_back(Instruction(Instruction::INTERPRET_LINE, out->lines.size()));
+	out->lines.push_back(&line);
+	interpretedLines++;
+}
+
+std::shared_ptr<const Bytecode> BytecodeCompiler::finish()
+{
+	std::shared_ptr<const Bytecode> ret = out;
+	out = std::make_shared<Bytecode>();
+	return ret;
+}
+
+bool BytecodeCompiler::compileCommand(const ERM::Tcommand & cmd)
+{
+	switch(cmd.cmd.which())
+	{
+	case 1: //instruction, does nothing during trigger execution
+		return true;
+	case 2: //receiver
+		return compileReceiver(boost::get<ERM::Treceiver>(cmd.cmd));
+	default: //triggers end the body and are never compiled
+		return false;
+	}
+}
+
+bool BytecodeCompiler::compileReceiver(const ERM::Treceiver & rec)
+{
+	size_t jump = out->code.size();
+	if(rec.condition.is_initialized() && !compileCondition(rec.condition.get()))
+		return false;
+
+	bool ok;
+	if(rec.name == "VR")
+		ok = compileVR(rec);
+	else if(rec.name == "DO")
+		ok = compileDO(rec);
+	else
+		ok = false;
+
+	if(ok && rec.condition.is_initialized())
+		out->code[jump].c = out->code.size();
+	return ok;
+}
+
+bool BytecodeCompiler::compileVR(const ERM::Treceiver & rec)
+{
+	if(!rec.identifier.is_initialized() || rec.identifier.get().size() != 1)
+		return false;
+
+	int target = compileOperand(rec.identifier.get()[0]);
+	if(target < 0)
+		return false;
+	const Operand::EType type = out->operands[target].type;
+	if(out->operands[target].kind == Operand::CONSTANT || out->operands[target].kind == Operand::CHAIN)
+		return false; //not assignable here
+
+	static const Instruction::EOpcode selects[] = {Instruction::SELECT_INT, Instruction::SELECT_FLOAT, Instruction::SELECT_STRING};
+	out->code.push_back(Instruction(selects[type], target));
+
+	if(!rec.body.is_initialized())
+		return true;
+
+	for(const ERM::TBodyOption & option : rec.body.get())
+	{
+		Instruction::EOpcode opcode;
+		int operand;
+		switch(option.which())
+		{
+		case 0: //logic
+			{
+				const ERM::TVRLogic & logic = boost::get<ERM::TVRLogic>(option);
+				operand = compileOperand(logic.var);
+				if(type != Operand::INT || operand < 0 || out->operands[operand].type != Operand::INT)
+					return false;
+
+				switch(logic.opcode)
+				{
+				case '&':
+					opcode = Instruction::AND_INT;
+					break;
+				case '|':
+					opcode = Instruction::OR_INT;
+					break;
+				case 'X':
+					opcode = Instruction::XOR_INT;
+					break;
+				default:
+					return false;
+				}
+			}
+			break;
+		case 1: //arithmetic
+			{
+				const ERM::TVRArithmetic & arithmetic = boost::get<ERM::TVRArithmetic>(option);
+				operand = compileOperand(arithmetic.rhs);
+				if(operand < 0 || out->operands[operand].type != type)
+					return false;
+
+				static const std::string opcodes = "+-*:%";
+				static const Instruction::EOpcode intOps[] = {Instruction::ADD_INT, Instruction::SUB_INT,
+					Instruction::MUL_INT, Instruction::DIV_INT, Instruction::MOD_INT};
+				static const Instruction::EOpcode floatOps[] = {Instruction::ADD_FLOAT, Instruction::SUB_FLOAT,
+					Instruction::MUL_FLOAT, Instruction::DIV_FLOAT};
+
+				size_t op = opcodes.find(arithmetic.opcode);
+				if(op == std::string::npos)
+					return false;
+				if(type == Operand::INT)
+					opcode = intOps[op];
+				else if(type == Operand::FLOAT && op < ARRAY_COUNT(floatOps))
+					opcode = floatOps[op];
+				else if(type == Operand::STRING && arithmetic.opcode == '+')
+					opcode = Instruction::APPEND_STRING;
+				else
+					return false;
+			}
+			break;
+		default:
+			{
+				const ERM::TNormalBodyOption & normal = boost::get<ERM::TNormalBodyOption>(option);
+				if(normal.optionCode != 'S' || normal.params.size() != 1)
+					return false; //other options are not implemented by the interpreter either
+
+				const ERM::TBodyOptionItem & item = normal.params[0];
+				if(item.type() == typeid(ERM::TStringConstant))
+				{
+					if(type != Operand::STRING)
+						return false;
+					opcode = Instruction::SET_STRING_CONSTANT;
+					operand = out->strings.size();
+					out->strings.push_back(boost::get<ERM::TStringConstant>(item).str);
+				}
+				else if(item.type() == typeid(ERM::TIexp))
+				{
+					operand = compileOperand(boost::get<ERM::TIexp>(item));
+					if(operand < 0 || out->operands[operand].type != type)
+						return false;
+
+					static const Instruction::EOpcode sets[] = {Instruction::SET_INT, Instruction::SET_FLOAT, Instruction::SET_STRING};
+					opcode = sets[type];
+				}
+				else
+					return false;
+			}
+			break;
+		}
+		out->code.push_back(Instruction(opcode, operand));
+	}
+	return true;
+}
+
+bool BytecodeCompiler::compileDO(const ERM::Treceiver & rec)
+{
+	if(!rec.identifier.is_initialized())
+		return true; //no call
+
+	const ERM::Tidentifier & tid = rec.identifier.get();
+	if(tid.size() != 4)
+		return false;
+
+	//operands of the call have to be consecutive
+	std::vector<Operand> args;
+	for(const ERM::TIdentifierInternal & item : tid)
+	{
+		int operand = compileOperand(item);
+		if(operand < 0 || out->operands[operand].type != Operand::INT)
+			return false;
+		args.push_back(out->operands[operand]);
+	}
+	out->code.push_back(Instruction(Instruction::CALL_FUNCTION, out->operands.size()));
+	out->operands.insert(out->operands.end(), args.begin(), args.end());
+	return true;
+}
+
+bool BytecodeCompiler::compileCondition(const ERM::Tcondition & cond)
+{
+	const int first = out->conditionTerms.size();
+	for(const ERM::Tcondition * cur = &cond; cur; cur = cur->rhs.is_initialized() ? &cur->rhs.get().get() : nullptr)
+	{
+		ConditionTerm term;
+		if(cur->rhs.is_initialized())
+		{
+			if(cur->ctype != '&' && cur->ctype != '|' && cur->ctype != 'X')
+				return false;
+			term.connective = cur->ctype;
+		}
+
+		if(cur->cond.which() == 1) //flag
+		{
+			int flag = boost::get<int>(cur->cond);
+			if(flag < 1 || flag > ERMEnvironment::NUM_FLAGS)
+				return false;
+			term.flag = &erm->ermGlobalEnv->getFlag(flag);
+		}
+		else
+		{
+			const ERM::TComparison & cmp = boost::get<ERM::TComparison>(cur->cond);
+			static const std::map<std::string, ConditionTerm::ECompare> signs =
+			{
+				{"<", ConditionTerm::LT}, {">", ConditionTerm::GT}, {"<=", ConditionTerm::LE}, {"=<", ConditionTerm::LE},
+				{">=", ConditionTerm::GE}, {"=>", ConditionTerm::GE}, {"==", ConditionTerm::EQ}, {"<>", ConditionTerm::NE},
+				{"><", ConditionTerm::NE}
+			};
+			auto sign = signs.find(cmp.compSign);
+			if(sign == signs.end())
+				return false;
+
+			term.compare = sign->second;
+			term.lhs = compileOperand(cmp.lhs);
+			term.rhs = compileOperand(cmp.rhs);
+			if(term.lhs < 0 || term.rhs < 0 || out->operands[term.lhs].type != out->operands[term.rhs].type)
+				return false;
+		}
+		out->conditionTerms.push_back(term);
+	}
+
+	out->code.push_back(Instruction(Instruction::JUMP_UNLESS, first, out->conditionTerms.size() - first));
+	return true;
+}
+
+int BytecodeCompiler::compileOperand(const ERM::TIdentifierInternal & tid)
+{
+	if(tid.which() != 0)
+		return -1;
+	return compileOperand(boost::get<ERM::TIexp>(tid));
+}
+
+int BytecodeCompiler::compileOperand(const ERM::TIexp & iexp)
+{
+	Operand op;
+	if(iexp.which() == 1)
+	{
+		op.value = boost::get<int>(iexp);
+	}
+	else
+	{
+		const ERM::TVarExp & var = boost::get<ERM::TVarExp>(iexp);
+		if(var.which() == 0)
+		{
+			if(!compileVariable(boost::get<ERM::TVarExpNotMacro>(var), op))
+				return -1;
+		}
+		else
+		{
+			//macros are bound before scripts are executed
+			auto binding = erm->ermGlobalEnv->macroBindings.find(boost::get<ERM::TMacroUsage>(var).macro);
+			if(binding == erm->ermGlobalEnv->macroBindings.end() || !compileVariable(binding->second, op))
+				return -1;
+		}
+	}
+
+	out->operands.push_back(op);
+	return out->operands.size() - 1;
+}
+
+bool BytecodeCompiler::compileVariable(const ERM::TVarExpNotMacro & var, Operand & op)
+{
+	const std::string & sym = var.varsym;
+	if(var.questionMark.is_initialized() || sym.empty())
+		return false;
+
+	const char letter = sym[0];
+	if(letter == 'e')
+		op.type = Operand::FLOAT;
+	else if(letter == 'z')
+		op.type = Operand::STRING;
+	else if((letter >= 'f' && letter <= 't') || letter == 'v' || letter == 'x' || letter == 'y')
+		op.type = Operand::INT;
+	else
+		return false;
+
+	if(sym.size() > 1)
+	{
+		op.kind = Operand::CHAIN;
+		op.chain = &var;
+		return true;
+	}
+
+	if(letter >= 'f' && letter <= 't')
+	{
+		op.kind = Operand::GLOBAL;
+		op.address = &erm->ermGlobalEnv->getQuickVar(letter);
+		return true;
+	}
+
+	if(!var.val.is_initialized())
+		return false;
+	const int num = var.val.get();
+	op.value = num;
+
+	switch(letter)
+	{
+	case 'e':
+		if(num > 0 && num <= FunctionLocalVars::NUM_FLOATINGS)
+			op.kind = Operand::FUNC_FLOAT;
+		else if(num < 0 && num >= -TriggerLocalVars::EVAR_NUM)
+			op.kind = Operand::TRIGGER_FLOAT;
+		else
+			return false;
+		break;
+	case 'v':
+		if(num < 1 || num > ERMEnvironment::NUM_STANDARDS)
+			return false;
+		op.kind = Operand::GLOBAL;
+		op.address = &erm->ermGlobalEnv->getStandardVar(num);
+		break;
+	case 'x':
+		op.kind = Operand::FUNC_PARAM;
+		break;
+	case 'y':
+		if(num > 0 && num <= FunctionLocalVars::NUM_LOCALS)
+			op.kind = Operand::FUNC_LOCAL;
+		else if(num < 0 && num >= -TriggerLocalVars::YVAR_NUM)
+			op.kind = Operand::TRIGGER_LOCAL;
+		else
+			return false;
+		break;
+	case 'z':
+		if(num > ERMEnvironment::NUM_STRINGS || num == 0)
+			return false;
+		if(num > 0)
+		{
+			op.kind = Operand::GLOBAL;
+			op.address = &erm->ermGlobalEnv->getZVar(num);
+		}
+		else
+			op.kind = Operand::FUNC_STRING;
+		break;
+	}
+	return true;
+}
@@ -0,0 +1,114 @@
+/*
+ * ERMBytecode.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "ERMParser.h"
+
+class ERMInterpreter;
+
+namespace VERMInterpreter
+{
+	//Trigger bodies are compiled when scripts are loaded. Lines the compiler doesn't handle (VERM, most receivers)
+	//are kept as ASTs and passed to the interpreter when reached, so both ways of execution behave the same.
+
+	//variable or constant used by compiled code, resolved as far as it can be done before execution
+	struct Operand
+	{
+		enum EKind : ui8
+		{
+			CONSTANT, //value
+			GLOBAL, //address of a quick, v or z variable
+			FUNC_PARAM, FUNC_LOCAL, FUNC_FLOAT, FUNC_STRING, //value is the index in the current function's variables
+			TRIGGER_LOCAL, TRIGGER_FLOAT, //value is the index in the current trigger's variables
+			CHAIN //indirect variables like vy5, followed by the interpreter at execution time
+		};
+		enum EType : ui8 {INT, FLOAT, STRING};
+
+		EKind kind;
+		EType type;
+		int value;
+		void * address;
+		const ERM::TVarExpNotMacro * chain; //points into the script AST
+
+		Operand() : kind(CONSTANT), type(INT), value(0), address(nullptr), chain(nullptr)
+		{}
+	};
+
+	//one comparison or flag of a condition; terms are combined right to left, like in ERMInterpreter::checkCondition
+	struct ConditionTerm
+	{
+		enum ECompare : ui8 {FLAG, LT, GT, LE, GE, EQ, NE};
+
+		ECompare compare;
+		char connective; //'&', '|' or 'X' joining this term with the following ones
+		int lhs, rhs; //operands
+		const bool * flag;
+
+		ConditionTerm() : compare(FLAG), connective(0), lhs(-1), rhs(-1), flag(nullptr)
+		{}
+	};
+
+	struct Instruction
+	{
+		enum EOpcode : ui8
+		{
+			JUMP_UNLESS, //a - first condition term, b - number of terms, c - target
+			SELECT_INT, SELECT_FLOAT, SELECT_STRING, //VR identifier; a - operand
+			SET_INT, ADD_INT, SUB_INT, MUL_INT, DIV_INT, MOD_INT, AND_INT, OR_INT, XOR_INT, //a - operand
+			SET_FLOAT, ADD_FLOAT, SUB_FLOAT, MUL_FLOAT, DIV_FLOAT, //a - operand
+			SET_STRING, APPEND_STRING, //a - operand
+			SET_STRING_CONSTANT, //a - string
+			CALL_FUNCTION, //DO receiver; a - first of four operands
+			INTERPRET_LINE //a - line
+		};
+
+		EOpcode opcode;
+		int a, b, c;
+
+		Instruction(EOpcode Opcode, int A = 0, int B = 0, int C = 0) : opcode(Opcode), a(A), b(B), c(C)
+		{}
+	};
+
+	struct Bytecode
+	{
+		std::vector<Instruction> code;
+		std::vector<Operand> operands;
+		std::vector<ConditionTerm> conditionTerms;
+		std::vector<std::string> strings;
+		std::vector<const ERM::TLine *> lines; //not owning, point into ERMInterpreter::scripts
+
+		void run(ERMInterpreter * erm) const;
+
+	private:
+		bool checkCondition(ERMInterpreter * erm, int term, int end) const;
+	};
+
+	class BytecodeCompiler
+	{
+		ERMInterpreter * erm;
+		std::shared_ptr<Bytecode> out;
+
+		bool compileCommand(const ERM::Tcommand & cmd);
+		bool compileReceiver(const ERM::Treceiver & rec);
+		bool compileVR(const ERM::Treceiver & rec);
+		bool compileDO(const ERM::Treceiver & rec);
+		bool compileCondition(const ERM::Tcondition & cond);
+		int compileOperand(const ERM::TIexp & iexp); //-1 if it can't be compiled
+		int compileOperand(const ERM::TIdentifierInternal & tid);
+		bool compileVariable(const ERM::TVarExpNotMacro & var, Operand & op);
+
+	public:
+		int compiledLines, interpretedLines;
+
+		explicit BytecodeCompiler(ERMInterpreter * Erm);
+		void compileLine(const ERM::TLine & line);
+		std::shared_ptr<const Bytecode> finish();
+	};
+}
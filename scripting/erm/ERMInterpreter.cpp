@@ -9,8 +9,10 @@
  */
 #include "StdInc.h"
 #include "ERMInterpreter.h"
+#include "ERMBytecode.h"
 
 #include <cctype>
+#include "../../lib/CStopWatch.h"
 #include "../../lib/mapObjects/CObjectHandler.h"
 #include "../../lib/mapObjects/MapObjects.h"
 #include "../../lib/CHeroHandler.h"
@@ -462,6 +464,44 @@ void ERMInterpreter::scanScripts()
 	{
 		boost::apply_visitor(ScriptScanner(this, it->first), it->second);
 	}
+	indexTriggers();
+}
+
+void ERMInterpreter::indexTriggers()
+{
+	for(bool pre : {true, false})
+	{
+		TtriggerListType & triggerList = pre ? triggers : postTriggers;
+		TtriggerIndexType & indexList = pre ? triggerIndex : postTriggerIndex;
+		indexList.clear();
+		for(auto & triggersOfType : triggerList)
+		{
+			TriggerIndex & index = indexList[triggersOfType.first];
+			for(int g=0; g<triggersOfType.second.size(); ++g)
+			{
+				const ERM::TTriggerBase & trig = retrieveTrigger(retrieveLine(triggersOfType.second[g].line));
+				bool constant = trig.identifier.is_initialized();
+				std::vector<int> values;
+				if(constant)
+				{
+					for(const ERM::TIdentifierInternal & item : trig.identifier.get())
+					{
+						if(item.which() != 0 || boost::get<ERM::TIexp>(item).which() != 1) //not an integral constant
+						{
+							constant = false;
+							break;
+						}
+						values.push_back(boost::get<int>(boost::get<ERM::TIexp>(item)));
+					}
+				}
+
+				if(constant)
+					index.byIdentifier[values].push_back(g);
+				else
+					index.unindexed.push_back(g);
+			}
+		}
+	}
 }
 
 ERMInterpreter::ERMInterpreter()
@@ -469,6 +509,7 @@ ERMInterpreter::ERMInterpreter()
 	erm = this;
 	curFunc = nullptr;
 	curTrigger = nullptr;
+	useBytecode = true;
 	globalEnv = new Environment();
 	topDyn = globalEnv;
 }
@@ -487,21 +528,87 @@ void ERMInterpreter::executeTrigger(VERMInterpreter::Trigger & trig, int funNum,
 	else
 		curFunc = getFuncVars(0);
 
-	//skip the first line
-	LinePointer lp = trig.line;
-	++lp;
-	for(; lp.isValid(); ++lp)
+	if(useBytecode && trig.bytecode)
 	{
-		ERM::TLine curLine = retrieveLine(lp);
-		if(isATrigger(curLine))
-			break;
+		trig.bytecode->run(this);
+	}
+	else
+	{
+		//skip the first line
+		LinePointer lp = trig.line;
+		++lp;
+		for(; lp.isValid(); ++lp)
+		{
+			ERM::TLine curLine = retrieveLine(lp);
+			if(isATrigger(curLine))
+				break;
 
-		executeLine(lp);
+			executeLine(lp);
+		}
 	}
 
 	curFunc = nullptr;
 }
 
+void ERMInterpreter::callFunction(int funNum, int startVal, int stopVal, int increment)
+{
+	for(int it = startVal; it < stopVal; it += increment)
+	{
+		std::vector<int> params(FunctionLocalVars::NUM_PARAMETERS, 0);
+		params.back() = it;
+		//owner->getFuncVars(funNum)->getParam(16) = it;
+
+		std::vector<int> v1;
+		v1.push_back(funNum);
+		ERMInterpreter::TIDPattern tip = {{v1.size(), v1}};
+		executeTriggerType(TriggerType("FU"), true, tip, params);
+		it = getFuncVars(funNum)->getParam(16);
+	}
+}
+
+void ERMInterpreter::compileScripts()
+{
+	BytecodeCompiler compiler(this);
+	int compiledTriggers = 0;
+	for(TtriggerListType * triggerList : {&triggers, &postTriggers})
+	{
+		for(auto & triggersOfType : *triggerList)
+		{
+			for(Trigger & trig : triggersOfType.second)
+			{
+				//skip the first line
+				LinePointer lp = trig.line;
+				++lp;
+				for(; lp.isValid(); ++lp)
+				{
+					const ERM::TLine & curLine = retrieveLine(lp);
+					if(isATrigger(curLine))
+						break;
+
+					compiler.compileLine(curLine);
+				}
+				trig.bytecode = compiler.finish();
+				compiledTriggers++;
+			}
+		}
+	}
+	logGlobal->debug("Compiled %d ERM triggers, %d lines compiled, %d lines left for the interpreter", compiledTriggers, compiler.compiledLines, compiler.interpretedLines);
+}
+
+void ERMInterpreter::benchmarkFunction(int funNum, int iterations)
+{
+	const bool usedBytecode = useBytecode;
+	for(bool bytecode : {false, true})
+	{
+		useBytecode = bytecode;
+		CStopWatch timer;
+		for(int g = 0; g < iterations; ++g)
+			callFunction(funNum, 0, 1, 1);
+		logGlobal->info("FU%d executed %d times by %s in %d ms", funNum, iterations, bytecode ? "bytecode" : "interpreter", timer.getDiff());
+	}
+	useBytecode = usedBytecode;
+}
+
 bool ERMInterpreter::isATrigger( const ERM::TLine & line )
 {
 	switch(line.which())
@@ -1333,18 +1440,7 @@ struct ERMExpDispatch : boost::static_visitor<>
 					stopVal = erm->getIexp(tid[2]).getInt(),
 					increment = erm->getIexp(tid[3]).getInt();
 
-				for(int it = startVal; it < stopVal; it += increment)
-				{
-					std::vector<int> params(FunctionLocalVars::NUM_PARAMETERS, 0);
-					params.back() = it;
-					//owner->getFuncVars(funNum)->getParam(16) = it;
-
-					std::vector<int> v1;
-					v1.push_back(funNum);
-					ERMInterpreter::TIDPattern tip = {{v1.size(), v1}};
-					erm->executeTriggerType(TriggerType("FU"), true, tip, params);
-					it = erm->getFuncVars(funNum)->getParam(16);
-				}
+				erm->callFunction(funNum, startVal, stopVal, increment);
 			}
 		}
 		else if(trig.name == "MA")
@@ -1787,18 +1883,52 @@ void ERMInterpreter::executeTriggerType(VERMInterpreter::TriggerType tt, bool pr
 		}
 	};
 	TtriggerListType & triggerList = pre ? triggers : postTriggers;
+	TtriggerIndexType & indexList = pre ? triggerIndex : postTriggerIndex;
 
 	TriggerIdentifierMatch tim;
 	tim.allowNoIdetifier = true;
 	tim.ermEnv = this;
 	tim.matchToIt = identifier;
 	std::vector<Trigger> & triggersToTry = triggerList[tt];
-	for(int g=0; g<triggersToTry.size(); ++g)
+	const TriggerIndex & index = indexList[tt];
+
+	//triggers to try in script order, second is true if the identifier is known to match
+	std::vector<std::pair<int, bool> > candidates;
+	bool indexable = true;
+	for(auto & pattern : identifier)
 	{
-		if(tim.tryMatch(&triggersToTry[g]))
+		if(pattern.first != pattern.second.size())
+			indexable = false;
+	}
+	if(indexable)
+	{
+		for(int g : index.unindexed)
+			candidates.push_back(std::make_pair(g, false));
+		for(auto & pattern : identifier)
 		{
-			curTrigger = &triggersToTry[g];
-			executeTrigger(triggersToTry[g], HLP::calcFunNum(tt, identifier), funParams);
+			auto it = index.byIdentifier.find(pattern.second);
+			if(it != index.byIdentifier.end())
+			{
+				for(int g : it->second)
+					candidates.push_back(std::make_pair(g, true));
+			}
+		}
+		boost::sort(candidates);
+	}
+	else
+	{
+		//pattern doesn't describe whole identifiers, try every trigger
+		for(int g=0; g<triggersToTry.size(); ++g)
+			candidates.push_back(std::make_pair(g, false));
+	}
+
+	for(auto & candidate : candidates)
+	{
+		Trigger & trig = triggersToTry[candidate.first];
+		if(candidate.second ? tim.checkCondition(&trig) : tim.tryMatch(&trig))
+		{
+			curTrigger = &trig;
+			executeTrigger(trig, HLP::calcFunNum(tt, identifier), funParams);
 		}
 	}
 }
@@ -2059,6 +2189,15 @@ bool TriggerIdentifierMatch::tryMatch( Trigger * interptrig ) const
 		return false;
 }
 
+bool TriggerIdentifierMatch::checkCondition( Trigger * interptrig ) const
+{
+	const ERM::TTriggerBase & trig = ERMInterpreter::retrieveTrigger(ermEnv->retrieveLine(interptrig->line));
+	if(trig.condition.is_initialized())
+		return ermEnv->checkCondition(trig.condition.get());
+	else //no condition
+		return true;
+}
+
 VERMInterpreter::ERMEnvironment::ERMEnvironment()
 {
 	for(int g=0; g<NUM_QUICKS; ++g)
@@ -2382,6 +2521,7 @@ void ERMInterpreter::init()
 
 	scanForScripts();
 	scanScripts();
+	compileScripts();
 
 	executeInstructions();
 	executeTriggerType("PI");
@@ -2752,6 +2892,27 @@ void ERMInterpreter::executeUserCommand(const std::string &cmd)
 			ERM::TLine line = ERMParser::parseLine(cmd);
 			executeLine(line);
 		}
+		else
+		{
+			std::istringstream readed(cmd);
+			std::string cn;
+			readed >> cn;
+			if(cn == "bytecode") //bytecode on|off
+			{
+				std::string mode;
+				readed >> mode;
+				useBytecode = mode != "off";
+				logGlobal->info("ERM triggers are executed by %s", useBytecode ? "bytecode" : "interpreter");
+			}
+			else if(cn == "benchmark") //benchmark <function> <iterations>
+			{
+				int funNum = 0, iterations = 1000;
+				readed >> funNum >> iterations;
+				benchmarkFunction(funNum, iterations);
+			}
+			else
+				logGlobal->error("Unknown ERM command: %s", cmd);
+		}
 	}
 	catch(std::exception &e)
 	{
@@ -275,11 +275,14 @@ namespace VERMInterpreter
 		std::vector<LexicalPtr> stack;
 	};
 
+	struct Bytecode;
+
 	struct Trigger
 	{
 		LinePointer line;
 		TriggerLocalVars ermLocalVars;
 		Stack * stack; //where we are stuck at execution
+		std::shared_ptr<const Bytecode> bytecode; //compiled body, see ERMInterpreter::compileScripts
 		Trigger() : stack(nullptr)
 		{}
 	};
@@ -602,6 +605,7 @@ struct TriggerIdentifierMatch
 	static const int MAX_SUBIDENTIFIERS = 16;
 	ERMInterpreter * ermEnv;
 	bool tryMatch(VERMInterpreter::Trigger * interptrig) const;
+	bool checkCondition(VERMInterpreter::Trigger * interptrig) const; //for triggers with already matched identifier
 };
 
 struct IexpValStr
@@ -793,6 +797,16 @@ class ERMInterpreter : public CScriptingModule
 	VERMInterpreter::ERMEnvironment * ermGlobalEnv;
 	typedef std::map<VERMInterpreter::TriggerType, std::vector<VERMInterpreter::Trigger> > TtriggerListType;
 	TtriggerListType triggers, postTriggers;
+
+	//positions of triggers in their list, triggers with constant identifiers are looked up by identifier values
+	struct TriggerIndex
+	{
+		std::map<std::vector<int>, std::vector<int> > byIdentifier;
+		std::vector<int> unindexed; //triggers without identifier or with one that has to be evaluated
+	};
+	typedef std::map<VERMInterpreter::TriggerType, TriggerIndex> TtriggerIndexType;
+	TtriggerIndexType triggerIndex, postTriggerIndex;
+	void indexTriggers();
 	VERMInterpreter::Trigger * curTrigger;
 	VERMInterpreter::FunctionLocalVars * curFunc;
 	static const int TRIG_FUNC_NUM = 30000;
@@ -810,6 +824,10 @@ class ERMInterpreter : public CScriptingModule
 	void executeLine(const VERMInterpreter::LinePointer & lp);
 	void executeLine(const ERM::TLine &line);
 	void executeTrigger(VERMInterpreter::Trigger & trig, int funNum = -1, std::vector<int> funParams=std::vector<int>());
+	void callFunction(int funNum, int startVal, int stopVal, int increment); //DO receiver
+	bool useBytecode; //if false, trigger bodies are executed line by line (reference implementation)
+	void compileScripts();
+	void benchmarkFunction(int funNum, int iterations); //runs FU trigger both ways and logs the times
 	static bool isCMDATrigger(const ERM::Tcommand & cmd);
 	static bool isATrigger(const ERM::TLine & line);
 	static ERM::EVOtions getExpType(const ERM::TVOption & opt);
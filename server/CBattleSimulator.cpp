@@ -0,0 +1,577 @@
+/*
+ * CBattleSimulator.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CBattleSimulator.h"
+
+#include <boost/program_options.hpp>
+
+#include "CGameHandler.h"
+#include "../CCallback.h"
+#include "../lib/CGameState.h"
+#include "../lib/CGameInterface.h"
+#include "../lib/CStack.h"
+#include "../lib/NetPacks.h"
+#include "../lib/battle/BattleInfo.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/mapObjects/CGHeroInstance.h"
+#include "../lib/CArtHandler.h"
+#include "../lib/CCreatureHandler.h"
+#include "../lib/CHeroHandler.h"
+#include "../lib/spells/CSpellHandler.h"
+#include "../lib/StringConstants.h"
+#include "../lib/CThreadHelper.h"
+#include "../lib/CConsoleHandler.h"
+#include "../lib/CConfigHandler.h"
+#include "../lib/VCMI_Lib.h"
+#include "../lib/VCMIDirs.h"
+#include "../lib/filesystem/Filesystem.h"
+#include "../lib/logging/CBasicLogConfigurator.h"
+
+std::atomic<bool> serverShuttingDown(false); //referenced by game handler, simulator never shuts down in the middle of battle
+
+//CCallback.cpp is part of client, simulator has no connection to send requests through
+CBattleCallback::CBattleCallback(CGameState * GS, boost::optional<PlayerColor> Player, CClient * C)
+{
+	gs = GS;
+	player = Player;
+	cl = C;
+}
+
+int CBattleCallback::battleMakeAction(BattleAction * action)
+{
+	logGlobal->error("Battle callback without connection can't make actions");
+	return -1;
+}
+
+bool CBattleCallback::battleMakeTacticAction(BattleAction * action)
+{
+	logGlobal->error("Battle callback without connection can't make actions");
+	return false;
+}
+
+/// Callback of AI fighting simulated battle, its actions are executed immediately by game handler
+class CSimulatedBattleCallback : public CBattleCallback
+{
+	CGameHandler * gh;
+	BattleInfo * battle;
+
+public:
+	CSimulatedBattleCallback(CGameHandler * gh, BattleInfo * battle, PlayerColor player)
+		: CBattleCallback(gh->gameState(), player, nullptr), gh(gh), battle(battle)
+	{
+		waitTillRealize = false;
+		unlockGsWhenWaiting = false;
+		setBattle(battle);
+	}
+
+	int battleMakeAction(BattleAction * action) override
+	{
+		assert(action->actionType == Battle::HERO_SPELL);
+		gh->makeCustomAction(battle, *action);
+		return 0;
+	}
+
+	bool battleMakeTacticAction(BattleAction * action) override
+	{
+		assert(battleTacticDist());
+		return gh->makeBattleAction(battle, *action);
+	}
+};
+
+/// State of one battle, owned by thread fighting it
+struct CBattleSimulator::Fight
+{
+	Scenario & scenario;
+	BattleInfo * battle;
+	std::array<std::shared_ptr<CSimulatedBattleCallback>, 2> callbacks;
+	std::array<std::shared_ptr<CBattleGameInterface>, 2> ais;
+	std::array<ui64, 2> actions;
+	std::array<si64, 2> thinkTime;
+	std::array<si64, 2> longestThinkTime;
+	bool failed;
+
+	Fight(Scenario & scenario)
+		: scenario(scenario), battle(nullptr), failed(false)
+	{
+		actions.fill(0);
+		thinkTime.fill(0);
+		longestThinkTime.fill(0);
+	}
+};
+
+CBattleSimulator::Side::Side(const JsonNode & config)
+	: ai(config["ai"].String()), hero(-1)
+{
+	if(ai.empty())
+		ai = "BattleAI";
+	primarySkills.fill(-1);
+
+	const JsonNode & heroConfig = config["hero"];
+	if(!heroConfig.isNull())
+	{
+		hero = CHeroHandler::decodeHero(heroConfig["type"].String());
+		if(hero < 0)
+			throw std::runtime_error("Unknown hero " + heroConfig["type"].String());
+
+		for(int i = 0; i < GameConstants::PRIMARY_SKILLS; i++)
+		{
+			const JsonNode & value = heroConfig["primarySkills"][PrimarySkill::names[i]];
+			if(!value.isNull())
+				primarySkills[i] = value.Float();
+		}
+
+		if(!heroConfig["secondarySkills"].isNull())
+		{
+			secondarySkills = std::vector<std::pair<SecondarySkill, ui8>>();
+			for(auto & skill : heroConfig["secondarySkills"].Struct())
+			{
+				si32 id = CHeroHandler::decodeSkill(skill.first);
+				int level = vstd::find_pos(NSecondarySkill::levels, skill.second.String());
+				if(id < 0 || level <= 0)
+					throw std::runtime_error("Invalid secondary skill " + skill.first);
+				secondarySkills->push_back(std::make_pair(SecondarySkill(id), level));
+			}
+		}
+
+		for(auto & spell : heroConfig["spells"].Vector())
+		{
+			si32 id = CSpellHandler::decodeSpell(spell.String());
+			if(id < 0)
+				throw std::runtime_error("Unknown spell " + spell.String());
+			spells.insert(SpellID(id));
+		}
+	}
+
+	for(auto & stack : config["army"].Vector())
+	{
+		si32 id = CCreatureHandler::decodeCreature(stack["type"].String());
+		if(id < 0)
+			throw std::runtime_error("Unknown creature " + stack["type"].String());
+		army.push_back(std::make_pair(CreatureID(id), std::max<TQuantity>(1, stack["amount"].Float())));
+	}
+	if(army.empty() || army.size() > GameConstants::ARMY_SIZE)
+		throw std::runtime_error("Army must have 1 to 7 stacks");
+}
+
+CBattleSimulator::SideStats::SideStats()
+	: wins(0), actions(0), thinkTime(0), longestThinkTime(0)
+{
+}
+
+CBattleSimulator::Scenario::Scenario(const JsonNode & config)
+	: name(config["name"].String()), terrain(ETerrainType::GRASS), repeat(1), maxRounds(100),
+	battles(0), draws(0), errors(0), rounds(0)
+{
+	if(!config["terrain"].isNull())
+	{
+		int pos = vstd::find_pos(GameConstants::TERRAIN_NAMES, config["terrain"].String());
+		if(pos < 0)
+			throw std::runtime_error("Unknown terrain " + config["terrain"].String());
+		terrain = ETerrainType(pos);
+	}
+	if(!config["repeat"].isNull())
+		repeat = std::max<si64>(1, config["repeat"].Float());
+	if(!config["maxRounds"].isNull())
+		maxRounds = std::max<si64>(1, config["maxRounds"].Float());
+
+	for(auto & side : config["sides"].Vector())
+		sides.push_back(Side(side));
+	if(sides.size() != 2)
+		throw std::runtime_error("Battle " + name + " must have exactly two sides");
+}
+
+JsonNode CBattleSimulator::Scenario::report() const
+{
+	JsonNode ret;
+	ret["name"].String() = name;
+	ret["battles"].Integer() = battles;
+	ret["draws"].Integer() = draws;
+	ret["errors"].Integer() = errors;
+	ret["averageRounds"].Float() = battles ? double(rounds) / battles : 0;
+
+	for(int i = 0; i < 2; i++)
+	{
+		const SideStats & side = stats[i];
+
+		JsonNode entry;
+		entry["ai"].String() = sides[i].ai;
+		entry["wins"].Integer() = side.wins;
+		entry["winRate"].Float() = battles ? double(side.wins) / battles : 0;
+		entry["casualties"].setType(JsonNode::JsonType::DATA_STRUCT);
+		for(auto & casualty : side.casualties)
+			entry["casualties"][VLC->creh->creatures.at(casualty.first)->identifier].Float() = double(casualty.second) / battles;
+		entry["actions"].Integer() = side.actions;
+		entry["averageActionTime"].Float() = side.actions ? side.thinkTime / 1000.0 / side.actions : 0; //in milliseconds
+		entry["longestActionTime"].Float() = side.longestThinkTime / 1000.0;
+		ret["sides"].Vector().push_back(entry);
+	}
+	return ret;
+}
+
+CBattleSimulator::CBattleSimulator(const JsonNode & config)
+	: gh(make_unique<CGameHandler>()), seed(config["seed"].Float())
+{
+	for(auto & scenario : config["battles"].Vector())
+		scenarios.push_back(make_unique<Scenario>(scenario));
+
+	//battles have no map, it only holds armies fighting in them
+	gh->gs = new CGameState();
+	gh->gs->map = new CMap();
+	gh->packObserver = [this](CPackForClient * pack)
+	{
+		packApplied(pack);
+	};
+}
+
+CBattleSimulator::~CBattleSimulator() = default;
+
+JsonNode CBattleSimulator::run(int threads)
+{
+	std::vector<Scenario *> battles; //every scenario as many times as it should be fought
+	for(auto & scenario : scenarios)
+		battles.insert(battles.end(), scenario->repeat, scenario.get());
+
+	//every battle has two slots for its armies, vector is never resized while battles are fought
+	gh->gs->map->objects.resize(battles.size() * 2);
+
+	logGlobal->info("Simulating %d battles in %d threads", battles.size(), threads);
+	auto start = boost::posix_time::microsec_clock::universal_time();
+
+	std::atomic<ui32> nextBattle(0);
+	boost::thread_group workers;
+	for(int i = 0; i < threads; i++)
+	{
+		workers.create_thread([&]()
+		{
+			setThreadName("CBattleSimulator::worker");
+			for(ui32 number = nextBattle++; number < battles.size(); number = nextBattle++)
+				fight(*battles[number], number);
+		});
+	}
+	workers.join_all();
+
+	auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+	logGlobal->info("Simulation finished in %d ms", duration.total_milliseconds());
+
+	JsonNode report;
+	report["battles"].Integer() = battles.size();
+	report["threads"].Integer() = threads;
+	report["seconds"].Float() = duration.total_milliseconds() / 1000.0;
+	for(auto & scenario : scenarios)
+		report["scenarios"].Vector().push_back(scenario->report());
+	return report;
+}
+
+void CBattleSimulator::fight(Scenario & scenario, ui32 number)
+{
+	auto & rand = CRandomGenerator::getDefault();
+	rand.setSeed(seed + number);
+
+	Fight fight(scenario);
+	BattleID battleID = BattleID::NONE;
+	try
+	{
+		//obstacles are chosen by position of battle on map, use random one
+		const int3 tile(rand.nextInt(255), rand.nextInt(255), 0);
+		BFieldType battlefield = CGameState::battleGetBattlefieldType(scenario.terrain, rand);
+
+		{
+			//stacks of all battles are attached to the same creature nodes, so bonus tree is changed and read only under apply lock
+			boost::unique_lock<boost::recursive_mutex> lock(gh->applyMx);
+
+			const CArmedInstance * armies[2];
+			const CGHeroInstance * heroes[2];
+			for(int i = 0; i < 2; i++)
+			{
+				auto army = createArmy(scenario.sides[i], PlayerColor(i), ObjectInstanceID(2 * number + i), rand);
+				gh->gs->map->objects[army->id.getNum()] = army;
+				armies[i] = army;
+				heroes[i] = dynamic_cast<const CGHeroInstance *>(army);
+			}
+
+			fight.battle = BattleInfo::setupBattle(tile, scenario.terrain, battlefield, armies, heroes, false, nullptr);
+			battleID = gh->registerBattle(fight.battle);
+			{
+				boost::unique_lock<boost::mutex> lock(fightsMx);
+				fights[battleID] = &fight;
+			}
+
+			for(int i = 0; i < 2; i++)
+			{
+				fight.callbacks[i] = std::make_shared<CSimulatedBattleCallback>(gh.get(), fight.battle, fight.battle->sides[i].color);
+				fight.ais[i] = CDynLibHandler::getNewBattleAI(scenario.sides[i].ai);
+				fight.ais[i]->init(fight.callbacks[i]);
+			}
+			for(int i = 0; i < 2; i++)
+				fight.ais[i]->battleStart(armies[0], armies[1], tile, heroes[0], heroes[1], i);
+
+			if(fight.battle->tacticDistance)
+			{
+				ui8 side = fight.battle->tacticsSide;
+				fight.ais[side]->yourTacticPhase(fight.battle->tacticDistance);
+				if(fight.battle->tacticDistance)
+				{
+					auto endTactics = BattleAction::makeEndOFTacticPhase(side);
+					gh->makeBattleAction(fight.battle, endTactics);
+				}
+			}
+		}
+
+		//AIs act in this thread, from inside of packApplied
+		gh->fightBattle(fight.battle);
+
+		BattleResult result = *gh->getOngoingBattle(battleID)->result.get();
+		{
+			boost::unique_lock<boost::recursive_mutex> lock(gh->applyMx);
+			for(auto & ai : fight.ais)
+				ai->battleEnd(&result);
+		}
+
+		boost::unique_lock<boost::mutex> lock(scenario.mx);
+		scenario.battles++;
+		scenario.rounds += fight.battle->round;
+		if(fight.failed)
+			scenario.errors++;
+		if(result.winner < 2)
+			scenario.stats[result.winner].wins++;
+		else
+			scenario.draws++;
+
+		for(int i = 0; i < 2; i++)
+		{
+			SideStats & stats = scenario.stats[i];
+			for(auto & casualty : result.casualties[i])
+				stats.casualties[casualty.first] += casualty.second;
+			stats.actions += fight.actions[i];
+			stats.thinkTime += fight.thinkTime[i];
+			vstd::amax(stats.longestThinkTime, fight.longestThinkTime[i]);
+		}
+		lock.unlock();
+
+		gh->sendAndApply(&result); //removes battle from game state
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->error("Battle %d of %s failed: %s", number, scenario.name, e.what());
+		boost::unique_lock<boost::mutex> lock(scenario.mx);
+		scenario.errors++;
+	}
+
+	if(battleID != BattleID::NONE)
+	{
+		bool inGameState;
+		{
+			boost::unique_lock<boost::recursive_mutex> lock(gh->applyMx);
+			inGameState = gh->gs->getBattle(battleID);
+		}
+		if(inGameState) //failed battle must still be removed from game state before its armies are deleted
+		{
+			BattleResult result;
+			result.battleID = battleID;
+			gh->sendAndApply(&result);
+		}
+		boost::unique_lock<boost::mutex> lock(gh->battlesMx);
+		gh->ongoingBattles.erase(battleID);
+	}
+	{
+		boost::unique_lock<boost::mutex> lock(fightsMx);
+		fights.erase(battleID);
+	}
+
+	boost::unique_lock<boost::recursive_mutex> lock(gh->applyMx);
+	fight.ais.fill(nullptr);
+	fight.callbacks.fill(nullptr);
+	for(int i = 0; i < 2; i++)
+		gh->gs->map->objects[2 * number + i].dellNull();
+}
+
+void CBattleSimulator::activateStack(Fight & fight, si32 stackID)
+{
+	BattleInfo * battle = fight.battle;
+	auto ongoing = gh->getOngoingBattle(battle->battleID);
+
+	if(battle->round > fight.scenario.maxRounds)
+	{
+		gh->setBattleResult(battle, BattleResult::NORMAL, 2); //neither side is able to win
+		return;
+	}
+
+	const CStack * stack = battle->battleGetStackByID(stackID);
+	const ui8 side = stack->side;
+
+	BattleAction action;
+	si64 time;
+	{
+		//AI reads bonuses of stacks, so no pack of another battle may change bonus tree meanwhile
+		boost::unique_lock<boost::recursive_mutex> lock(gh->applyMx);
+		auto start = boost::posix_time::microsec_clock::universal_time();
+		action = fight.ais[side]->activeStack(stack);
+		time = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+	}
+
+	fight.actions[side]++;
+	fight.thinkTime[side] += time;
+	vstd::amax(fight.longestThinkTime[side], time);
+
+	if(ongoing->result.get() || ongoing->madeAction.get()) //spell cast by hero ended battle or killed active stack
+		return;
+
+	gh->makeBattleAction(battle, action);
+	if(!ongoing->madeAction.get())
+	{
+		logGlobal->warn("%s made invalid action with %s, it will defend instead", fight.scenario.sides[side].ai, stack->nodeName());
+		auto defend = BattleAction::makeDefend(stack);
+		gh->makeBattleAction(battle, defend);
+	}
+	if(!ongoing->madeAction.get())
+	{
+		logGlobal->error("%s can't act in battle %s, ending it", stack->nodeName(), fight.scenario.name);
+		fight.failed = true;
+		gh->setBattleResult(battle, BattleResult::NORMAL, 2);
+	}
+}
+
+void CBattleSimulator::packApplied(CPackForClient * pack)
+{
+	auto sas = dynamic_cast<BattleSetActiveStack *>(pack);
+	if(!sas || !sas->askPlayerInterface)
+		return;
+
+	Fight * fight = nullptr;
+	{
+		boost::unique_lock<boost::mutex> lock(fightsMx);
+		fight = fights.at(sas->battleID);
+	}
+	activateStack(*fight, sas->stack);
+}
+
+CArmedInstance * CBattleSimulator::createArmy(const Side & side, PlayerColor owner, ObjectInstanceID id, CRandomGenerator & rand) const
+{
+	CArmedInstance * army = nullptr;
+	CGHeroInstance * hero = nullptr;
+	if(side.hero >= 0)
+	{
+		hero = new CGHeroInstance();
+		hero->ID = Obj::HERO;
+		hero->subID = side.hero;
+		army = hero;
+	}
+	else
+	{
+		army = new CArmedInstance();
+	}
+
+	army->id = id;
+	army->tempOwner = owner;
+	for(size_t i = 0; i < side.army.size(); i++)
+		army->putStack(SlotID(i), new CStackInstance(side.army[i].first, side.army[i].second));
+
+	if(hero)
+	{
+		hero->initHero(rand); //army is already set, hero won't get default one
+
+		if(side.secondarySkills)
+		{
+			hero->secSkills = *side.secondarySkills;
+			hero->recreateSecondarySkillsBonuses();
+		}
+		for(int i = 0; i < GameConstants::PRIMARY_SKILLS; i++)
+		{
+			if(side.primarySkills[i] >= 0)
+				hero->setPrimarySkill(static_cast<PrimarySkill::PrimarySkill>(i), side.primarySkills[i], true);
+		}
+		if(!side.spells.empty())
+		{
+			if(!hero->hasSpellbook())
+				hero->putArtifact(ArtifactPosition::SPELLBOOK, CArtifactInstance::createNewArtifactInstance(ArtifactID::SPELLBOOK));
+			hero->spells.insert(side.spells.begin(), side.spells.end());
+		}
+		hero->mana = hero->manaLimit();
+	}
+	return army;
+}
+
+int main(int argc, char * argv[])
+{
+#ifndef VCMI_ANDROID
+	// Correct working dir executable folder (not bundle folder) so we can use executable relative paths
+	boost::filesystem::current_path(boost::filesystem::system_complete(argv[0]).parent_path());
+#endif
+	namespace po = boost::program_options;
+	po::options_description opts("Allowed options");
+	opts.add_options()
+		("help,h", "display help and exit")
+		("battles", po::value<std::string>(), "JSON file with battles to fight")
+		("output,o", po::value<std::string>(), "file to write report to, standard output if not set")
+		("threads,t", po::value<int>(), "number of battles fought at once, number of cores if not set");
+	po::positional_options_description positional;
+	positional.add("battles", 1);
+
+	po::variables_map vm;
+	try
+	{
+		po::store(po::command_line_parser(argc, argv).options(opts).positional(positional).run(), vm);
+		po::notify(vm);
+	}
+	catch(std::exception & e)
+	{
+		std::cerr << "Failure during parsing command-line options:\n" << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if(vm.count("help") || !vm.count("battles"))
+	{
+		printf("%s - battle simulator\n", GameConstants::VCMI_VERSION.c_str());
+		printf("Usage: vcmibattlesim [options] battles.json\n");
+		std::cout << opts;
+		return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	console = new CConsoleHandler();
+	CBasicLogConfigurator logConfig(VCMIDirs::get().userCachePath() / "VCMI_BattleSim_log.txt", console);
+	logConfig.configureDefault();
+
+	preinitDLL(console);
+	settings.init();
+	logConfig.configure();
+	loadDLLClasses();
+
+	int threads = vm.count("threads") ? vm["threads"].as<int>() : boost::thread::hardware_concurrency();
+	vstd::amax(threads, 1);
+
+	int ret = EXIT_SUCCESS;
+	try
+	{
+		boost::filesystem::ifstream input(vm["battles"].as<std::string>(), std::ios::binary);
+		if(!input)
+			throw std::runtime_error("Can't open " + vm["battles"].as<std::string>());
+		std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+		CBattleSimulator simulator(JsonNode(data.c_str(), data.size()));
+		std::string report = simulator.run(threads).toJson();
+
+		if(vm.count("output"))
+		{
+			boost::filesystem::ofstream output(vm["output"].as<std::string>());
+			output << report;
+		}
+		else
+			std::cout << report << std::endl;
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error("Battle simulation failed: %s", e.what());
+		ret = EXIT_FAILURE;
+	}
+
+	vstd::clear_pointer(VLC);
+	CResourceHandler::clear();
+	return ret;
+}
@@ -0,0 +1,109 @@
+/*
+ * CBattleSimulator.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "../lib/GameConstants.h"
+#include "../lib/JsonNode.h"
+
+class CGameHandler;
+class CArmedInstance;
+class CRandomGenerator;
+struct CPackForClient;
+
+/**
+ * Fights battles between battle AIs without map, clients and adventure map aftermath.
+ *
+ * Configuration lists scenarios, each scenario gives terrain and both sides:
+ * AI library, army and optional hero with skills and spells. Every scenario is
+ * fought given number of times, battles are spread among worker threads and
+ * each battle is fought from start to end by one thread. Report contains win
+ * rates, average casualties and time AIs spent on choosing their actions.
+ *
+ * {
+ *     "seed" : 1,
+ *     "battles" : [
+ *         {
+ *             "name" : "Orrin vs skeletons", "terrain" : "grass", "repeat" : 100, "maxRounds" : 100,
+ *             "sides" : [
+ *                 {
+ *                     "ai" : "BattleAI",
+ *                     "hero" : { "type" : "orrin", "primarySkills" : { "attack" : 5 }, "secondarySkills" : { "archery" : "expert" }, "spells" : [ "bless" ] },
+ *                     "army" : [ { "type" : "archer", "amount" : 30 } ]
+ *                 },
+ *                 { "ai" : "StupidAI", "army" : [ { "type" : "skeleton", "amount" : 60 } ] }
+ *             ]
+ *         }
+ *     ]
+ * }
+ */
+class CBattleSimulator
+{
+public:
+	CBattleSimulator(const JsonNode & config);
+	~CBattleSimulator();
+
+	/// Fights all configured battles using given number of threads and returns report
+	JsonNode run(int threads);
+
+private:
+	struct Side
+	{
+		std::string ai;
+		si32 hero; //-1 if side has no hero
+		std::array<si32, GameConstants::PRIMARY_SKILLS> primarySkills; //-1 keeps default value of hero
+		boost::optional<std::vector<std::pair<SecondarySkill, ui8>>> secondarySkills; //replaces default skills of hero if set
+		std::set<SpellID> spells;
+		std::vector<std::pair<CreatureID, TQuantity>> army;
+
+		Side(const JsonNode & config);
+	};
+
+	struct SideStats
+	{
+		ui32 wins;
+		std::map<ui32, si64> casualties; //creature => total number of killed units
+		ui64 actions;
+		si64 thinkTime; //total time spent by AI in choosing actions, in microseconds
+		si64 longestThinkTime;
+
+		SideStats();
+	};
+
+	struct Scenario
+	{
+		std::string name;
+		ETerrainType terrain;
+		ui32 repeat;
+		si32 maxRounds; //battle is declared a draw after that many rounds
+		std::vector<Side> sides;
+
+		boost::mutex mx; //guards statistics below, battles of one scenario finish in different threads
+		ui32 battles, draws, errors;
+		si64 rounds;
+		std::array<SideStats, 2> stats;
+
+		Scenario(const JsonNode & config);
+		JsonNode report() const;
+	};
+
+	struct Fight;
+
+	std::unique_ptr<CGameHandler> gh;
+	std::vector<std::unique_ptr<Scenario>> scenarios;
+	ui32 seed;
+
+	boost::mutex fightsMx;
+	std::map<BattleID, Fight *> fights;
+
+	void fight(Scenario & scenario, ui32 number);
+	void activateStack(Fight & fight, si32 stackID);
+	void packApplied(CPackForClient * pack);
+	CArmedInstance * createArmy(const Side & side, PlayerColor owner, ObjectInstanceID id, CRandomGenerator & rand) const;
+};
@@ -33,15 +33,19 @@
 #include "../lib/rmg/CMapGenOptions.h"
 #include "../lib/VCMIDirs.h"
 #include "../lib/ScopeGuard.h"
+#include "../lib/CConfigHandler.h"
 #include "../lib/CSoundBase.h"
 #include "CGameHandler.h"
 #include "CVCMIServer.h"
+#include "CPackLog.h"
+#include "CSimultaneousTurns.h"
 #include "../lib/CCreatureSet.h"
 #include "../lib/CThreadHelper.h"
 #include "../lib/GameConstants.h"
 #include "../lib/registerTypes/RegisterTypes.h"
 #include "../lib/serializer/CTypeList.h"
 #include "../lib/serializer/Connection.h"
+#include "../lib/serializer/CSaveSnapshot.h"
 
 #ifndef _MSC_VER
 #include <boost/thread/xtime.hpp>
@@ -75,8 +79,6 @@ private:
 	mutable CGameHandler * gh;
 };
 
-CondSh<bool> battleMadeAction(false);
-CondSh<BattleResult *> battleResult(nullptr);
 template <typename T> class CApplyOnGH;
 
 class CBaseForGHApply
@@ -536,36 +538,39 @@ void CGameHandler::changeSecSkill(const CGHeroInstance * hero, SecondarySkill wh
 	}
 }
 
-void CGameHandler::endBattle(int3 tile, const CGHeroInstance *hero1, const CGHeroInstance *hero2)
+void CGameHandler::endBattle(BattleInfo * battle, int3 tile, const CGHeroInstance *hero1, const CGHeroInstance *hero2)
 {
 	LOG_TRACE(logGlobal);
 
+	const BattleID battleID = battle->battleID;
+	BattleResult * battleResult = getOngoingBattle(battleID)->result.get();
+
 	//Fill BattleResult structure with exp info
-	giveExp(*battleResult.data);
+	giveExp(*battleResult);
 
-	if (battleResult.get()->result == BattleResult::NORMAL) // give 500 exp for defeating hero, unless he escaped
+	if (battleResult->result == BattleResult::NORMAL) // give 500 exp for defeating hero, unless he escaped
 	{
 		if (hero1)
-			battleResult.data->exp[1] += 500;
+			battleResult->exp[1] += 500;
 		if (hero2)
-			battleResult.data->exp[0] += 500;
+			battleResult->exp[0] += 500;
 	}
 
 	if (hero1)
-		battleResult.data->exp[0] = hero1->calculateXp(battleResult.data->exp[0]);//scholar skill
+		battleResult->exp[0] = hero1->calculateXp(battleResult->exp[0]);//scholar skill
 	if (hero2)
-		battleResult.data->exp[1] = hero2->calculateXp(battleResult.data->exp[1]);
+		battleResult->exp[1] = hero2->calculateXp(battleResult->exp[1]);
 
-	const CArmedInstance *bEndArmy1 = gs->curB->sides.at(0).armyObject;
-	const CArmedInstance *bEndArmy2 = gs->curB->sides.at(1).armyObject;
-	const BattleResult::EResult result = battleResult.get()->result;
+	const CArmedInstance *bEndArmy1 = battle->sides.at(0).armyObject;
+	const CArmedInstance *bEndArmy2 = battle->sides.at(1).armyObject;
+	const BattleResult::EResult result = battleResult->result;
 
-	auto findBattleQuery = [this]() -> std::shared_ptr<CBattleQuery>
+	auto findBattleQuery = [this, battle]() -> std::shared_ptr<CBattleQuery>
 	{
 		for (auto &q : queries.allQueries())
 		{
 			if (auto bq = std::dynamic_pointer_cast<CBattleQuery>(q))
-				if (bq->bi == gs->curB)
+				if (bq->bi == battle)
 					return bq;
 		}
 		return std::shared_ptr<CBattleQuery>();
@@ -576,17 +581,21 @@ void CGameHandler::endBattle(int3 tile, const CGHeroInstance *hero1, const CGHer
 	{
 		logGlobal->error("Cannot find battle query!");
 	}
-	if (battleQuery != queries.topQuery(gs->curB->sides[0].color))
-		complain("Player " + boost::lexical_cast<std::string>(gs->curB->sides[0].color) + " although in battle has no battle query at the top!");
+	if (battleQuery != queries.topQuery(battle->sides[0].color))
+		complain("Player " + boost::lexical_cast<std::string>(battle->sides[0].color) + " although in battle has no battle query at the top!");
 
-	battleQuery->result = boost::make_optional(*battleResult.data);
+	battleQuery->result = boost::make_optional(*battleResult);
 
 	//Check how many battle queries were created (number of players blocked by battle)
 	const int queriedPlayers = battleQuery ? boost::count(queries.allQueries(), battleQuery) : 0;
-	finishingBattle = make_unique<FinishingBattleHelper>(battleQuery, queriedPlayers);
+	FinishingBattleHelper * finishingBattle = new FinishingBattleHelper(battleQuery, queriedPlayers);
+	{
+		boost::unique_lock<boost::mutex> lock(battlesMx);
+		finishingBattles[battleID].reset(finishingBattle);
+	}
 
 
-	CasualtiesAfterBattle cab1(bEndArmy1, gs->curB), cab2(bEndArmy2, gs->curB); //calculate casualties before deleting battle
+	CasualtiesAfterBattle cab1(bEndArmy1, battle), cab2(bEndArmy2, battle); //calculate casualties before deleting battle
 
 	ChangeSpells cs; //for Eagle Eye
 
@@ -595,7 +604,7 @@ void CGameHandler::endBattle(int3 tile, const CGHeroInstance *hero1, const CGHer
 		if (int eagleEyeLevel = finishingBattle->winnerHero->valOfBonuses(Bonus::SECONDARY_SKILL_VAL2, SecondarySkill::EAGLE_EYE))
 		{
 			double eagleEyeChance = finishingBattle->winnerHero->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::EAGLE_EYE);
-			for (const CSpell *sp : gs->curB->sides.at(!battleResult.data->winner).usedSpellsHistory)
+			for (const CSpell *sp : battle->sides.at(!battleResult->winner).usedSpellsHistory)
 				if (sp->level <= eagleEyeLevel && !vstd::contains(finishingBattle->winnerHero->spells, sp->id) && getRandomGenerator().nextInt(99) < eagleEyeChance)
 					cs.spells.insert(sp->id);
 		}
@@ -655,7 +664,7 @@ void CGameHandler::endBattle(int3 tile, const CGHeroInstance *hero1, const CGHer
 				}
 			}
 		}
-		for (auto armySlot : gs->curB->battleGetArmyObject(!battleResult.data->winner)->stacks)
+		for (auto armySlot : battle->battleGetArmyObject(!battleResult->winner)->stacks)
 		{
 			auto artifactsWorn = armySlot.second->artifactsWorn;
 			for (auto artSlot : artifactsWorn)
@@ -671,7 +680,7 @@ void CGameHandler::endBattle(int3 tile, const CGHeroInstance *hero1, const CGHer
 		}
 	}
 
-	sendAndApply(battleResult.data); //after this point casualties objects are destroyed
+	sendAndApply(battleResult); //after this point casualties objects are destroyed
 
 	if (arts.size()) //display loot
 	{
@@ -737,26 +746,26 @@ void CGameHandler::endBattle(int3 tile, const CGHeroInstance *hero1, const CGHer
 	cab2.updateArmy(this); //take casualties after battle is deleted
 
 	//if one hero has lost we will erase him
-	if (battleResult.data->winner!=0 && hero1)
+	if (battleResult->winner!=0 && hero1)
 	{
 		RemoveObject ro(hero1->id);
 		sendAndApply(&ro);
 	}
-	if (battleResult.data->winner!=1 && hero2)
+	if (battleResult->winner!=1 && hero2)
 	{
 		auto town = hero2->visitedTown;
 		RemoveObject ro(hero2->id);
 		sendAndApply(&ro);
 
 		if (town && !town->garrisonHero) // TODO: that must be called from CGHeroInstance or CGTownInstance
-			town->battleFinished(hero1, *battleResult.get());
+			town->battleFinished(hero1, *battleResult);
 	}
 
 	//give exp
-	if (battleResult.data->exp[0] && hero1 && battleResult.get()->winner == 0)
-		changePrimSkill(hero1, PrimarySkill::EXPERIENCE, battleResult.data->exp[0]);
-	else if (battleResult.data->exp[1] && hero2 && battleResult.get()->winner == 1)
-		changePrimSkill(hero2, PrimarySkill::EXPERIENCE, battleResult.data->exp[1]);
+	if (battleResult->exp[0] && hero1 && battleResult->winner == 0)
+		changePrimSkill(hero1, PrimarySkill::EXPERIENCE, battleResult->exp[0]);
+	else if (battleResult->exp[1] && hero2 && battleResult->winner == 1)
+		changePrimSkill(hero2, PrimarySkill::EXPERIENCE, battleResult->exp[1]);
 
 	queries.popIfTop(battleQuery);
 
@@ -767,6 +776,13 @@ void CGameHandler::battleAfterLevelUp(const BattleResult &result)
 {
 	LOG_TRACE(logGlobal);
 
+	FinishingBattleHelper * finishingBattle = nullptr;
+	{
+		boost::unique_lock<boost::mutex> lock(battlesMx);
+		if(vstd::contains(finishingBattles, result.battleID))
+			finishingBattle = finishingBattles.at(result.battleID).get();
+	}
+	COMPLAIN_RET_IF(!finishingBattle, "Finishing state of battle is missing!");
 
 	finishingBattle->remainingBattleQueriesCount--;
 	logGlobal->trace("Decremented queries count to %d", finishingBattle->remainingBattleQueriesCount);
@@ -780,7 +796,7 @@ void CGameHandler::battleAfterLevelUp(const BattleResult &result)
 	// Still, it looks like a hole.
 
 	// Necromancy if applicable.
-	const CStackBasicDescriptor raisedStack = finishingBattle->winnerHero ? finishingBattle->winnerHero->calculateNecromancy(*battleResult.data) : CStackBasicDescriptor();
+	const CStackBasicDescriptor raisedStack = finishingBattle->winnerHero ? finishingBattle->winnerHero->calculateNecromancy(result) : CStackBasicDescriptor();
 	// Give raised units to winner and show dialog, if any were raised,
 	// units will be given after casualties are taken
 	const SlotID necroSlot = raisedStack.type ? finishingBattle->winnerHero->getSlotFor(raisedStack.type) : SlotID();
@@ -794,10 +810,9 @@ void CGameHandler::battleAfterLevelUp(const BattleResult &result)
 	BattleResultsApplied resultsApplied;
 	resultsApplied.player1 = finishingBattle->victor;
 	resultsApplied.player2 = finishingBattle->loser;
+	resultsApplied.battleID = result.battleID;
 	sendAndApply(&resultsApplied);
 
-	setBattle(nullptr);
-
 	if (visitObjectAfterVictory && result.winner==0 && !finishingBattle->winnerHero->stacks.empty())
 	{
 		logGlobal->trace("post-victory visit");
@@ -848,17 +863,21 @@ void CGameHandler::battleAfterLevelUp(const BattleResult &result)
 			sendAndApply(&sah);
 		}
 	}
+
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	finishingBattles.erase(result.battleID);
 }
 
-void CGameHandler::prepareAttack(BattleAttack &bat, const CStack *att, const CStack *def, int distance, int targetHex)
+void CGameHandler::prepareAttack(BattleInfo * battle, BattleAttack &bat, const CStack *att, const CStack *def, int distance, int targetHex)
 {
 	bat.bsa.clear();
+	bat.battleID = battle->battleID;
 	bat.stackAttacking = att->ID;
 	const int attackerLuck = att->LuckVal();
 
 	auto sideHeroBlocksLuck = [](const SideInBattle &side){ return NBonus::hasOfType(side.hero, Bonus::BLOCK_LUCK); };
 
-	if (!vstd::contains_if (gs->curB->sides, sideHeroBlocksLuck))
+	if (!vstd::contains_if (battle->sides, sideHeroBlocksLuck))
 	{
 		if (attackerLuck > 0  && getRandomGenerator().nextInt(23) < attackerLuck)
 		{
@@ -880,7 +899,7 @@ void CGameHandler::prepareAttack(BattleAttack &bat, const CStack *att, const CSt
 
 	if (att->getCreature()->idNumber == CreatureID::BALLISTA)
 	{
-		const CGHeroInstance * owner = gs->curB->getHero(att->owner);
+		const CGHeroInstance * owner = battle->getHero(att->owner);
 		int chance = owner->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARTILLERY);
 		if (chance > getRandomGenerator().nextInt(99))
 		{
@@ -888,16 +907,16 @@ void CGameHandler::prepareAttack(BattleAttack &bat, const CStack *att, const CSt
 		}
 	}
 	// only primary target
-	applyBattleEffects(bat, att, def, distance, false);
+	applyBattleEffects(battle, bat, att, def, distance, false);
 
 	//multiple-hex normal attack
-	std::set<const CStack*> attackedCreatures = gs->curB->getAttackedCreatures(att, targetHex, bat.shot()); //creatures other than primary target
+	std::set<const CStack*> attackedCreatures = battle->getAttackedCreatures(att, targetHex, bat.shot()); //creatures other than primary target
 
 	for (const CStack * stack : attackedCreatures)
 	{
 		if (stack != def) //do not hit same stack twice
 		{
-			applyBattleEffects(bat, att, stack, distance, true);
+			applyBattleEffects(battle, bat, att, stack, distance, true);
 		}
 	}
 
@@ -910,7 +929,7 @@ void CGameHandler::prepareAttack(BattleAttack &bat, const CStack *att, const CSt
 
 		//TODO: should spell override creature`s projectile?
 
-		auto affectedCreatures = SpellID(bonus->subtype).toSpell()->getAffectedStacks(gs->curB, ECastingMode::SPELL_LIKE_ATTACK, att, bonus->val, targetHex);
+		auto affectedCreatures = SpellID(bonus->subtype).toSpell()->getAffectedStacks(battle, ECastingMode::SPELL_LIKE_ATTACK, att, bonus->val, targetHex);
 
 		//TODO: get exact attacked hex for defender
 
@@ -918,7 +937,7 @@ void CGameHandler::prepareAttack(BattleAttack &bat, const CStack *att, const CSt
 		{
 			if (stack != def) //do not hit same stack twice
 			{
-				applyBattleEffects(bat, att, stack, distance, true);
+				applyBattleEffects(battle, bat, att, stack, distance, true);
 			}
 		}
 
@@ -935,14 +954,14 @@ void CGameHandler::prepareAttack(BattleAttack &bat, const CStack *att, const CSt
 
 	}
 }
-void CGameHandler::applyBattleEffects(BattleAttack &bat, const CStack *att, const CStack *def, int distance, bool secondary) //helper function for prepareAttack
+void CGameHandler::applyBattleEffects(BattleInfo * battle, BattleAttack &bat, const CStack *att, const CStack *def, int distance, bool secondary) //helper function for prepareAttack
 {
 	BattleStackAttacked bsa;
 	if (secondary)
 		bsa.flags |= BattleStackAttacked::SECONDARY; //all other targets do not suffer from spells & spell-like abilities
 	bsa.attackerID = att->ID;
 	bsa.stackAttacked = def->ID;
-	bsa.damageAmount = gs->curB->calculateDmg(att, def, bat.shot(), distance, bat.lucky(), bat.unlucky(), bat.deathBlow(), bat.ballistaDoubleDmg(), getRandomGenerator());
+	bsa.damageAmount = battle->calculateDmg(att, def, bat.shot(), distance, bat.lucky(), bat.unlucky(), bat.deathBlow(), bat.ballistaDoubleDmg(), getRandomGenerator());
 	def->prepareAttacked(bsa, getRandomGenerator()); //calculate casualties
 
 	//life drain handling
@@ -1061,48 +1080,15 @@ void CGameHandler::handleConnection(std::set<PlayerColor> players, CConnection &
 
 					logGlobal->trace("Received client message (request %d by player %d (%s)) of type with ID=%d (%s).\n",
 									 requestID, player, player.getStr(), packType, typeid(*pack).name());
+					if(packLog)
+						packLog->packReceived(pack, player, requestID);
 				}
 			}
 
-			//prepare struct informing that action was applied
-			auto sendPackageResponse = [&](bool succesfullyApplied)
-			{
-				//dont reply to disconnected client
-				//TODO: this must be implemented as option of CPackForServer
-				if(dynamic_cast<LeaveGame *>(pack) || dynamic_cast<CloseServer *>(pack))
-					return;
-
-				PackageApplied applied;
-				applied.player = player;
-				applied.result = succesfullyApplied;
-				applied.packType = packType;
-				applied.requestID = requestID;
-				boost::unique_lock<boost::mutex> lock(*c.wmx);
-				c << &applied;
-			};
-			CBaseForGHApply *apply = applier->getApplier(packType); //and appropriate applier object
-			if(isBlockedByQueries(pack, player))
-			{
-				sendPackageResponse(false);
-			}
-			else if (apply)
-			{
-				const bool result = apply->applyOnGH(this, &c, pack, player);
-				if (result)
-					logGlobal->trace("Message %s successfully applied!", typeid(*pack).name());
-				else
-					complain((boost::format("Got false in applying %s... that request must have been fishy!")
-						% typeid(*pack).name()).str());
-
-				sendPackageResponse(true);
-			}
-			else
-			{
-				logGlobal->error("Message cannot be applied, cannot find applier (unregistered type)!");
-				sendPackageResponse(false);
-			}
+			if(simultaneousTurns && simultaneousTurns->holdRequest(c, pack, player, requestID, packType))
+				continue;
 
-			vstd::clear_pointer(pack);
+			applyRequest(c, pack, player, requestID, packType);
 		}
 	}
 	catch(boost::system::system_error &e) //for boost errors just log, not crash - probably client shut down connection
@@ -1123,19 +1109,62 @@ void CGameHandler::handleConnection(std::set<PlayerColor> players, CConnection &
 	logGlobal->error("Ended handling connection");
 }
 
-int CGameHandler::moveStack(int stack, BattleHex dest)
+void CGameHandler::applyRequest(CConnection &c, CPack *pack, PlayerColor player, si32 requestID, int packType)
+{
+	//prepare struct informing that action was applied
+	auto sendPackageResponse = [&](bool succesfullyApplied)
+	{
+		//dont reply to disconnected client
+		//TODO: this must be implemented as option of CPackForServer
+		if(dynamic_cast<LeaveGame *>(pack) || dynamic_cast<CloseServer *>(pack))
+			return;
+
+		PackageApplied applied;
+		applied.player = player;
+		applied.result = succesfullyApplied;
+		applied.packType = packType;
+		applied.requestID = requestID;
+		boost::unique_lock<boost::mutex> lock(*c.wmx);
+		c << &applied;
+	};
+	CBaseForGHApply *apply = applier->getApplier(packType); //and appropriate applier object
+	if(isBlockedByQueries(pack, player))
+	{
+		sendPackageResponse(false);
+	}
+	else if (apply)
+	{
+		const bool result = apply->applyOnGH(this, &c, pack, player);
+		if (result)
+			logGlobal->trace("Message %s successfully applied!", typeid(*pack).name());
+		else
+			complain((boost::format("Got false in applying %s... that request must have been fishy!")
+				% typeid(*pack).name()).str());
+
+		sendPackageResponse(true);
+	}
+	else
+	{
+		logGlobal->error("Message cannot be applied, cannot find applier (unregistered type)!");
+		sendPackageResponse(false);
+	}
+
+	vstd::clear_pointer(pack);
+}
+
+int CGameHandler::moveStack(BattleInfo * battle, int stack, BattleHex dest)
 {
 	int ret = 0;
 
-	const CStack *curStack = gs->curB->battleGetStackByID(stack),
-		*stackAtEnd = gs->curB->battleGetStackByPos(dest);
+	const CStack *curStack = battle->battleGetStackByID(stack),
+		*stackAtEnd = battle->battleGetStackByPos(dest);
 
 	assert(curStack);
 	assert(dest < GameConstants::BFIELD_SIZE);
 
-	if (gs->curB->tacticDistance)
+	if (battle->tacticDistance)
 	{
-		assert(gs->curB->isInTacticRange(dest));
+		assert(battle->isInTacticRange(dest));
 	}
 
 	auto start = curStack->position;
@@ -1143,7 +1172,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 		return 0;
 
 	//initing necessary tables
-	auto accessibility = getAccesibility(curStack);
+	auto accessibility = battle->getAccesibility(curStack);
 
 	//shifting destination (if we have double wide stack and we can occupy dest but not be exactly there)
 	if(!stackAtEnd && curStack->doubleWide() && !accessibility.accessible(dest, curStack))
@@ -1161,23 +1190,23 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 	}
 
 	bool canUseGate = false;
-	auto dbState = gs->curB->si.gateState;
-	if(battleGetSiegeLevel() > 0 && curStack->side == BattleSide::DEFENDER &&
+	auto dbState = battle->si.gateState;
+	if(battle->battleGetSiegeLevel() > 0 && curStack->side == BattleSide::DEFENDER &&
 		dbState != EGateState::DESTROYED &&
 		dbState != EGateState::BLOCKED)
 	{
 		canUseGate = true;
 	}
 
-	std::pair< std::vector<BattleHex>, int > path = gs->curB->getPath(start, dest, curStack);
+	std::pair< std::vector<BattleHex>, int > path = battle->getPath(start, dest, curStack);
 
 	ret = path.second;
 
-	int creSpeed = gs->curB->tacticDistance ? GameConstants::BFIELD_SIZE : curStack->Speed();
+	int creSpeed = battle->tacticDistance ? GameConstants::BFIELD_SIZE : curStack->Speed();
 
 	auto isGateDrawbridgeHex = [&](BattleHex hex) -> bool
 	{
-		if (gs->curB->town->subID == ETownType::FORTRESS && hex == ESiegeHex::GATE_BRIDGE)
+		if (battle->town->subID == ETownType::FORTRESS && hex == ESiegeHex::GATE_BRIDGE)
 			return true;
 		if (hex == ESiegeHex::GATE_OUTER)
 			return true;
@@ -1210,12 +1239,14 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 				occupyGateDrawbridgeHex(dest))
 			{
 				BattleUpdateGateState db;
+				db.battleID = battle->battleID;
 				db.state = EGateState::OPENED;
 				sendAndApply(&db);
 			}
 
 			//inform clients about move
 			BattleStackMoved sm;
+			sm.battleID = battle->battleID;
 			sm.stack = curStack->ID;
 			std::vector<BattleHex> tiles;
 			tiles.push_back(path.first[0]);
@@ -1240,7 +1271,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 			{
 				auto needOpenGates = [&](BattleHex hex) -> bool
 				{
-					if (gs->curB->town->subID == ETownType::FORTRESS && hex == ESiegeHex::GATE_BRIDGE)
+					if (battle->town->subID == ETownType::FORTRESS && hex == ESiegeHex::GATE_BRIDGE)
 						return true;
 					if (hex == ESiegeHex::GATE_BRIDGE && i-1 >= 0 && path.first[i-1] == ESiegeHex::GATE_OUTER)
 						return true;
@@ -1276,7 +1307,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 					{
 						gateMayCloseAtHex = path.first[i-1];
 					}
-					if (gs->curB->town->subID == ETownType::FORTRESS)
+					if (battle->town->subID == ETownType::FORTRESS)
 					{
 						if (hex == ESiegeHex::GATE_BRIDGE && i-1 >= 0 && path.first[i-1] != ESiegeHex::GATE_OUTER)
 						{
@@ -1325,14 +1356,14 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 					}
 
 					//if we walked onto something, finalize this portion of stack movement check into obstacle
-					if(!battleGetAllObstaclesOnPos(hex, false).empty())
+					if(!battle->battleGetAllObstaclesOnPos(hex, false).empty())
 						obstacleHit = true;
 
 					if (curStack->doubleWide())
 					{
 						BattleHex otherHex = curStack->occupiedHex(hex);
 						//two hex creature hit obstacle by backside
-						auto obstacle2 = battleGetAllObstaclesOnPos(otherHex, false);
+						auto obstacle2 = battle->battleGetAllObstaclesOnPos(otherHex, false);
 						if(otherHex.isValid() && !obstacle2.empty())
 							obstacleHit = true;
 					}
@@ -1343,6 +1374,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 			{
 				//commit movement
 				BattleStackMoved sm;
+				sm.battleID = battle->battleID;
 				sm.stack = curStack->ID;
 				sm.distance = path.second;
 				sm.teleporting = false;
@@ -1355,7 +1387,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 			if (curStack->position != dest)
 			{
 				if(stackIsMoving && start != curStack->position)
-					stackIsMoving = handleDamageFromObstacle(curStack, stackIsMoving);
+					stackIsMoving = handleDamageFromObstacle(battle, curStack, stackIsMoving);
 				if (gateStateChanging)
 				{
 					if (curStack->position == openGateAtHex)
@@ -1365,6 +1397,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 						if (curStack->alive())
 						{
 							BattleUpdateGateState db;
+							db.battleID = battle->battleID;
 							db.state = EGateState::OPENED;
 							sendAndApply(&db);
 						}
@@ -1372,7 +1405,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 					else if (curStack->position == gateMayCloseAtHex)
 					{
 						gateMayCloseAtHex = BattleHex();
-						updateGateState();
+						updateGateState(battle);
 					}
 				}
 			}
@@ -1383,7 +1416,7 @@ int CGameHandler::moveStack(int stack, BattleHex dest)
 	}
 
 	//handling obstacle on the final field (separate, because it affects both flying and walking stacks)
-	handleDamageFromObstacle(curStack);
+	handleDamageFromObstacle(battle, curStack);
 
 	return ret;
 }
@@ -1396,12 +1429,16 @@ CGameHandler::CGameHandler(void)
 	applier = new CApplier<CBaseForGHApply>();
 	registerTypesServerPacks(*applier);
 	visitObjectAfterVictory = false;
+	nextBattleID = BattleID(0);
 
 	spellEnv = new ServerSpellCastEnvironment(this);
+	backgroundSaver = make_unique<CBackgroundSaver>();
 }
 
 CGameHandler::~CGameHandler(void)
 {
+	backgroundSaver.reset(); //blocks until all pending saves are written
+	packLog.reset();
 	delete spellEnv;
 	delete applier;
 	applier = nullptr;
@@ -1478,6 +1515,8 @@ void CGameHandler::setPortalDwelling(const CGTownInstance * town, bool forced=fa
 void CGameHandler::newTurn()
 {
 	logGlobal->trace("Turn %d", gs->day+1);
+	if(packLog)
+		packLog->newTurn();
 	NewTurn n;
 	n.specialWeek = NewTurn::NO_ACTION;
 	n.creatureid = CreatureID::NONE;
@@ -1847,6 +1886,9 @@ void CGameHandler::run(bool resume)
 
 	auto playerTurnOrder = generatePlayerTurnOrder();
 
+	if(settings["server"]["simultaneousAiTurns"].Bool())
+		simultaneousTurns = make_unique<CSimultaneousTurns>(*this);
+
 	while(!serverShuttingDown)
 	{
 		if (!resume) newTurn();
@@ -1878,6 +1920,25 @@ void CGameHandler::run(bool resume)
 				}
 				else //give normal turn
 				{
+					std::vector<PlayerColor> group;
+					if (simultaneousTurns && !playerState->human)
+					{
+						std::vector<PlayerColor> candidates; //following AI players, until first human
+						for (auto next = it; next != playerTurnOrder.end() && !gs->players[*next].human; next++)
+						{
+							if (gs->players[*next].status == EPlayerStatus::INGAME)
+								candidates.push_back(*next);
+						}
+						group = simultaneousTurns->startGroup(candidates);
+					}
+
+					if (group.size() > 1)
+					{
+						runSimultaneousTurns(group);
+						it = std::find(it, playerTurnOrder.end(), group.back());
+						continue;
+					}
+
 					states.setFlag(playerColor, &PlayerStatus::makingTurn, true);
 
 					YourTurn yt;
@@ -1910,6 +1971,57 @@ void CGameHandler::run(bool resume)
 		boost::this_thread::sleep(boost::posix_time::milliseconds(5)); //give time client to close socket
 }
 
+void CGameHandler::runSimultaneousTurns(const std::vector<PlayerColor> & group)
+{
+	using namespace boost::posix_time;
+	static time_duration p = milliseconds(100);
+
+	for (auto player : group)
+	{
+		//first player of group was checked by run()
+		if (player != group.front())
+		{
+			checkVictoryLossConditionsForAll();
+			if (gs->players[player].status != EPlayerStatus::INGAME)
+				continue;
+		}
+
+		states.setFlag(player, &PlayerStatus::makingTurn, true);
+
+		YourTurn yt;
+		yt.player = player;
+		yt.daysWithoutCastle = gs->players[player].daysWithoutCastle;
+		yt.joinsTurn = player != group.front(); //current player stays first one, so loading a save resumes whole group
+		applyAndSend(&yt);
+	}
+
+	//wait till turns are done, except for players which have to wait for others
+	{
+		boost::unique_lock<boost::mutex> lock(states.mx);
+		auto isActive = [&](PlayerColor player)
+		{
+			return states.players.at(player).makingTurn && !simultaneousTurns->isHeld(player);
+		};
+		while (vstd::contains_if(group, isActive) && !serverShuttingDown)
+			states.cv.timed_wait(lock, p);
+	}
+
+	//players which reached out of their zones finish their turns one by one in turn order
+	for (auto player : group)
+	{
+		if (serverShuttingDown || !simultaneousTurns->isHeld(player))
+			continue;
+
+		simultaneousTurns->release(player);
+
+		boost::unique_lock<boost::mutex> lock(states.mx);
+		while (states.players.at(player).makingTurn && !serverShuttingDown)
+			states.cv.timed_wait(lock, p);
+	}
+
+	simultaneousTurns->endGroup();
+}
+
 std::list<PlayerColor> CGameHandler::generatePlayerTurnOrder() const
 {
 	// Generate player turn order
@@ -1928,10 +2040,8 @@ std::list<PlayerColor> CGameHandler::generatePlayerTurnOrder() const
 	return playerTurnOrder;
 }
 
-void CGameHandler::setupBattle(int3 tile, const CArmedInstance *armies[2], const CGHeroInstance *heroes[2], bool creatureBank, const CGTownInstance *town)
+BattleID CGameHandler::setupBattle(int3 tile, const CArmedInstance *armies[2], const CGHeroInstance *heroes[2], bool creatureBank, const CGTownInstance *town)
 {
-	battleResult.set(nullptr);
-
 	const auto t = getTile(tile);
 	ETerrainType terrain = t->terType;
 	if (gs->map->isCoastalTile(tile)) //coastal tile is always ground
@@ -1941,22 +2051,35 @@ void CGameHandler::setupBattle(int3 tile, const CArmedInstance *armies[2], const
 	if (heroes[0] && heroes[0]->boat && heroes[1] && heroes[1]->boat)
 		terType = BFieldType::SHIP_TO_SHIP;
 
+	return registerBattle(BattleInfo::setupBattle(tile, terrain, terType, armies, heroes, creatureBank, town));
+}
+
+BattleID CGameHandler::registerBattle(BattleInfo * battle)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(battlesMx);
+		battle->battleID = nextBattleID;
+		++nextBattleID;
+		ongoingBattles[battle->battleID] = std::make_shared<OngoingBattle>();
+	}
+
 	//send info about battles
 	BattleStart bs;
-	bs.info = BattleInfo::setupBattle(tile, terrain, terType, armies, heroes, creatureBank, town);
+	bs.info = battle;
 	sendAndApply(&bs);
+	return battle->battleID;
 }
 
-void CGameHandler::checkBattleStateChanges()
+void CGameHandler::checkBattleStateChanges(BattleInfo * battle)
 {
 	//check if drawbridge state need to be changes
-	if (battleGetSiegeLevel() > 0)
-		updateGateState();
+	if (battle->battleGetSiegeLevel() > 0)
+		updateGateState(battle);
 
 	//check if battle ended
-	if (auto result = battleIsFinished())
+	if (auto result = battle->battleIsFinished())
 	{
-		setBattleResult(BattleResult::NORMAL, *result);
+		setBattleResult(battle, BattleResult::NORMAL, *result);
 	}
 }
 
@@ -2025,7 +2148,7 @@ bool CGameHandler::moveHero(ObjectInstanceID hid, int3 dst, ui8 teleporting, boo
 {
 	const CGHeroInstance *h = getHero(hid);
 	// not turn of that hero or player can't simply teleport hero (at least not with this function)
-	if (!h  || (asker != PlayerColor::NEUTRAL && (teleporting || h->getOwner() != gs->currentPlayer)))
+	if (!h  || (asker != PlayerColor::NEUTRAL && (teleporting || !isPlayerMakingTurn(h->getOwner()))))
 	{
 		logGlobal->error("Illegal call to move hero!");
 		return false;
@@ -2207,12 +2330,59 @@ bool CGameHandler::moveHero(ObjectInstanceID hid, int3 dst, ui8 teleporting, boo
 	}
 }
 
+bool CGameHandler::moveHeroAlongPath(ObjectInstanceID hid, const std::vector<HeroPathStep> & steps, bool stopOnNewGuard, PlayerColor asker)
+{
+	const CGHeroInstance *h = getHero(hid);
+	if (!h || steps.empty())
+		COMPLAIN_RET("Illegal call to move hero along path!");
+
+	auto guardOf = [this](const HeroPathStep & step)
+	{
+		return gs->guardingCreaturePosition(CGHeroInstance::convertPosition(step.dest, false));
+	};
+
+	//guards which player could see when path was sent, walking into them is intended
+	std::set<int3> knownGuards;
+	if (stopOnNewGuard)
+	{
+		for (auto & step : steps)
+		{
+			const int3 guard = guardOf(step);
+			if (isInTheMap(guard) && gs->isVisible(guard, h->tempOwner))
+				knownGuards.insert(guard);
+		}
+	}
+
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		const HeroPathStep & step = steps[i];
+		if (stopOnNewGuard)
+		{
+			const int3 guard = guardOf(step);
+			if (isInTheMap(guard) && !vstd::contains(knownGuards, guard))
+			{
+				logGlobal->debug("Hero %s stops before newly revealed guard at %s", h->name, guard.toString());
+				return true;
+			}
+		}
+
+		//only first step may be illegal, later ones are continuation of successful moves
+		if (!moveHero(hid, step.dest, 0, step.transit, asker))
+			return i > 0;
+
+		h = getHero(hid);
+		if (!h || h->pos != step.dest || queries.topQuery(h->tempOwner))
+			return true;
+	}
+	return true;
+}
+
 bool CGameHandler::teleportHero(ObjectInstanceID hid, ObjectInstanceID dstid, ui8 source, PlayerColor asker)
 {
 	const CGHeroInstance *h = getHero(hid);
 	const CGTownInstance *t = getTown(dstid);
 
-	if (!h || !t || h->getOwner() != gs->currentPlayer)
+	if (!h || !t || !isPlayerMakingTurn(h->getOwner()))
 		COMPLAIN_RET("Invalid call to teleportHero!");
 
 	const CGTownInstance *from = h->visitedTown;
@@ -2400,20 +2570,19 @@ void CGameHandler::startBattlePrimary(const CArmedInstance *army1, const CArmedI
 	engageIntoBattle(army1->tempOwner);
 	engageIntoBattle(army2->tempOwner);
 
-	static const CArmedInstance *armies[2];
+	const CArmedInstance *armies[2];
 	armies[0] = army1;
 	armies[1] = army2;
-	static const CGHeroInstance*heroes[2];
+	const CGHeroInstance *heroes[2];
 	heroes[0] = hero1;
 	heroes[1] = hero2;
 
+	BattleID battleID = setupBattle(tile, armies, heroes, creatureBank, town); //initializes stacks, places creatures on battlefield, blocks and informs player interfaces
 
-	setupBattle(tile, armies, heroes, creatureBank, town); //initializes stacks, places creatures on battlefield, blocks and informs player interfaces
-
-	auto battleQuery = std::make_shared<CBattleQuery>(this, gs->curB);
+	auto battleQuery = std::make_shared<CBattleQuery>(this, gs->getBattle(battleID));
 	queries.addQuery(battleQuery);
 
-	boost::thread(&CGameHandler::runBattle, this);
+	boost::thread(&CGameHandler::runBattle, this, battleID); //every battle is run by its own thread
 }
 
 void CGameHandler::startBattleI(const CArmedInstance *army1, const CArmedInstance *army2, int3 tile, bool creatureBank)
@@ -2606,12 +2775,26 @@ void CGameHandler::sendToAllClients(CPackForClient * info)
 void CGameHandler::sendAndApply(CPackForClient * info)
 {
 	sendToAllClients(info);
-	gs->apply(info);
+	{
+		boost::unique_lock<boost::recursive_mutex> lock(applyMx);
+		if(packLog)
+			packLog->packApplied(info);
+		gs->apply(info);
+	}
+	if(packObserver)
+		packObserver(info);
 }
 
 void CGameHandler::applyAndSend(CPackForClient * info)
 {
-	gs->apply(info);
+	{
+		boost::unique_lock<boost::recursive_mutex> lock(applyMx);
+		if(packLog)
+			packLog->packApplied(info);
+		gs->apply(info);
+	}
+	if(packObserver)
+		packObserver(info);
 	sendToAllClients(info);
 }
 
@@ -2648,13 +2831,16 @@ void CGameHandler::save(const std::string & filename)
 
 	try
 	{
-		{
-			CSaveFile save(*CResourceHandler::get("local")->getResourceName(ResourceID(stem.to_string(), EResType::SERVER_SAVEGAME)));
-			saveCommonState(save);
-			logGlobal->info("Saving server state");
-			save << *this;
-		}
-		logGlobal->info("Game has been successfully saved!");
+		// game is blocked only while state is serialized into memory, compression and disk writes happen on saver thread
+		auto start = boost::posix_time::microsec_clock::universal_time();
+		auto snapshot = make_unique<CSaveSnapshot>();
+		saveCommonState(*snapshot);
+		logGlobal->info("Saving server state");
+		*snapshot << *this;
+		auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+
+		logGlobal->info("Game state snapshot of %d KB taken in %d ms", snapshot->buffer.size() / 1024, duration.total_milliseconds());
+		backgroundSaver->save(std::move(snapshot), *CResourceHandler::get("local")->getResourceName(ResourceID(stem.to_string(), EResType::SERVER_SAVEGAME)));
 	}
 	catch(std::exception &e)
 	{
@@ -2662,6 +2848,18 @@ void CGameHandler::save(const std::string & filename)
 	}
 }
 
+void CGameHandler::recordPacks(const boost::filesystem::path & fname)
+{
+	try
+	{
+		packLog = make_unique<CPackLogWriter>(fname, *this);
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error("Failed to start recording packs to %s: %s", fname.string(), e.what());
+	}
+}
+
 void CGameHandler::close()
 {
 	logGlobal->info("We have been requested to close.");
@@ -2831,7 +3029,24 @@ bool CGameHandler::arrangeStacks(ObjectInstanceID id1, ObjectInstanceID id2, ui8
 	return true;
 }
 
-PlayerColor CGameHandler::getPlayerAt(CConnection *c) const
+PlayerColor CGameHandler::getPlayerAt(CConnection *c, PlayerColor requested)
+{
+	//requested player may act only when it is allowed to act at all - during its turn, battle or query
+	auto iter = connections.find(requested);
+	if (iter != connections.end() && iter->second == c
+		&& (isPlayerMakingTurn(requested) || gs->getBattleOf(requested) || queries.topQuery(requested)))
+		return requested;
+
+	return getPlayerAt(c);
+}
+
+bool CGameHandler::isPlayerMakingTurn(PlayerColor player)
+{
+	boost::unique_lock<boost::mutex> lock(states.mx);
+	return vstd::contains(states.players, player) && states.players.at(player).makingTurn;
+}
+
+PlayerColor CGameHandler::getPlayerAt(CConnection *c)
 {
 	std::set<PlayerColor> all;
 	for (auto i=connections.cbegin(); i!=connections.cend(); i++)
@@ -2847,8 +3062,14 @@ PlayerColor CGameHandler::getPlayerAt(CConnection *c) const
 	default:
 		{
 			//if we have more than one player at this connection, try to pick active one
-			if (vstd::contains(all, gs->currentPlayer))
-				return gs->currentPlayer;
+			std::vector<PlayerColor> active;
+			for (auto player : all)
+			{
+				if (isPlayerMakingTurn(player))
+					active.push_back(player);
+			}
+			if (active.size() == 1)
+				return active.front();
 			else
 				return PlayerColor::CANNOT_DETERMINE; //cannot say which player is it
 		}
@@ -3713,50 +3934,50 @@ bool CGameHandler::queryReply(QueryID qid, const JsonNode & answer, PlayerColor
 	return true;
 }
 
-static EndAction end_action;
-
-void CGameHandler::updateGateState()
+void CGameHandler::updateGateState(BattleInfo * battle)
 {
 	BattleUpdateGateState db;
-	db.state = gs->curB->si.gateState;
-	if (gs->curB->si.wallState[EWallPart::GATE] == EWallState::DESTROYED)
+	db.battleID = battle->battleID;
+	db.state = battle->si.gateState;
+	if (battle->si.wallState[EWallPart::GATE] == EWallState::DESTROYED)
 	{
 		db.state = EGateState::DESTROYED;
 	}
 	else if (db.state == EGateState::OPENED)
 	{
-		if (!gs->curB->battleGetStackByPos(BattleHex(ESiegeHex::GATE_OUTER), false) &&
-			!gs->curB->battleGetStackByPos(BattleHex(ESiegeHex::GATE_INNER), false))
+		if (!battle->battleGetStackByPos(BattleHex(ESiegeHex::GATE_OUTER), false) &&
+			!battle->battleGetStackByPos(BattleHex(ESiegeHex::GATE_INNER), false))
 		{
-			if (gs->curB->town->subID == ETownType::FORTRESS)
+			if (battle->town->subID == ETownType::FORTRESS)
 			{
-				if (!gs->curB->battleGetStackByPos(BattleHex(ESiegeHex::GATE_BRIDGE), false))
+				if (!battle->battleGetStackByPos(BattleHex(ESiegeHex::GATE_BRIDGE), false))
 					db.state = EGateState::CLOSED;
 			}
-			else if (gs->curB->battleGetStackByPos(BattleHex(ESiegeHex::GATE_BRIDGE)))
+			else if (battle->battleGetStackByPos(BattleHex(ESiegeHex::GATE_BRIDGE)))
 				db.state = EGateState::BLOCKED;
 			else
 				db.state = EGateState::CLOSED;
 		}
 	}
-	else if (gs->curB->battleGetStackByPos(BattleHex(ESiegeHex::GATE_BRIDGE), false))
+	else if (battle->battleGetStackByPos(BattleHex(ESiegeHex::GATE_BRIDGE), false))
 		db.state = EGateState::BLOCKED;
 	else
 		db.state = EGateState::CLOSED;
 
-	if (db.state != gs->curB->si.gateState)
+	if (db.state != battle->si.gateState)
 		sendAndApply(&db);
 }
 
-bool CGameHandler::makeBattleAction(BattleAction &ba)
+bool CGameHandler::makeBattleAction(BattleInfo * battle, BattleAction &ba)
 {
 	bool ok = true;
+	auto ongoing = getOngoingBattle(battle->battleID);
 
-	const CStack *stack = battleGetStackByID(ba.stackNumber); //may be nullptr if action is not about stack
-	const CStack *destinationStack = ba.actionType == Battle::WALK_AND_ATTACK ? gs->curB->battleGetStackByPos(ba.additionalInfo)
-								   : ba.actionType == Battle::SHOOT			  ? gs->curB->battleGetStackByPos(ba.destinationTile)
+	const CStack *stack = battle->battleGetStackByID(ba.stackNumber); //may be nullptr if action is not about stack
+	const CStack *destinationStack = ba.actionType == Battle::WALK_AND_ATTACK ? battle->battleGetStackByPos(ba.additionalInfo)
+								   : ba.actionType == Battle::SHOOT			  ? battle->battleGetStackByPos(ba.destinationTile)
 																			  : nullptr;
-	const bool isAboutActiveStack = stack && (stack == battleActiveStack());
+	const bool isAboutActiveStack = stack && (stack == battle->battleActiveStack());
 
 	logGlobal->trace(
 		"Making action: type=%d; side=%d; stack=%s; dst=%s; additionalInfo=%d; stackAtDst=%s",
@@ -3786,9 +4007,9 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 			return false;
 		}
 
-		if (battleTacticDist())
+		if (battle->battleTacticDist())
 		{
-			if (stack && stack->side != battleGetTacticsSide())
+			if (stack && stack->side != battle->battleGetTacticsSide())
 			{
 				complain("This is not a stack of side that has tactics!");
 				return false;
@@ -3801,14 +4022,18 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 		}
 	}
 
-	auto wrapAction = [this](BattleAction &ba)
+	auto wrapAction = [this, battle](BattleAction &ba)
 	{
 		StartAction startAction(ba);
+		startAction.battleID = battle->battleID;
 		sendAndApply(&startAction);
 
-		return vstd::makeScopeGuard([&]()
+		const BattleID battleID = battle->battleID;
+		return vstd::makeScopeGuard([this, battleID]()
 		{
-			sendAndApply(&end_action);
+			EndAction endAction;
+			endAction.battleID = battleID;
+			sendAndApply(&endAction);
 		});
 	};
 
@@ -3824,7 +4049,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 	case Battle::WALK:
 		{
 			auto wrapper = wrapAction(ba);
-			int walkedTiles = moveStack(ba.stackNumber,ba.destinationTile); //move
+			int walkedTiles = moveStack(battle, ba.stackNumber,ba.destinationTile); //move
 			if (!walkedTiles)
 				complain("Stack failed movement!");
 			break;
@@ -3833,6 +4058,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 		{
 			//defensive stance
 			SetStackEffect sse;
+			sse.battleID = battle->battleID;
 			Bonus bonus1(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, 20, -1, PrimarySkill::DEFENSE, Bonus::PERCENT_TO_ALL);
 			Bonus bonus2(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, stack->valOfBonuses(Bonus::DEFENSIVE_STANCE),
 				 -1, PrimarySkill::DEFENSE, Bonus::ADDITIVE_VALUE);
@@ -3866,16 +4092,16 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 		}
 	case Battle::RETREAT: //retreat/flee
 		{
-			if (!gs->curB->battleCanFlee(gs->curB->sides.at(ba.side).color))
+			if (!battle->battleCanFlee(battle->sides.at(ba.side).color))
 				complain("Cannot retreat!");
 			else
-				setBattleResult(BattleResult::ESCAPE, !ba.side); //surrendering side loses
+				setBattleResult(battle, BattleResult::ESCAPE, !ba.side); //surrendering side loses
 			break;
 		}
 	case Battle::SURRENDER:
 		{
-			PlayerColor player = gs->curB->sides.at(ba.side).color;
-			int cost = gs->curB->battleGetSurrenderCost(player);
+			PlayerColor player = battle->sides.at(ba.side).color;
+			int cost = battle->battleGetSurrenderCost(player);
 			if (cost < 0)
 				complain("Cannot surrender!");
 			else if (getResource(player, Res::GOLD) < cost)
@@ -3883,7 +4109,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 			else
 			{
 				giveResource(player, Res::GOLD, -cost);
-				setBattleResult(BattleResult::SURRENDER, !ba.side); //surrendering side loses
+				setBattleResult(battle, BattleResult::SURRENDER, !ba.side); //surrendering side loses
 			}
 			break;
 		}
@@ -3896,7 +4122,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 			}
 
 			BattleHex startingPos = stack->position;
-			int distance = moveStack(ba.stackNumber, ba.destinationTile);
+			int distance = moveStack(battle, ba.stackNumber, ba.destinationTile);
 
 			logGlobal->trace("%s will attack %s", stack->nodeName(), destinationStack->nodeName());
 
@@ -3942,10 +4168,10 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 					&& stack->alive()) //probably not needed
 				{
 					BattleAttack bat;
-					prepareAttack(bat, destinationStack, stack, 0, stack->position);
+					prepareAttack(battle, bat, destinationStack, stack, 0, stack->position);
 					bat.flags |= BattleAttack::COUNTER;
 					sendAndApply(&bat);
-					handleAfterAttackCasting(bat);
+					handleAfterAttackCasting(battle, bat);
 				}
 
 				if (stack &&
@@ -3953,11 +4179,11 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 					destinationStack->alive())
 				{
 					BattleAttack bat;
-					prepareAttack(bat, stack, destinationStack, (i ? 0 : distance),  ba.additionalInfo); //no distance travelled on second attack
-					//prepareAttack(bat, stack, stackAtEnd, 0, ba.additionalInfo);
-					handleAttackBeforeCasting(&bat); //only before first attack
+					prepareAttack(battle, bat, stack, destinationStack, (i ? 0 : distance),  ba.additionalInfo); //no distance travelled on second attack
+					//prepareAttack(battle, bat, stack, stackAtEnd, 0, ba.additionalInfo);
+					handleAttackBeforeCasting(battle, &bat); //only before first attack
 					sendAndApply(&bat);
-					handleAfterAttackCasting(bat);
+					handleAfterAttackCasting(battle, bat);
 				}
 
 				//counterattack
@@ -3968,24 +4194,24 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 					&& stack->alive()) //attacker may have died (fire shield)
 				{
 					BattleAttack bat;
-					prepareAttack(bat, destinationStack, stack, 0, stack->position);
+					prepareAttack(battle, bat, destinationStack, stack, 0, stack->position);
 					bat.flags |= BattleAttack::COUNTER;
 					sendAndApply(&bat);
-					handleAfterAttackCasting(bat);
+					handleAfterAttackCasting(battle, bat);
 				}
 			}
 
 			//return
 			if (stack->hasBonusOfType(Bonus::RETURN_AFTER_STRIKE) && startingPos != stack->position && stack->alive())
 			{
-				moveStack(ba.stackNumber, startingPos);
+				moveStack(battle, ba.stackNumber, startingPos);
 				//NOTE: curStack->ID == ba.stackNumber (rev 1431)
 			}
 			break;
 		}
 	case Battle::SHOOT:
 		{
-			if (!gs->curB->battleCanShoot(stack, ba.destinationTile))
+			if (!battle->battleCanShoot(stack, ba.destinationTile))
 			{
 				complain("Cannot shoot!");
 				break;
@@ -4001,36 +4227,36 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 			{
 				BattleAttack bat;
 				bat.flags |= BattleAttack::SHOT;
-				prepareAttack(bat, stack, destinationStack, 0, ba.destinationTile);
-				handleAttackBeforeCasting(&bat);
+				prepareAttack(battle, bat, stack, destinationStack, 0, ba.destinationTile);
+				handleAttackBeforeCasting(battle, &bat);
 				sendAndApply(&bat);
-				handleAfterAttackCasting(bat);
+				handleAfterAttackCasting(battle, bat);
 			}
 
 			//ranged counterattack
 			if (destinationStack->hasBonusOfType(Bonus::RANGED_RETALIATION)
 				&& !stack->hasBonusOfType(Bonus::BLOCKS_RANGED_RETALIATION)
 				&& destinationStack->ableToRetaliate()
-				&& gs->curB->battleCanShoot(destinationStack, stack->position)
+				&& battle->battleCanShoot(destinationStack, stack->position)
 				&& stack->alive()) //attacker may have died (fire shield)
 			{
 				BattleAttack bat;
-				prepareAttack(bat, destinationStack, stack, 0, stack->position);
+				prepareAttack(battle, bat, destinationStack, stack, 0, stack->position);
 				bat.flags |= BattleAttack::COUNTER | BattleAttack::SHOT;
 				sendAndApply(&bat);
-				handleAfterAttackCasting(bat);
+				handleAfterAttackCasting(battle, bat);
 			}
 
 			//extra shot(s) for ballista, based on artillery skill
 			if(stack->getCreature()->idNumber == CreatureID::BALLISTA)
 			{
-				const CGHeroInstance * attackingHero = gs->curB->battleGetFightingHero(ba.side);
+				const CGHeroInstance * attackingHero = battle->battleGetFightingHero(ba.side);
 				int ballistaBonusAttacks = attackingHero->valOfBonuses(Bonus::SECONDARY_SKILL_VAL2, SecondarySkill::ARTILLERY);
 				while(destinationStack->alive() && ballistaBonusAttacks-- > 0)
 				{
 					BattleAttack bat2;
 					bat2.flags |= BattleAttack::SHOT;
-					prepareAttack(bat2, stack, destinationStack, 0, ba.destinationTile);
+					prepareAttack(battle, bat2, stack, destinationStack, 0, ba.destinationTile);
 					sendAndApply(&bat2);
 				}
 			}
@@ -4048,9 +4274,9 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 				{
 					BattleAttack bat;
 					bat.flags |= BattleAttack::SHOT;
-					prepareAttack(bat, stack, destinationStack, 0, ba.destinationTile);
+					prepareAttack(battle, bat, stack, destinationStack, 0, ba.destinationTile);
 					sendAndApply(&bat);
-					handleAfterAttackCasting(bat);
+					handleAfterAttackCasting(battle, bat);
 				}
 			}
 			break;
@@ -4080,7 +4306,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 
 			auto wrapper = wrapAction(ba);
 
-			const CGHeroInstance * attackingHero = gs->curB->battleGetFightingHero(ba.side);
+			const CGHeroInstance * attackingHero = battle->battleGetFightingHero(ba.side);
 
 			CHeroHandler::SBallisticsLevelInfo sbi;
 			if(stack->getCreature()->idNumber == CreatureID::CATAPULT)
@@ -4091,15 +4317,15 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 				sbi.shots += std::max(stack->valOfBonuses(Bonus::CATAPULT_EXTRA_SHOTS), 0);
 			}
 
-			auto wallPart = gs->curB->battleHexToWallPart(ba.destinationTile);
-			if (!gs->curB->isWallPartPotentiallyAttackable(wallPart))
+			auto wallPart = battle->battleHexToWallPart(ba.destinationTile);
+			if (!battle->isWallPartPotentiallyAttackable(wallPart))
 			{
 				complain("catapult tried to attack non-catapultable hex!");
 				break;
 			}
 
 			//in successive iterations damage is dealt but not yet subtracted from wall's HPs
-			auto &currentHP = gs->curB->si.wallState;
+			auto &currentHP = battle->si.wallState;
 
 			if (currentHP.at(wallPart) == EWallState::DESTROYED  ||  currentHP.at(wallPart) == EWallState::NONE)
 			{
@@ -4140,6 +4366,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 					break;
 
 				CatapultAttack ca; //package for clients
+				ca.battleID = battle->battleID;
 				CatapultAttack::AttackInfo attack;
 				attack.attackedPart = attackedPart;
 				attack.destinationTile = ba.destinationTile;
@@ -4161,7 +4388,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 					}
 				}
 				// attacked tile may have changed - update destination
-				attack.destinationTile = gs->curB->wallPartToBattleHex(EWallPart::EWallPart(attack.attackedPart));
+				attack.destinationTile = battle->wallPartToBattleHex(EWallPart::EWallPart(attack.attackedPart));
 
 				logGlobal->trace("Catapult attacks %d dealing %d damage", (int)attack.attackedPart, (int)attack.damageDealt);
 
@@ -4184,7 +4411,8 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 					}
 
 					BattleStacksRemoved bsr;
-					for (auto & elem : gs->curB->stacks)
+					bsr.battleID = battle->battleID;
+					for (auto & elem : battle->stacks)
 					{
 						if (elem->position == posRemove)
 						{
@@ -4206,9 +4434,9 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 		case Battle::STACK_HEAL: //healing with First Aid Tent
 		{
 			auto wrapper = wrapAction(ba);
-			const CGHeroInstance * attackingHero = gs->curB->battleGetFightingHero(ba.side);
-			const CStack *healer = gs->curB->battleGetStackByID(ba.stackNumber),
-				*destStack = gs->curB->battleGetStackByPos(ba.destinationTile);
+			const CGHeroInstance * attackingHero = battle->battleGetFightingHero(ba.side);
+			const CStack *healer = battle->battleGetStackByID(ba.stackNumber),
+				*destStack = battle->battleGetStackByPos(ba.destinationTile);
 
 
 			if(healer == nullptr || destStack == nullptr || !healer->hasBonusOfType(Bonus::HEALER))
@@ -4229,6 +4457,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 				else
 				{
 					StacksHealedOrResurrected shr;
+					shr.battleID = battle->battleID;
 					shr.lifeDrain = false;
 					shr.tentHealing = true;
 					shr.cure = false;
@@ -4248,11 +4477,12 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 			//TODO: From Strategija:
 			//Summon Demon is a level 2 spell.
 		{
-			const CStack *summoner = gs->curB->battleGetStackByID(ba.stackNumber),
-				*destStack = gs->curB->battleGetStackByPos(ba.destinationTile, false);
+			const CStack *summoner = battle->battleGetStackByID(ba.stackNumber),
+				*destStack = battle->battleGetStackByPos(ba.destinationTile, false);
 
 			CreatureID summonedType(summoner->getBonusLocalFirst(Selector::type(Bonus::DAEMON_SUMMONING))->subtype);//in case summoner can summon more than one type of monsters... scream!
 			BattleStackAdded bsa;
+			bsa.battleID = battle->battleID;
 			bsa.side = summoner->side;
 
 			bsa.creID = summonedType;
@@ -4264,7 +4494,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 
 			bsa.amount = std::min(canRiseAmount, destStack->baseAmount);
 
-			bsa.pos = gs->curB->getAvaliableHex(bsa.creID, bsa.side, destStack->position);
+			bsa.pos = battle->getAvaliableHex(bsa.creID, bsa.side, destStack->position);
 			bsa.summoned = false;
 
 			if (bsa.amount) //there's rare possibility single creature cannot rise desired type
@@ -4272,11 +4502,13 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 				auto wrapper = wrapAction(ba);
 
 				BattleStacksRemoved bsr; //remove body
+				bsr.battleID = battle->battleID;
 				bsr.stackIDs.insert(destStack->ID);
 				sendAndApply(&bsr);
 				sendAndApply(&bsa);
 
 				BattleSetStackProperty ssp;
+				ssp.battleID = battle->battleID;
 				ssp.stackID = ba.stackNumber;
 				ssp.which = BattleSetStackProperty::CASTS; //reduce number of casts
 				ssp.val = -1;
@@ -4289,7 +4521,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 		{
 			auto wrapper = wrapAction(ba);
 
-			const CStack * stack = gs->curB->battleGetStackByID(ba.stackNumber);
+			const CStack * stack = battle->battleGetStackByID(ba.stackNumber);
 			SpellID spellID = SpellID(ba.additionalInfo);
 			BattleHex destination(ba.destinationTile);
 
@@ -4297,15 +4529,15 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 			const std::shared_ptr<Bonus> spellcaster = stack->getBonusLocalFirst(Selector::typeSubtype(Bonus::SPELLCASTER, spellID));
 
 			//TODO special bonus for genies ability
-			if (randSpellcaster && battleGetRandomStackSpell(getRandomGenerator(), stack, CBattleInfoCallback::RANDOM_AIMED) < 0)
-				spellID = battleGetRandomStackSpell(getRandomGenerator(), stack, CBattleInfoCallback::RANDOM_GENIE);
+			if (randSpellcaster && battle->battleGetRandomStackSpell(getRandomGenerator(), stack, CBattleInfoCallback::RANDOM_AIMED) < 0)
+				spellID = battle->battleGetRandomStackSpell(getRandomGenerator(), stack, CBattleInfoCallback::RANDOM_GENIE);
 
 			if (spellID < 0)
 				complain("That stack can't cast spells!");
 			else
 			{
 				const CSpell * spell = SpellID(spellID).toSpell();
-				BattleSpellCastParameters parameters(gs->curB, stack, spell);
+				BattleSpellCastParameters parameters(battle, stack, spell);
 				parameters.spellLvl = 0;
 				if (spellcaster)
 					vstd::amax(parameters.spellLvl, spellcaster->val);
@@ -4322,9 +4554,9 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 	}
 	if(ba.actionType == Battle::DAEMON_SUMMONING || ba.actionType == Battle::WAIT || ba.actionType == Battle::DEFEND
 			|| ba.actionType == Battle::SHOOT || ba.actionType == Battle::MONSTER_SPELL)
-		handleDamageFromObstacle(stack);
-	if(ba.stackNumber == gs->curB->activeStack || battleResult.get()) //active stack has moved or battle has finished
-		battleMadeAction.setn(true);
+		handleDamageFromObstacle(battle, stack);
+	if(ongoing->result.get() || ba.stackNumber == battle->activeStack) //battle has finished or active stack has moved
+		ongoing->madeAction.setn(true);
 	return ok;
 }
 
@@ -4396,7 +4628,7 @@ void CGameHandler::playerMessage(PlayerColor player, const std::string &message,
 	}
 }
 
-bool CGameHandler::makeCustomAction(BattleAction &ba)
+bool CGameHandler::makeCustomAction(BattleInfo * battle, BattleAction &ba)
 {
 	switch(ba.actionType)
 	{
@@ -4404,7 +4636,7 @@ bool CGameHandler::makeCustomAction(BattleAction &ba)
 		{
 			COMPLAIN_RET_FALSE_IF(ba.side > 1, "Side must be 0 or 1!");
 
-			const CGHeroInstance *h = gs->curB->battleGetFightingHero(ba.side);
+			const CGHeroInstance *h = battle->battleGetFightingHero(ba.side);
 			COMPLAIN_RET_FALSE_IF((!h), "Wrong caster!");
 
 			const CSpell * s = SpellID(ba.additionalInfo).toSpell();
@@ -4414,13 +4646,13 @@ bool CGameHandler::makeCustomAction(BattleAction &ba)
 				return false;
 			}
 
-			BattleSpellCastParameters parameters(gs->curB, h, s);
+			BattleSpellCastParameters parameters(battle, h, s);
 			parameters.aimToHex(ba.destinationTile);//todo: allow multiple destinations
 			parameters.mode = ECastingMode::HERO_CASTING;
 			if (ba.selectedStack >= 0)
-				parameters.aimToStack(gs->curB->battleGetStackByID(ba.selectedStack, false));
+				parameters.aimToStack(battle->battleGetStackByID(ba.selectedStack, false));
 
-			ESpellCastProblem::ESpellCastProblem escp = s->canBeCast(gs->curB, ECastingMode::HERO_CASTING, h);//todo: should we check aimed cast?
+			ESpellCastProblem::ESpellCastProblem escp = s->canBeCast(battle, ECastingMode::HERO_CASTING, h);//todo: should we check aimed cast?
 			if (escp != ESpellCastProblem::OK)
 			{
 				logGlobal->warn("Spell cannot be cast! Problem: %d", escp);
@@ -4428,21 +4660,26 @@ bool CGameHandler::makeCustomAction(BattleAction &ba)
 			}
 
 			StartAction start_action(ba);
+			start_action.battleID = battle->battleID;
 			sendAndApply(&start_action); //start spell casting
 
 			parameters.cast(spellEnv);
 
+			EndAction end_action;
+			end_action.battleID = battle->battleID;
 			sendAndApply(&end_action);
-			if (!gs->curB->battleGetStackByID(gs->curB->activeStack))
+
+			auto ongoing = getOngoingBattle(battle->battleID);
+			if (!battle->battleGetStackByID(battle->activeStack))
 			{
-				battleMadeAction.setn(true);
+				ongoing->madeAction.setn(true);
 			}
-			checkBattleStateChanges();
-			if (battleResult.get())
+			checkBattleStateChanges(battle);
+			if (ongoing->result.get())
 			{
-				battleMadeAction.setn(true);
+				ongoing->madeAction.setn(true);
 				//battle will be ended by startBattle function
-				//endBattle(gs->curB->tile, gs->curB->heroes[0], gs->curB->heroes[1]);
+				//endBattle(battle->tile, battle->heroes[0], battle->heroes[1]);
 			}
 
 			return true;
@@ -4453,18 +4690,19 @@ bool CGameHandler::makeCustomAction(BattleAction &ba)
 }
 
 
-void CGameHandler::stackEnchantedTrigger(const CStack * st)
+void CGameHandler::stackEnchantedTrigger(BattleInfo * battle, const CStack * st)
 {
 	auto bl = *(st->getBonuses(Selector::type(Bonus::ENCHANTED)));
 	for(auto b : bl)
 	{
 		SetStackEffect sse;
+		sse.battleID = battle->battleID;
 		int val = bl.valOfBonuses(Selector::typeSubtype(b->type, b->subtype));
 		if(val > 3)
 		{
-			for(auto s : gs->curB->battleGetAllStacks())
+			for(auto s : battle->battleGetAllStacks())
 			{
-				if(battleMatchOwner(st, s, true) && s->isValidTarget()) //all allied
+				if(battle->battleMatchOwner(st, s, true) && s->isValidTarget()) //all allied
 					sse.stacks.push_back (s->ID);
 			}
 		}
@@ -4483,9 +4721,10 @@ void CGameHandler::stackEnchantedTrigger(const CStack * st)
 	}
 }
 
-void CGameHandler::stackTurnTrigger(const CStack *st)
+void CGameHandler::stackTurnTrigger(BattleInfo * battle, const CStack *st)
 {
 	BattleTriggerEffect bte;
+	bte.battleID = battle->battleID;
 	bte.stackID = st->ID;
 	bte.effect = -1;
 	bte.val = 0;
@@ -4497,11 +4736,11 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 		{
 			bool unbind = true;
 			BonusList bl = *(st->getBonuses(Selector::type(Bonus::BIND_EFFECT)));
-			std::set<const CStack*> stacks = gs->curB-> batteAdjacentCreatures(st);
+			std::set<const CStack*> stacks = battle->batteAdjacentCreatures(st);
 
 			for (auto b : bl)
 			{
-				const CStack * stack = gs->curB->battleGetStackByID(b->additionalInfo); //binding stack must be alive and adjacent
+				const CStack * stack = battle->battleGetStackByID(b->additionalInfo); //binding stack must be alive and adjacent
 				if (stack)
 				{
 					if (vstd::contains(stacks, stack)) //binding stack is still present
@@ -4513,6 +4752,7 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 			if (unbind)
 			{
 				BattleSetStackProperty ssp;
+				ssp.battleID = battle->battleID;
 				ssp.which = BattleSetStackProperty::UNBIND;
 				ssp.stackID = st->ID;
 				sendAndApply(&ssp);
@@ -4547,8 +4787,8 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 		}
 		if (st->hasBonusOfType(Bonus::MANA_DRAIN) && !vstd::contains(st->state, EBattleStackState::DRAINED_MANA))
 		{
-			const PlayerColor opponent = gs->curB->theOtherPlayer(gs->curB->battleGetOwner(st));
-			const CGHeroInstance * opponentHero = gs->curB->getHero(opponent);
+			const PlayerColor opponent = battle->theOtherPlayer(battle->battleGetOwner(st));
+			const CGHeroInstance * opponentHero = battle->getHero(opponent);
 			if (opponentHero)
 			{
 				ui32 manaDrained = st->valOfBonuses(Bonus::MANA_DRAIN);
@@ -4565,9 +4805,9 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 		if (st->isLiving() && !st->hasBonusOfType(Bonus::FEARLESS))
 		{
 			bool fearsomeCreature = false;
-			for (CStack * stack : gs->curB->stacks)
+			for (CStack * stack : battle->stacks)
 			{
-				if (battleMatchOwner(st, stack) && stack->alive() && stack->hasBonusOfType(Bonus::FEAR))
+				if (battle->battleMatchOwner(st, stack) && stack->alive() && stack->hasBonusOfType(Bonus::FEAR))
 				{
 					fearsomeCreature = true;
 					break;
@@ -4583,8 +4823,8 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 			}
 		}
 		BonusList bl = *(st->getBonuses(Selector::type(Bonus::ENCHANTER)));
-		int side = gs->curB->whatSide(st->owner);
-		if(st->canCast() && !gs->curB->sides.at(side).enchanterCounter)
+		int side = battle->whatSide(st->owner);
+		if(st->canCast() && !battle->sides.at(side).enchanterCounter)
 		{
 			bool cast = false;
 			while (!bl.empty() && !cast)
@@ -4594,7 +4834,7 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 				const CSpell * spell = SpellID(spellID).toSpell();
 				bl.remove_if([&bonus](const Bonus* b){return b==bonus.get();});
 
-				BattleSpellCastParameters parameters(gs->curB, st, spell);
+				BattleSpellCastParameters parameters(battle, st, spell);
 				parameters.spellLvl = bonus->val;
 				parameters.effectLevel = bonus->val;//todo: recheck
 				parameters.mode = ECastingMode::ENCHANTER_CASTING;
@@ -4604,6 +4844,7 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 				{
 					//todo: move to mechanics
 					BattleSetStackProperty ssp;
+					ssp.battleID = battle->battleID;
 					ssp.which = BattleSetStackProperty::ENCHANTER_COUNTER;
 					ssp.absolute = false;
 					ssp.val = bonus->additionalInfo; //increase cooldown counter
@@ -4615,12 +4856,12 @@ void CGameHandler::stackTurnTrigger(const CStack *st)
 	}
 }
 
-bool CGameHandler::handleDamageFromObstacle(const CStack * curStack, bool stackIsMoving)
+bool CGameHandler::handleDamageFromObstacle(BattleInfo * battle, const CStack * curStack, bool stackIsMoving)
 {
 	if(!curStack->alive())
 		return false;
 	bool containDamageFromMoat = false;
-	for(auto & obstacle : getAllAffectedObstaclesByStack(curStack))
+	for(auto & obstacle : battle->getAllAffectedObstaclesByStack(curStack))
 	{
 		if(!curStack->alive() || obstacle->stopsMovement() && stackIsMoving == true)
 			return false;
@@ -4633,11 +4874,11 @@ bool CGameHandler::handleDamageFromObstacle(const CStack * curStack, bool stackI
 		const SpellCreatedObstacle * spellObstacle = dynamic_cast<const SpellCreatedObstacle *>(obstacle.get()); //not nice but we may need spell params
 
 		const ui8 side = curStack->side; //if enemy is defending (false = 0), side of enemy hero is 1 (true)
-		const CGHeroInstance * hero = gs->curB->battleGetFightingHero(side);//FIXME: there may be no hero - landmines in Tower
+		const CGHeroInstance * hero = battle->battleGetFightingHero(side);//FIXME: there may be no hero - landmines in Tower
 
 		if(obstacle->obstacleType == CObstacleInstance::MOAT)
 		{
-			damage = battleGetMoatDmg();
+			damage = battle->battleGetMoatDmg();
 			if(!containDamageFromMoat)
 				containDamageFromMoat = true;
 			else
@@ -4648,7 +4889,7 @@ bool CGameHandler::handleDamageFromObstacle(const CStack * curStack, bool stackI
 			if(!spellObstacle)
 				COMPLAIN_RET("Invalid obstacle instance");
 			//You don't get hit by a Mine you can see.
-			if(gs->curB->battleIsObstacleVisibleForSide(*obstacle, (BattlePerspective::BattlePerspective)side))
+			if(battle->battleIsObstacleVisibleForSide(*obstacle, (BattlePerspective::BattlePerspective)side))
 				continue;
 			oneTimeObstacle = true;
 			effect = 82;
@@ -4688,11 +4929,12 @@ bool CGameHandler::handleDamageFromObstacle(const CStack * curStack, bool stackI
 		curStack->prepareAttacked(bsa, getRandomGenerator());
 
 		StacksInjured si;
+		si.battleID = battle->battleID;
 		si.stacks.push_back(bsa);
 		sendAndApply(&si);
 
 		if(oneTimeObstacle)
-			removeObstacle(*obstacle);
+			removeObstacle(battle, *obstacle);
 	}
 	if(!curStack->alive())
 		return false;
@@ -5160,12 +5402,11 @@ void CGameHandler::checkVictoryLossConditionsForPlayer(PlayerColor player)
 			checkVictoryLossConditions(playerColors);
 		}
 
-		auto playerInfo = getPlayer(gs->currentPlayer, false);
-		// If we are called before the actual game start, there might be no current player
-		if (playerInfo && playerInfo->status != EPlayerStatus::INGAME)
+		// If player making turn has lost his turn must be over as well, several AI players may be making turn at once
+		for (auto & elem : gs->players)
 		{
-			// If player making turn has lost his turn must be over as well
-			states.setFlag(gs->currentPlayer, &PlayerStatus::makingTurn, false);
+			if (elem.second.status != EPlayerStatus::INGAME && isPlayerMakingTurn(elem.first))
+				states.setFlag(elem.first, &PlayerStatus::makingTurn, false);
 		}
 	}
 }
@@ -5234,7 +5475,7 @@ bool CGameHandler::dig(const CGHeroInstance *h)
 	return true;
 }
 
-void CGameHandler::attackCasting(const BattleAttack & bat, Bonus::BonusType attackMode, const CStack * attacker)
+void CGameHandler::attackCasting(BattleInfo * battle, const BattleAttack & bat, Bonus::BonusType attackMode, const CStack * attacker)
 {
 	if (attacker->hasBonusOfType(attackMode))
 	{
@@ -5251,7 +5492,7 @@ void CGameHandler::attackCasting(const BattleAttack & bat, Bonus::BonusType atta
 			{
 				if ((elem.newHealth.fullUnits > 0 || elem.newHealth.firstHPleft > 0) && !elem.isSecondary()) //apply effects only to first target stack if it's alive
 				{
-					oneOfAttacked = gs->curB->battleGetStackByID(elem.stackAttacked);
+					oneOfAttacked = battle->battleGetStackByID(elem.stackAttacked);
 					break;
 				}
 			}
@@ -5274,7 +5515,7 @@ void CGameHandler::attackCasting(const BattleAttack & bat, Bonus::BonusType atta
 			vstd::amin(chance, 100);
 
 			const CSpell * spell = SpellID(spellID).toSpell();
-			if(spell->canBeCastAt(gs->curB, ECastingMode::AFTER_ATTACK_CASTING, attacker, oneOfAttacked->position) != ESpellCastProblem::OK)
+			if(spell->canBeCastAt(battle, ECastingMode::AFTER_ATTACK_CASTING, attacker, oneOfAttacked->position) != ESpellCastProblem::OK)
 				continue;
 
 			//check if spell should be cast (probability handling)
@@ -5285,7 +5526,7 @@ void CGameHandler::attackCasting(const BattleAttack & bat, Bonus::BonusType atta
 			if (castMe) //stacks use 0 spell power. If needed, default = 3 or custom value is used
 			{
 				logGlobal->debug("battle spell cast");
-				BattleSpellCastParameters parameters(gs->curB, attacker, spell);
+				BattleSpellCastParameters parameters(battle, attacker, spell);
 				parameters.spellLvl = spellLevel;
 				parameters.effectLevel = spellLevel;
 				parameters.aimToStack(oneOfAttacked);
@@ -5296,26 +5537,26 @@ void CGameHandler::attackCasting(const BattleAttack & bat, Bonus::BonusType atta
 	}
 }
 
-void CGameHandler::handleAttackBeforeCasting(BattleAttack *bat)
+void CGameHandler::handleAttackBeforeCasting(BattleInfo * battle, BattleAttack *bat)
 {
-	const CStack * attacker = gs->curB->battleGetStackByID(bat->stackAttacking);
-	attackCasting(*bat, Bonus::SPELL_BEFORE_ATTACK, attacker); //no death stare / acid breath needed?
+	const CStack * attacker = battle->battleGetStackByID(bat->stackAttacking);
+	attackCasting(battle, *bat, Bonus::SPELL_BEFORE_ATTACK, attacker); //no death stare / acid breath needed?
 	// filter possibly dead stacks
 	bat->bsa.erase(std::remove_if(bat->bsa.begin(), bat->bsa.end(),
-	               [this](const BattleStackAttacked &bsa)
+	               [battle](const BattleStackAttacked &bsa)
 	               {
-	                 return battleGetStackByID(bsa.stackAttacked) == nullptr;
+	                 return battle->battleGetStackByID(bsa.stackAttacked) == nullptr;
 	               }),
 	               bat->bsa.end());
 }
 
-void CGameHandler::handleAfterAttackCasting(const BattleAttack & bat)
+void CGameHandler::handleAfterAttackCasting(BattleInfo * battle, const BattleAttack & bat)
 {
-	const CStack * attacker = gs->curB->battleGetStackByID(bat.stackAttacking);
+	const CStack * attacker = battle->battleGetStackByID(bat.stackAttacking);
 	if (!attacker || bat.bsa.empty()) // can be already dead
 		return;
 
-	const CStack * defender = gs->curB->battleGetStackByID(bat.bsa.at(0).stackAttacked);
+	const CStack * defender = battle->battleGetStackByID(bat.bsa.at(0).stackAttacked);
 
 	if(!defender)
 		return;//already dead
@@ -5324,7 +5565,7 @@ void CGameHandler::handleAfterAttackCasting(const BattleAttack & bat)
 	{
 		const CSpell * spell = SpellID(spellID).toSpell();
 
-		BattleSpellCastParameters parameters(gs->curB, attacker, spell);
+		BattleSpellCastParameters parameters(battle, attacker, spell);
 		parameters.spellLvl = 0;
 		parameters.effectLevel = 0;
 		parameters.aimToStack(defender);
@@ -5333,7 +5574,7 @@ void CGameHandler::handleAfterAttackCasting(const BattleAttack & bat)
 		parameters.cast(spellEnv);
 	};
 
-	attackCasting(bat, Bonus::SPELL_AFTER_ATTACK, attacker);
+	attackCasting(battle, bat, Bonus::SPELL_AFTER_ATTACK, attacker);
 
 	if(!defender->alive())
 	{
@@ -5398,6 +5639,7 @@ void CGameHandler::handleAfterAttackCasting(const BattleAttack & bat)
 			return;
 
 		BattleStackAdded resurrectInfo;
+		resurrectInfo.battleID = battle->battleID;
 		resurrectInfo.pos = defender->position;
 		resurrectInfo.side = defender->side;
 
@@ -5414,6 +5656,7 @@ void CGameHandler::handleAfterAttackCasting(const BattleAttack & bat)
 			return; //wrong subtype
 
 		BattleStacksRemoved victimInfo;
+		victimInfo.battleID = battle->battleID;
 		victimInfo.stackIDs.insert(bat.bsa.at(0).stackAttacked);
 
 		sendAndApply(&victimInfo);
@@ -5442,6 +5685,7 @@ void CGameHandler::handleAfterAttackCasting(const BattleAttack & bat)
 			return;
 
 		BattleStackAttacked bsa;
+		bsa.battleID = battle->battleID;
 		bsa.attackerID = -1;
 		bsa.stackAttacked = defender->ID;
 		bsa.damageAmount = amountToDie * defender->getCreature()->MaxHealth();
@@ -5550,7 +5794,7 @@ bool CGameHandler::sacrificeArtifact(const IMarket * m, const CGHeroInstance * h
 	return true;
 }
 
-void CGameHandler::makeStackDoNothing(const CStack * next)
+void CGameHandler::makeStackDoNothing(BattleInfo * battle, const CStack * next)
 {
 	BattleAction doNothing;
 	doNothing.actionType = Battle::NO_ACTION;
@@ -5559,7 +5803,7 @@ void CGameHandler::makeStackDoNothing(const CStack * next)
 	doNothing.side = next->side;
 	doNothing.stackNumber = next->ID;
 
-	makeAutomaticAction(next, doNothing);
+	makeAutomaticAction(battle, next, doNothing);
 }
 
 bool CGameHandler::insertNewStack(const StackLocation &sl, const CCreature *c, TQuantity count)
@@ -5716,27 +5960,43 @@ bool CGameHandler::swapStacks(const StackLocation &sl1, const StackLocation &sl2
 	}
 }
 
-void CGameHandler::runBattle()
+void CGameHandler::runBattle(BattleID battleID)
 {
-	setBattle(gs->curB);
-	assert(gs->curB);
+	setThreadName("CGameHandler::runBattle");
+
+	BattleInfo * battle = gs->getBattle(battleID);
+	assert(battle);
+
+	fightBattle(battle);
+
+	endBattle(battle, battle->tile, battle->battleGetFightingHero(0), battle->battleGetFightingHero(1));
+
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	ongoingBattles.erase(battleID);
+}
+
+void CGameHandler::fightBattle(BattleInfo * battle)
+{
+	auto ongoing = getOngoingBattle(battle->battleID);
+	CondSh<bool> & battleMadeAction = ongoing->madeAction;
+	CondSh<BattleResult *> & battleResult = ongoing->result;
 	//TODO: pre-tactic stuff, call scripts etc.
 
 	//tactic round
 	{
-		while (gs->curB->tacticDistance && !battleResult.get())
+		while (battle->tacticDistance && !battleResult.get())
 			boost::this_thread::sleep(boost::posix_time::milliseconds(50));
 	}
 
 	//initial stacks appearance triggers, e.g. built-in bonus spells
-	auto initialStacks = gs->curB->stacks; //use temporary variable to outclude summoned stacks added to gs->curB->stacks from processing
+	auto initialStacks = battle->stacks; //use temporary variable to outclude summoned stacks added to battle->stacks from processing
 
 	for (CStack * stack : initialStacks)
 	{
 		if (stack->hasBonusOfType(Bonus::SUMMON_GUARDIANS))
 		{
 			const std::shared_ptr<Bonus> summonInfo = stack->getBonus(Selector::type(Bonus::SUMMON_GUARDIANS));
-			auto accessibility = getAccesibility();
+			auto accessibility = battle->getAccesibility();
 			CreatureID creatureData = CreatureID(summonInfo->subtype);
 			std::vector<BattleHex> targetHexes;
 			const bool targetIsBig = stack->getCreature()->isDoubleWide(); //target = creature to guard
@@ -5756,6 +6016,7 @@ void CGameHandler::runBattle()
 				if (accessibility.accessible(hex, guardianIsBig, stack->side)) //without this multiple creatures can occupy one hex
 				{
 					BattleStackAdded newStack;
+					newStack.battleID = battle->battleID;
 					newStack.amount = std::max(1, (int)(stack->getCount() * 0.01 * summonInfo->val));
 					newStack.creID = creatureData.num;
 					newStack.side = stack->side;
@@ -5766,13 +6027,13 @@ void CGameHandler::runBattle()
 			}
 		}
 
-		stackEnchantedTrigger(stack);
+		stackEnchantedTrigger(battle, stack);
 	}
 
 	//spells opening battle
 	for (int i = 0; i < 2; ++i)
 	{
-		auto h = gs->curB->battleGetFightingHero(i);
+		auto h = battle->battleGetFightingHero(i);
 		if (h)
 		{
 			TBonusListPtr bl = h->getBonuses(Selector::type(Bonus::OPENING_BATTLE_SPELL));
@@ -5781,7 +6042,7 @@ void CGameHandler::runBattle()
 			{
 				const CSpell * spell = SpellID(b->subtype).toSpell();
 
-				BattleSpellCastParameters parameters(gs->curB, h, spell);
+				BattleSpellCastParameters parameters(battle, h, spell);
 				parameters.spellLvl = 3;
 				parameters.effectLevel = 3;
 				parameters.mode = ECastingMode::PASSIVE_CASTING;
@@ -5797,24 +6058,25 @@ void CGameHandler::runBattle()
 	while (!battleResult.get()) //till the end of the battle ;]
 	{
 		BattleNextRound bnr;
-		bnr.round = gs->curB->round + 1;
+		bnr.battleID = battle->battleID;
+		bnr.round = battle->round + 1;
 		logGlobal->debug("Round %d", bnr.round);
 		sendAndApply(&bnr);
 
-		auto obstacles = gs->curB->obstacles; //we copy container, because we're going to modify it
+		auto obstacles = battle->obstacles; //we copy container, because we're going to modify it
 		for (auto &obstPtr : obstacles)
 		{
 			if (const SpellCreatedObstacle *sco = dynamic_cast<const SpellCreatedObstacle *>(obstPtr.get()))
 				if (sco->turnsRemaining == 0)
-					removeObstacle(*obstPtr);
+					removeObstacle(battle, *obstPtr);
 		}
 
-		const BattleInfo & curB = *gs->curB;
+		const BattleInfo & curB = *battle;
 
 		for(auto stack : curB.stacks)
 		{
 			if(stack->alive() && !firstRound)
-				stackEnchantedTrigger(stack);
+				stackEnchantedTrigger(battle, stack);
 		}
 
 		//stack loop
@@ -5832,6 +6094,7 @@ void CGameHandler::runBattle()
 			for (auto stack : stacksToRemove)
 			{
 				BattleStacksRemoved bsr;
+				bsr.battleID = battle->battleID;
 				bsr.stackIDs.insert(stack->ID);
 				sendAndApply(&bsr);
 			}
@@ -5839,8 +6102,8 @@ void CGameHandler::runBattle()
 			//check for bad morale => freeze
 			int nextStackMorale = next->MoraleVal();
 			if (nextStackMorale < 0 &&
-				!(NBonus::hasOfType(gs->curB->battleGetFightingHero(0), Bonus::BLOCK_MORALE)
-				   || NBonus::hasOfType(gs->curB->battleGetFightingHero(1), Bonus::BLOCK_MORALE)) //checking if gs->curB->heroes have (or don't have) morale blocking bonuses)
+				!(NBonus::hasOfType(battle->battleGetFightingHero(0), Bonus::BLOCK_MORALE)
+				   || NBonus::hasOfType(battle->battleGetFightingHero(1), Bonus::BLOCK_MORALE)) //checking if battle->heroes have (or don't have) morale blocking bonuses)
 				)
 			{
 				if (getRandomGenerator().nextInt(23) < -2 * nextStackMorale)
@@ -5852,7 +6115,7 @@ void CGameHandler::runBattle()
 					ba.side = next->side;
 					ba.stackNumber = next->ID;
 
-					makeAutomaticAction(next, ba);
+					makeAutomaticAction(battle, next, ba);
 					continue;
 				}
 			}
@@ -5870,18 +6133,18 @@ void CGameHandler::runBattle()
 					attack.additionalInfo = attackInfo.first->position;
 					attack.destinationTile = attackInfo.second;
 
-					makeAutomaticAction(next, attack);
+					makeAutomaticAction(battle, next, attack);
 					logGlobal->debug("Attacked nearest target %s", attackInfo.first->nodeName());
 				}
 				else
 				{
-					makeStackDoNothing(next);
+					makeStackDoNothing(battle, next);
 					logGlobal->debug("No target found");
 				}
 				continue;
 			}
 
-			const CGHeroInstance * curOwner = battleGetOwnerHero(next);
+			const CGHeroInstance * curOwner = battle->battleGetOwnerHero(next);
 			const int stackCreatureId = next->getCreature()->idNumber;
 
 			if ((stackCreatureId == CreatureID::ARROW_TOWERS || stackCreatureId == CreatureID::BALLISTA)
@@ -5892,7 +6155,7 @@ void CGameHandler::runBattle()
 				attack.side = next->side;
 				attack.stackNumber = next->ID;
 
-				for (auto & elem : gs->curB->stacks)
+				for (auto & elem : battle->stacks)
 				{
 					if (elem->owner != next->owner && elem->isValidTarget())
 					{
@@ -5901,7 +6164,7 @@ void CGameHandler::runBattle()
 					}
 				}
 
-				makeAutomaticAction(next, attack);
+				makeAutomaticAction(battle, next, attack);
 				continue;
 			}
 
@@ -5911,7 +6174,7 @@ void CGameHandler::runBattle()
 
 				if (attackableBattleHexes.empty())
 				{
-					makeStackDoNothing(next);
+					makeStackDoNothing(battle, next);
 					continue;
 				}
 
@@ -5925,21 +6188,21 @@ void CGameHandler::runBattle()
 					attack.side = next->side;
 					attack.stackNumber = next->ID;
 
-					makeAutomaticAction(next, attack);
+					makeAutomaticAction(battle, next, attack);
 					continue;
 				}
 			}
 
 			if (next->getCreature()->idNumber == CreatureID::FIRST_AID_TENT)
 			{
-				TStacks possibleStacks = battleGetStacksIf([=](const CStack * s)
+				TStacks possibleStacks = battle->battleGetStacksIf([=](const CStack * s)
 				{
 					return s->owner == next->owner && s->canBeHealed();
 				});
 
 				if (!possibleStacks.size())
 				{
-					makeStackDoNothing(next);
+					makeStackDoNothing(battle, next);
 					continue;
 				}
 
@@ -5955,7 +6218,7 @@ void CGameHandler::runBattle()
 					heal.side = next->side;
 					heal.stackNumber = next->ID;
 
-					makeAutomaticAction(next, heal);
+					makeAutomaticAction(battle, next, heal);
 					continue;
 				}
 			}
@@ -5966,17 +6229,19 @@ void CGameHandler::runBattle()
 			{//ask interface and wait for answer
 				if (!battleResult.get())
 				{
-					stackTurnTrigger(next); //various effects
+					stackTurnTrigger(battle, next); //various effects
 
 					if (vstd::contains(next->state, EBattleStackState::FEAR))
 					{
-						makeStackDoNothing(next); //end immediately if stack was affected by fear
+						makeStackDoNothing(battle, next); //end immediately if stack was affected by fear
 					}
 					else
 					{
 						logGlobal->trace("Activating %s", next->nodeName());
 						auto nextId = next->ID;
+						battleMadeAction.setn(false); //answer may come before we start waiting for it
 						BattleSetActiveStack sas;
+						sas.battleID = battle->battleID;
 						sas.stack = nextId;
 						sendAndApply(&sas);
 
@@ -5992,11 +6257,10 @@ void CGameHandler::runBattle()
 						};
 
 						boost::unique_lock<boost::mutex> lock(battleMadeAction.mx);
-						battleMadeAction.data = false;
 						while (!actionWasMade())
 						{
 							battleMadeAction.cond.wait(lock);
-							if (battleGetStackByID(nextId, false) != next)
+							if (battle->battleGetStackByID(nextId, false) != next)
 								next = nullptr; //it may be removed, while we wait
 						}
 					}
@@ -6008,7 +6272,7 @@ void CGameHandler::runBattle()
 					break;
 				}
 				//we're after action, all results applied
-				checkBattleStateChanges(); //check if this action ended the battle
+				checkBattleStateChanges(battle); //check if this action ended the battle
 
 				if (next != nullptr)
 				{
@@ -6020,13 +6284,14 @@ void CGameHandler::runBattle()
 						&& !vstd::contains(next->state, EBattleStackState::FEAR)
 						&&  next->alive()
 						&&  nextStackMorale > 0
-						&& !(NBonus::hasOfType(gs->curB->battleGetFightingHero(0), Bonus::BLOCK_MORALE)
-							|| NBonus::hasOfType(gs->curB->battleGetFightingHero(1), Bonus::BLOCK_MORALE)) //checking if gs->curB->heroes have (or don't have) morale blocking bonuses
+						&& !(NBonus::hasOfType(battle->battleGetFightingHero(0), Bonus::BLOCK_MORALE)
+							|| NBonus::hasOfType(battle->battleGetFightingHero(1), Bonus::BLOCK_MORALE)) //checking if battle->heroes have (or don't have) morale blocking bonuses
 						)
 					{
 						if (getRandomGenerator().nextInt(23) < nextStackMorale) //this stack hasn't got morale this turn
 						{
 							BattleTriggerEffect bte;
+							bte.battleID = battle->battleID;
 							bte.stackID = next->ID;
 							bte.effect = Bonus::MORALE;
 							bte.val = 1;
@@ -6048,19 +6313,18 @@ void CGameHandler::runBattle()
 		}
 		firstRound = false;
 	}
-
-	endBattle(gs->curB->tile, gs->curB->battleGetFightingHero(0), gs->curB->battleGetFightingHero(1));
 }
 
-bool CGameHandler::makeAutomaticAction(const CStack *stack, BattleAction &ba)
+bool CGameHandler::makeAutomaticAction(BattleInfo * battle, const CStack *stack, BattleAction &ba)
 {
 	BattleSetActiveStack bsa;
+	bsa.battleID = battle->battleID;
 	bsa.stack = stack->ID;
 	bsa.askPlayerInterface = false;
 	sendAndApply(&bsa);
 
-	bool ret = makeBattleAction(ba);
-	checkBattleStateChanges();
+	bool ret = makeBattleAction(battle, ba);
+	checkBattleStateChanges(battle);
 	return ret;
 }
 
@@ -6133,20 +6397,22 @@ void CGameHandler::giveHeroNewArtifact(const CGHeroInstance *h, const CArtifact
 	giveHeroArtifact(h, a, pos);
 }
 
-void CGameHandler::setBattleResult(BattleResult::EResult resultType, int victoriusSide)
+void CGameHandler::setBattleResult(BattleInfo * battle, BattleResult::EResult resultType, int victoriusSide)
 {
-	boost::unique_lock<boost::mutex> guard(battleResult.mx);
-	if (battleResult.data)
+	auto ongoing = getOngoingBattle(battle->battleID);
+	boost::unique_lock<boost::mutex> guard(ongoing->result.mx);
+	if (ongoing->result.data)
 	{
 		complain((boost::format("The battle result has been already set (to %d, asked to %d)")
-		          % battleResult.data->result % resultType).str());
+		          % ongoing->result.data->result % resultType).str());
 		return;
 	}
 	auto br = new BattleResult();
+	br->battleID = battle->battleID;
 	br->result = resultType;
 	br->winner = victoriusSide; //surrendering side loses
-	gs->curB->calculateCasualties(br->casualties);
-	battleResult.data = br;
+	battle->calculateCasualties(br->casualties);
+	ongoing->result.data = br;
 }
 
 void CGameHandler::commitPackage(CPackForClient *pack)
@@ -6316,9 +6582,10 @@ void CGameHandler::handleCheatCode(std::string & cheat, PlayerColor player, cons
 		cheated = false;
 }
 
-void CGameHandler::removeObstacle(const CObstacleInstance &obstacle)
+void CGameHandler::removeObstacle(BattleInfo * battle, const CObstacleInstance &obstacle)
 {
 	ObstaclesRemoved obsRem;
+	obsRem.battleID = battle->battleID;
 	obsRem.obstacles.insert(obstacle.uniqueID);
 	sendAndApply(&obsRem);
 }
@@ -6573,6 +6840,25 @@ CGameHandler::FinishingBattleHelper::FinishingBattleHelper()
 	remainingBattleQueriesCount = 0;
 }
 
+CGameHandler::OngoingBattle::OngoingBattle():
+	madeAction(false), result(nullptr)
+{
+}
+
+CGameHandler::OngoingBattle::~OngoingBattle()
+{
+	delete result.data;
+}
+
+std::shared_ptr<CGameHandler::OngoingBattle> CGameHandler::getOngoingBattle(BattleID battleID)
+{
+	boost::unique_lock<boost::mutex> lock(battlesMx);
+	auto i = ongoingBattles.find(battleID);
+	if(i == ongoingBattles.end())
+		return nullptr;
+	return i->second;
+}
+
 CRandomGenerator & CGameHandler::getRandomGenerator()
 {
 	return CRandomGenerator::getDefault();
@@ -12,6 +12,7 @@
 #include "../lib/FunctionList.h"
 #include "../lib/IGameCallback.h"
 #include "../lib/battle/BattleAction.h"
+#include "../lib/CondSh.h"
 #include "CQuery.h"
 
 class CGameHandler;
@@ -29,6 +30,9 @@ class CGHeroInstance;
 class IMarket;
 
 class SpellCastEnvironment;
+class CBackgroundSaver;
+class CPackLogWriter;
+class CSimultaneousTurns;
 
 struct PlayerStatus
 {
@@ -72,7 +76,7 @@ struct CasualtiesAfterBattle
 	void updateArmy(CGameHandler *gh);
 };
 
-class CGameHandler : public IGameCallback, CBattleInfoCallback
+class CGameHandler : public IGameCallback
 {
 public:
 	//use enums as parameters, because doMove(sth, true, false, true) is not readable
@@ -91,22 +95,48 @@ public:
 
 	SpellCastEnvironment * spellEnv;
 
+	std::unique_ptr<CBackgroundSaver> backgroundSaver; //writes snapshots of game state taken by save()
+	std::unique_ptr<CPackLogWriter> packLog; //records all packs if enabled by recordPacks()
+	std::unique_ptr<CSimultaneousTurns> simultaneousTurns; //set if AI players whose heroes can't meet make turns at the same time
+
+	/// If set, called with every pack once it was applied to game state - lets in-process players (e.g. battle simulator) follow the game
+	std::function<void(CPackForClient *)> packObserver;
+
+	/// State of a battle shared between thread running it and threads handling actions of its players
+	struct OngoingBattle
+	{
+		CondSh<bool> madeAction; //set when active stack has acted
+		CondSh<BattleResult *> result; //set once battle is decided
+
+		OngoingBattle();
+		~OngoingBattle();
+	};
+
+	//battles stuff, several battles may be fought at once - each in its own thread
+	boost::mutex battlesMx; //guards ongoingBattles, finishingBattles and nextBattleID
+	boost::recursive_mutex applyMx; //packs from different battles are applied to game state one by one; recursive, as battle simulator AIs make actions while holding it
+	std::map<BattleID, std::shared_ptr<OngoingBattle>> ongoingBattles;
+	BattleID nextBattleID;
+
 	bool isValidObject(const CGObjectInstance *obj) const;
 	bool isBlockedByQueries(const CPack *pack, PlayerColor player);
 	bool isAllowedExchange(ObjectInstanceID id1, ObjectInstanceID id2);
 	void giveSpells(const CGTownInstance *t, const CGHeroInstance *h);
-	int moveStack(int stack, BattleHex dest); //returned value - travelled distance
-	void runBattle();
+	int moveStack(BattleInfo * battle, int stack, BattleHex dest); //returned value - travelled distance
+	void runBattle(BattleID battleID);
+	void fightBattle(BattleInfo * battle); //runs battle until its result is set, without applying it to adventure map
+	std::shared_ptr<OngoingBattle> getOngoingBattle(BattleID battleID); //nullptr if battle is already over
 
 	////used only in endBattle - don't touch elsewhere
 	bool visitObjectAfterVictory;
 	//
-	void endBattle(int3 tile, const CGHeroInstance *hero1, const CGHeroInstance *hero2); //ends battle
-	void prepareAttack(BattleAttack &bat, const CStack *att, const CStack *def, int distance, int targetHex); //distance - number of hexes travelled before attacking
-	void applyBattleEffects(BattleAttack &bat, const CStack *att, const CStack *def, int distance, bool secondary); //damage, drain life & fire shield
-	void checkBattleStateChanges();
-	void setupBattle(int3 tile, const CArmedInstance *armies[2], const CGHeroInstance *heroes[2], bool creatureBank, const CGTownInstance *town);
-	void setBattleResult(BattleResult::EResult resultType, int victoriusSide);
+	void endBattle(BattleInfo * battle, int3 tile, const CGHeroInstance *hero1, const CGHeroInstance *hero2); //ends battle
+	void prepareAttack(BattleInfo * battle, BattleAttack &bat, const CStack *att, const CStack *def, int distance, int targetHex); //distance - number of hexes travelled before attacking
+	void applyBattleEffects(BattleInfo * battle, BattleAttack &bat, const CStack *att, const CStack *def, int distance, bool secondary); //damage, drain life & fire shield
+	void checkBattleStateChanges(BattleInfo * battle);
+	BattleID setupBattle(int3 tile, const CArmedInstance *armies[2], const CGHeroInstance *heroes[2], bool creatureBank, const CGTownInstance *town);
+	BattleID registerBattle(BattleInfo * battle); //gives battle its ID and informs player interfaces
+	void setBattleResult(BattleInfo * battle, BattleResult::EResult resultType, int victoriusSide);
 
 	CGameHandler(void);
 	~CGameHandler(void);
@@ -174,6 +204,8 @@ public:
 	void setPortalDwelling(const CGTownInstance * town, bool forced, bool clear);
 	void visitObjectOnTile(const TerrainTile &t, const CGHeroInstance * h);
 	bool teleportHero(ObjectInstanceID hid, ObjectInstanceID dstid, ui8 source, PlayerColor asker = PlayerColor::NEUTRAL);
+	/// moves hero step by step until path ends, hero stops on his own (battle, dialog, blocking visit, teleport) or meets new guard
+	bool moveHeroAlongPath(ObjectInstanceID hid, const std::vector<HeroPathStep> & steps, bool stopOnNewGuard, PlayerColor asker);
 	void vistiCastleObjects (const CGTownInstance *t, const CGHeroInstance *h);
 	void levelUpHero(const CGHeroInstance * hero, SecondarySkill skill);//handle client respond and send one more request if needed
 	void levelUpHero(const CGHeroInstance * hero);//initial call - check if hero have remaining levelups & handle them
@@ -187,18 +219,23 @@ public:
 
 	void init(StartInfo *si);
 	void handleConnection(std::set<PlayerColor> players, CConnection &c);
-	PlayerColor getPlayerAt(CConnection *c) const;
+	/// Applies request received from client and confirms it, takes ownership of pack
+	void applyRequest(CConnection &c, CPack *pack, PlayerColor player, si32 requestID, int packType);
+	PlayerColor getPlayerAt(CConnection *c);
+	/// Returns requested player if it is handled by given connection and may act now - several players of one connection may make turn at once
+	PlayerColor getPlayerAt(CConnection *c, PlayerColor requested);
+	bool isPlayerMakingTurn(PlayerColor player);
 
 	void playerMessage(PlayerColor player, const std::string &message, ObjectInstanceID currObj);
-	void updateGateState();
-	bool makeBattleAction(BattleAction &ba);
-	bool makeAutomaticAction(const CStack *stack, BattleAction &ba); //used when action is taken by stack without volition of player (eg. unguided catapult attack)
-	bool makeCustomAction(BattleAction &ba);
-	void stackEnchantedTrigger(const CStack * stack);
-	void stackTurnTrigger(const CStack *stack);
-	bool handleDamageFromObstacle(const CStack * curStack, bool stackIsMoving = false); //checks if obstacle is land mine and handles possible consequences
-
-	void removeObstacle(const CObstacleInstance &obstacle);
+	void updateGateState(BattleInfo * battle);
+	bool makeBattleAction(BattleInfo * battle, BattleAction &ba);
+	bool makeAutomaticAction(BattleInfo * battle, const CStack *stack, BattleAction &ba); //used when action is taken by stack without volition of player (eg. unguided catapult attack)
+	bool makeCustomAction(BattleInfo * battle, BattleAction &ba);
+	void stackEnchantedTrigger(BattleInfo * battle, const CStack * stack);
+	void stackTurnTrigger(BattleInfo * battle, const CStack *stack);
+	bool handleDamageFromObstacle(BattleInfo * battle, const CStack * curStack, bool stackIsMoving = false); //checks if obstacle is land mine and handles possible consequences
+
+	void removeObstacle(BattleInfo * battle, const CObstacleInstance &obstacle);
 	bool queryReply( QueryID qid, const JsonNode & answer, PlayerColor player );
 	bool hireHero( const CGObjectInstance *obj, ui8 hid, PlayerColor player );
 	bool buildBoat( ObjectInstanceID objid );
@@ -222,6 +259,7 @@ public:
 	bool disbandCreature( ObjectInstanceID id, SlotID pos );
 	bool arrangeStacks( ObjectInstanceID id1, ObjectInstanceID id2, ui8 what, SlotID p1, SlotID p2, si32 val, PlayerColor player);
 	void save(const std::string &fname);
+	void recordPacks(const boost::filesystem::path & fname); //all packs are written to given file from now on, see CPackLogWriter
 	void close();
 	void playerLeftGame(int cid);
 	void handleTimeEvents();
@@ -237,7 +275,16 @@ public:
 	{
 		h & QID;
 		h & states;
-		h & finishingBattle;
+		if(version >= 780)
+		{
+			h & finishingBattles;
+			h & nextBattleID;
+		}
+		else
+		{
+			std::unique_ptr<FinishingBattleHelper> finishingBattle;
+			h & finishingBattle;
+		}
 		if(version >= 761)
 		{
 			h & getRandomGenerator();
@@ -278,25 +325,27 @@ public:
 		}
 	};
 
-	std::unique_ptr<FinishingBattleHelper> finishingBattle;
+	std::map<BattleID, std::unique_ptr<FinishingBattleHelper>> finishingBattles; //battles waiting for their queries to be closed
 
 	void battleAfterLevelUp(const BattleResult &result);
 
 	void run(bool resume);
 	void newTurn();
-	void handleAttackBeforeCasting(BattleAttack *bat);
-	void handleAfterAttackCasting (const BattleAttack & bat);
-	void attackCasting(const BattleAttack & bat, Bonus::BonusType attackMode, const CStack * attacker);
+	void handleAttackBeforeCasting(BattleInfo * battle, BattleAttack *bat);
+	void handleAfterAttackCasting(BattleInfo * battle, const BattleAttack & bat);
+	void attackCasting(BattleInfo * battle, const BattleAttack & bat, Bonus::BonusType attackMode, const CStack * attacker);
 	bool sacrificeArtifact(const IMarket * m, const CGHeroInstance * hero, const std::vector<ArtifactPosition> & slot);
 	void spawnWanderingMonsters(CreatureID creatureID);
 	void handleCheatCode(std::string & cheat, PlayerColor player, const CGHeroInstance * hero, const CGTownInstance * town, bool & cheated);
 	friend class CVCMIServer;
+	friend class CBattleSimulator;
 
 	CRandomGenerator & getRandomGenerator();
 
 private:
 	std::list<PlayerColor> generatePlayerTurnOrder() const;
-	void makeStackDoNothing(const CStack * next);
+	void runSimultaneousTurns(const std::vector<PlayerColor> & group);
+	void makeStackDoNothing(BattleInfo * battle, const CStack * next);
 	void getVictoryLossMessage(PlayerColor player, const EVictoryLossCheckResult & victoryLossCheckResult, InfoWindow & out) const;
 
 	// Check for victory and loss conditions
@@ -0,0 +1,229 @@
+/*
+ * CPackLog.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CPackLog.h"
+
+#include "../lib/IGameCallback.h"
+#include "../lib/CGameState.h"
+#include "../lib/NetPacks.h"
+#include "../lib/serializer/BinaryDeserializer.h"
+
+static const std::string PACK_LOG_MAGIC = "VCMIPACKLOG";
+
+CPackLogWriter::CPackLogWriter(const boost::filesystem::path & fname, CPrivilagedInfoCallback & cb)
+	: file(fname), packs(0), failed(false)
+{
+	auto start = boost::posix_time::microsec_clock::universal_time();
+	file.putMagicBytes(PACK_LOG_MAGIC);
+	cb.saveCommonState(file);
+
+	// from now on packs are written exactly as they are sent to clients
+	file.addStdVecItems(cb.gameState());
+	file.sendStackInstanceByIds = true;
+	file.serializer.smartPointerSerialization = false;
+	file.flush();
+
+	auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+	logGlobal->info("Recording packs to %s, initial game state written in %d ms", fname.string(), duration.total_milliseconds());
+}
+
+CPackLogWriter::~CPackLogWriter()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(failed)
+		return;
+
+	try
+	{
+		ui8 record = EPackLogRecord::END;
+		file << record;
+		file.close(true);
+		logGlobal->info("Pack log %s closed, %d packs recorded", file.fName.string(), packs);
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error("Failed to finish pack log %s: %s", file.fName.string(), e.what());
+	}
+}
+
+void CPackLogWriter::packApplied(CPackForClient * pack)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(failed)
+		return;
+
+	try
+	{
+		ui8 record = EPackLogRecord::APPLIED;
+		file << record << pack;
+		packs++;
+	}
+	catch(std::exception & e)
+	{
+		stopRecording(e);
+	}
+}
+
+void CPackLogWriter::packReceived(CPack * pack, PlayerColor player, si32 requestID)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(failed)
+		return;
+
+	try
+	{
+		ui8 record = EPackLogRecord::RECEIVED;
+		file << record << player << requestID << pack;
+		packs++;
+	}
+	catch(std::exception & e)
+	{
+		stopRecording(e);
+	}
+}
+
+void CPackLogWriter::newTurn()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(failed)
+		return;
+
+	try
+	{
+		ui8 record = EPackLogRecord::NEW_TURN;
+		file << record;
+		file.flush();
+	}
+	catch(std::exception & e)
+	{
+		stopRecording(e);
+	}
+}
+
+void CPackLogWriter::stopRecording(const std::exception & e)
+{
+	// game goes on, but log is useless once any pack is missing
+	logGlobal->error("Failed to write pack log %s, recording stopped: %s", file.fName.string(), e.what());
+	failed = true;
+}
+
+CPackLogReplay::PackStats::PackStats()
+	: count(0), time(0)
+{
+}
+
+CPackLogReplay::CPackLogReplay(const boost::filesystem::path & fname)
+	: fname(fname), applied(0), received(0), turns(0), applyTime(0)
+{
+}
+
+bool CPackLogReplay::run(CPrivilagedInfoCallback & state)
+{
+	std::unique_ptr<CLoadFile> lf;
+	try
+	{
+		auto start = boost::posix_time::microsec_clock::universal_time();
+		lf = make_unique<CLoadFile>(fname);
+		lf->checkMagicBytes(PACK_LOG_MAGIC);
+		state.loadCommonState(*lf);
+		auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+		logGlobal->info("Initial game state of %s loaded in %d ms", fname.string(), duration.total_milliseconds());
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error("Failed to load pack log %s: %s", fname.string(), e.what());
+		return false;
+	}
+
+	CGameState * gs = state.gameState();
+	lf->addStdVecItems(gs);
+	lf->sendStackInstanceByIds = true;
+	lf->serializer.smartPointerSerialization = false;
+
+	bool complete = false;
+	auto start = boost::posix_time::microsec_clock::universal_time();
+	try
+	{
+		while(!complete)
+		{
+			ui8 record;
+			*lf >> record;
+			switch(record)
+			{
+			case EPackLogRecord::END:
+				complete = true;
+				break;
+			case EPackLogRecord::APPLIED:
+				{
+					CPackForClient * pack = nullptr;
+					*lf >> pack;
+					if(!pack)
+						throw std::runtime_error("null pack in log");
+					std::unique_ptr<CPackForClient> guard(pack);
+
+					auto applyStart = boost::posix_time::microsec_clock::universal_time();
+					gs->apply(pack);
+					auto duration = (boost::posix_time::microsec_clock::universal_time() - applyStart).total_microseconds();
+
+					auto & typeStats = stats[typeid(*pack).name()];
+					typeStats.count++;
+					typeStats.time += duration;
+					applyTime += duration;
+					applied++;
+				}
+				break;
+			case EPackLogRecord::RECEIVED:
+				{
+					// requests are only validated by game handler, their results are already in the log
+					CPack * pack = nullptr;
+					PlayerColor player;
+					si32 requestID;
+					*lf >> player >> requestID >> pack;
+					delete pack;
+					received++;
+				}
+				break;
+			case EPackLogRecord::NEW_TURN:
+				turns++;
+				break;
+			default:
+				throw std::runtime_error(boost::str(boost::format("unknown record type %d") % static_cast<int>(record)));
+			}
+		}
+	}
+	catch(std::exception & e)
+	{
+		// log of crashed server ends with partially flushed data
+		logGlobal->warn("Replay of %s stopped after %d applied packs: %s", fname.string(), applied, e.what());
+	}
+
+	auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+	report(duration.total_milliseconds());
+	return complete;
+}
+
+void CPackLogReplay::report(si64 totalTime) const
+{
+	logGlobal->info("Replayed %d packs and %d client requests over %d turns in %d ms", applied, received, turns, totalTime);
+	logGlobal->info("%d ms spent in applying packs to game state, %d packs/s", applyTime / 1000, applyTime ? applied * 1000000 / applyTime : 0);
+
+	std::vector<std::pair<std::string, PackStats>> sorted(stats.begin(), stats.end());
+	boost::sort(sorted, [](const std::pair<std::string, PackStats> & a, const std::pair<std::string, PackStats> & b)
+	{
+		return a.second.time > b.second.time;
+	});
+
+	logGlobal->info("Most expensive pack types:");
+	for(size_t i = 0; i < sorted.size() && i < 10; i++)
+	{
+		const PackStats & typeStats = sorted[i].second;
+		logGlobal->info("\t%s: %d packs, %d ms total, %d us on average", sorted[i].first, typeStats.count, typeStats.time / 1000, typeStats.time / typeStats.count);
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ * CPackLog.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "../lib/serializer/BinarySerializer.h"
+
+class CPrivilagedInfoCallback;
+struct CPack;
+struct CPackForClient;
+
+/**
+ * Compressed log of all packs passing through the server, used to reproduce games without clients.
+ *
+ * Log starts with game state as it was when recording started, same as in savegame, followed
+ * by records of packs: every pack applied to game state and every request received from clients
+ * together with its player and request ID. Packs are stored the same way they are sent over
+ * network, so objects are referenced by their IDs. Log is flushed on every new turn - if server
+ * crashes, log can still be replayed up to the beginning of the last turn.
+ */
+namespace EPackLogRecord
+{
+	enum EPackLogRecord : ui8
+	{
+		END, //log has been properly closed
+		APPLIED, //pack applied to game state
+		RECEIVED, //request received from client
+		NEW_TURN //marker written on flush, for statistics only
+	};
+}
+
+class CPackLogWriter : public boost::noncopyable
+{
+public:
+	CPackLogWriter(const boost::filesystem::path & fname, CPrivilagedInfoCallback & cb); //throws! writes current game state of cb
+	~CPackLogWriter(); //writes end marker
+
+	/// Must be called with game state locked, right before pack is applied
+	void packApplied(CPackForClient * pack);
+	void packReceived(CPack * pack, PlayerColor player, si32 requestID);
+
+	/// Makes everything written so far readable even if server crashes later
+	void newTurn();
+
+private:
+	boost::mutex mx;
+	CSaveFile file;
+	ui64 packs;
+	bool failed; //set after write error, nothing more is recorded
+
+	void stopRecording(const std::exception & e);
+};
+
+/// Applies packs from log to fresh game state as fast as possible, without game handler logic, clients or AI
+class CPackLogReplay
+{
+public:
+	CPackLogReplay(const boost::filesystem::path & fname);
+
+	/// Loads game state from log into state and replays whole log on it, reports time spent in applying packs
+	/// Returns false if log ended prematurely or apply failed, state keeps whatever was replayed
+	bool run(CPrivilagedInfoCallback & state);
+
+private:
+	struct PackStats
+	{
+		ui64 count;
+		si64 time; //total time spent in applying packs of this type, in microseconds
+
+		PackStats();
+	};
+
+	boost::filesystem::path fname;
+	std::map<std::string, PackStats> stats; //pack type => statistics
+	ui64 applied, received, turns;
+	si64 applyTime; //in microseconds
+
+	void report(si64 totalTime) const;
+};
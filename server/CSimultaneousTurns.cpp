@@ -0,0 +1,240 @@
+/*
+ * CSimultaneousTurns.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CSimultaneousTurns.h"
+
+#include "CGameHandler.h"
+#include "../lib/CGameState.h"
+#include "../lib/CPathfinder.h"
+#include "../lib/CPlayerState.h"
+#include "../lib/NetPacks.h"
+#include "../lib/mapObjects/CArmedInstance.h"
+#include "../lib/mapObjects/CGHeroInstance.h"
+#include "../lib/mapObjects/CGTownInstance.h"
+
+CSimultaneousTurns::CSimultaneousTurns(CGameHandler & gh)
+	: gh(gh)
+{
+}
+
+CSimultaneousTurns::~CSimultaneousTurns()
+{
+	endGroup();
+}
+
+std::vector<PlayerColor> CSimultaneousTurns::startGroup(const std::vector<PlayerColor> & candidates)
+{
+	auto start = boost::posix_time::microsec_clock::universal_time();
+
+	std::unordered_map<int3, PlayerColor, ShashInt3> groupZones;
+	std::vector<PlayerColor> group;
+	for(auto player : candidates)
+	{
+		auto zone = getZone(player);
+		if(vstd::contains_if(zone, [&](const int3 & tile){ return groupZones.count(tile) > 0; }))
+			break;
+
+		for(auto & tile : zone)
+			groupZones[tile] = player;
+		group.push_back(player);
+	}
+
+	auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+	logGlobal->debug("%d of %d AI players can make turn at once, zones computed in %d ms", group.size(), candidates.size(), duration.total_milliseconds());
+
+	if(group.size() > 1)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		zones = std::move(groupZones);
+		members.insert(group.begin(), group.end());
+	}
+	return group;
+}
+
+void CSimultaneousTurns::endGroup()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	for(auto & playerRequests : held) //players which were never released, e.g. because server is shutting down
+	{
+		for(; !playerRequests.second.empty(); playerRequests.second.pop())
+			vstd::clear_pointer(playerRequests.second.front().pack);
+	}
+	held.clear();
+	members.clear();
+	zones.clear();
+}
+
+bool CSimultaneousTurns::holdRequest(CConnection & c, CPack * pack, PlayerColor player, si32 requestID, int packType)
+{
+	if(!pack || !gh.isPlayerMakingTurn(player))
+		return false;
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(!vstd::contains(members, player))
+		return false;
+
+	if(!vstd::contains(held, player))
+	{
+		if(staysInZone(pack, player))
+			return false;
+		logGlobal->debug("Player %s reaches out of its zone with %s, it will continue after other players of group", player.getStr(), typeid(*pack).name());
+	}
+
+	HeldRequest request;
+	request.c = &c;
+	request.pack = pack;
+	request.requestID = requestID;
+	request.packType = packType;
+	held[player].push(request);
+	gh.states.cv.notify_all();
+	return true;
+}
+
+bool CSimultaneousTurns::isHeld(PlayerColor player)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	return vstd::contains(held, player);
+}
+
+void CSimultaneousTurns::release(PlayerColor player)
+{
+	logGlobal->debug("Player %s continues turn after other players of group", player.getStr());
+	while(true)
+	{
+		HeldRequest request;
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			auto & requests = held[player];
+			if(requests.empty())
+			{
+				held.erase(player);
+				members.erase(player);
+				return;
+			}
+			request = requests.front();
+			requests.pop();
+		}
+		gh.applyRequest(*request.c, request.pack, player, request.requestID, request.packType);
+	}
+}
+
+std::unordered_set<int3, ShashInt3> CSimultaneousTurns::getZone(PlayerColor player) const
+{
+	std::unordered_set<int3, ShashInt3> zone;
+	auto addWithNeighbours = [&](const int3 & tile)
+	{
+		for(int dx = -1; dx <= 1; dx++)
+		{
+			for(int dy = -1; dy <= 1; dy++)
+			{
+				const int3 pos = tile + int3(dx, dy, 0);
+				if(gh.isInTheMap(pos))
+					zone.insert(pos);
+			}
+		}
+	};
+
+	const PlayerState * state = gh.getPlayer(player);
+	const int3 sizes = gh.getMapSize();
+	CPathsInfo paths(sizes);
+	for(const CGHeroInstance * hero : state->heroes)
+	{
+		addWithNeighbours(hero->visitablePos());
+		gh.gameState()->calculatePaths(hero, paths); //includes teleports known to player
+
+		int3 tile;
+		for(tile.z = 0; tile.z < sizes.z; tile.z++)
+		{
+			for(tile.x = 0; tile.x < sizes.x; tile.x++)
+			{
+				for(tile.y = 0; tile.y < sizes.y; tile.y++)
+				{
+					for(EPathfindingLayer layer = EPathfindingLayer::LAND; layer <= EPathfindingLayer::AIR; layer.advance(1))
+					{
+						const CGPathNode * node = paths.getNode(tile, layer);
+						if(node->reachable() && node->turns == 0)
+						{
+							addWithNeighbours(tile);
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for(const CGTownInstance * town : state->towns) //heroes hired in town appear there
+		addWithNeighbours(town->visitablePos());
+
+	return zone;
+}
+
+bool CSimultaneousTurns::staysInZone(const CPack * pack, PlayerColor player) const
+{
+	auto inZone = [&](const int3 & tile)
+	{
+		auto iter = zones.find(tile);
+		return iter != zones.end() && iter->second == player && !mayStartBattle(tile, player);
+	};
+
+	if(auto move = dynamic_cast<const MoveHero *>(pack))
+		return inZone(CGHeroInstance::convertPosition(move->dest, false));
+
+	if(auto move = dynamic_cast<const MoveHeroPath *>(pack))
+	{
+		for(auto & step : move->steps)
+		{
+			if(!inZone(CGHeroInstance::convertPosition(step.dest, false)))
+				return false;
+		}
+		return true;
+	}
+
+	if(auto teleport = dynamic_cast<const CastleTeleportHero *>(pack))
+	{
+		const CGObjectInstance * town = gh.getObj(teleport->dest, false);
+		return town && inZone(town->visitablePos());
+	}
+
+	if(auto hire = dynamic_cast<const HireHero *>(pack))
+	{
+		const CGObjectInstance * town = gh.getObj(hire->tid, false);
+		return town && inZone(town->visitablePos());
+	}
+
+	if(auto arrange = dynamic_cast<const ArrangeStacks *>(pack)) //garrison may belong to ally
+		return gh.getOwner(arrange->id1) == player && gh.getOwner(arrange->id2) == player;
+
+	if(auto exchange = dynamic_cast<const ExchangeArtifacts *>(pack))
+		return exchange->src.owningPlayer() == player && exchange->dst.owningPlayer() == player;
+
+	if(dynamic_cast<const CastAdvSpell *>(pack)) //town portal, dimension door or fly may take hero anywhere
+		return false;
+
+	return true;
+}
+
+bool CSimultaneousTurns::mayStartBattle(const int3 & tile, PlayerColor player) const
+{
+	if(gh.guardingCreaturePosition(tile).valid())
+		return true;
+
+	const TerrainTile * t = gh.getTile(tile, false);
+	if(!t)
+		return false;
+
+	//monsters, banks, guarded dwellings and mines, pandora boxes... all of them keep their army in armed instance
+	for(const CGObjectInstance * obj : t->visitableObjects)
+	{
+		if(obj->tempOwner != player && dynamic_cast<const CArmedInstance *>(obj))
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,67 @@
+/*
+ * CSimultaneousTurns.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "../lib/GameConstants.h"
+#include "../lib/int3.h"
+
+class CGameHandler;
+class CConnection;
+struct CPack;
+
+/**
+ * Lets AI players whose heroes can't meet during this turn make their turns at the same time.
+ *
+ * Zone of player consists of tiles which heroes of that player can reach in this turn, their
+ * neighbours and towns of that player. Consecutive AI players in turn order form a group as long
+ * as their zones don't overlap. Requests which stay in zone of their player are applied at once.
+ * First request reaching outside of zone (or casting adventure spell) is held together with all
+ * following requests of that player. Held players continue one by one in turn order once all
+ * other players of group ended turn, so any contact between players happens sequentially.
+ * Moves which may start a battle are held as well, even inside zone: neutral player would otherwise
+ * fight several battles at once.
+ */
+class CSimultaneousTurns : public boost::noncopyable
+{
+public:
+	CSimultaneousTurns(CGameHandler & gh);
+	~CSimultaneousTurns();
+
+	/// Returns longest prefix of candidates (AI players in turn order) with non-overlapping zones and starts group of these players
+	std::vector<PlayerColor> startGroup(const std::vector<PlayerColor> & candidates);
+	/// Forgets current group, all its players must have ended turn
+	void endGroup();
+
+	/// Returns true if request was taken, it will be applied once player is released
+	bool holdRequest(CConnection & c, CPack * pack, PlayerColor player, si32 requestID, int packType);
+	bool isHeld(PlayerColor player);
+	/// Applies held requests of player, following requests of that player are applied normally
+	void release(PlayerColor player);
+
+private:
+	struct HeldRequest
+	{
+		CConnection * c;
+		CPack * pack;
+		si32 requestID;
+		int packType;
+	};
+
+	CGameHandler & gh;
+
+	boost::mutex mx; //guards everything below
+	std::unordered_map<int3, PlayerColor, ShashInt3> zones; //tile => player whose zone contains it
+	std::set<PlayerColor> members; //players of current group which were not released
+	std::map<PlayerColor, std::queue<HeldRequest>> held; //requests of players which reached out of their zones, in order of arrival
+
+	std::unordered_set<int3, ShashInt3> getZone(PlayerColor player) const;
+	bool staysInZone(const CPack * pack, PlayerColor player) const;
+	bool mayStartBattle(const int3 & tile, PlayerColor player) const; //hero entering tile may have to fight
+};
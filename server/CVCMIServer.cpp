@@ -36,6 +36,7 @@
 #include "../lib/VCMI_Lib.h"
 #include "../lib/VCMIDirs.h"
 #include "CGameHandler.h"
+#include "CPackLog.h"
 #include "../lib/mapping/CMapInfo.h"
 #include "../lib/GameConstants.h"
 #include "../lib/logging/CBasicLogConfigurator.h"
@@ -379,6 +380,12 @@ std::shared_ptr<CGameHandler> CVCMIServer::initGhFromHostingConnection(CConnecti
 	return gh;
 }
 
+static void startRecordingIfRequested(CGameHandler & gh)
+{
+	if(cmdLineOptions.count("record"))
+		gh.recordPacks(cmdLineOptions["record"].as<std::string>());
+}
+
 void CVCMIServer::newGame()
 {
 	CConnection &c = *firstConnection;
@@ -389,7 +396,10 @@ void CVCMIServer::newGame()
 	auto gh = initGhFromHostingConnection(c);
 
 	if(gh)
+	{
+		startRecordingIfRequested(*gh);
 		gh->run(false);
+	}
 }
 
 void CVCMIServer::newPregame()
@@ -411,6 +421,7 @@ void CVCMIServer::newPregame()
 		for(CConnection *c : gh.conns)
 			c->addStdVecItems(gh.gs);
 
+		startRecordingIfRequested(gh);
 		gh.run(false);
 	}
 }
@@ -526,6 +537,7 @@ void CVCMIServer::loadGame()
 		gh.conns.insert(new CConnection(s.release(),NAME));
 	}
 
+	startRecordingIfRequested(gh);
 	gh.run(true);
 }
 
@@ -542,7 +554,9 @@ static void handleCommandOptions(int argc, char *argv[])
 		("uuid", po::value<std::string>(), "")
 		("enable-shm-uuid", "use UUID for shared memory identifier")
 		("enable-shm", "enable usage of shared memory")
-		("port", po::value<ui16>(), "port at which server will listen to connections from client");
+		("port", po::value<ui16>(), "port at which server will listen to connections from client")
+		("record", po::value<std::string>(), "write all packs of the game to given file")
+		("replay", po::value<std::string>(), "apply packs recorded with --record to game state as fast as possible and exit");
 
 	if(argc > 1)
 	{
@@ -628,6 +642,20 @@ int main(int argc, char * argv[])
 
 	loadDLLClasses();
 	srand ( (ui32)time(nullptr) );
+
+	if(cmdLineOptions.count("replay"))
+	{
+		CPackLogReplay replay(cmdLineOptions["replay"].as<std::string>());
+		bool success;
+		{
+			CGameHandler gh; //owns replayed game state, map objects use it as their callback
+			success = replay.run(gh);
+		}
+		vstd::clear_pointer(VLC);
+		CResourceHandler::clear();
+		return success ? 0 : 1;
+	}
+
 	try
 	{
 		boost::asio::io_service io_service;
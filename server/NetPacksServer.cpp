@@ -22,7 +22,8 @@
 #include "../lib/spells/ISpellMechanics.h"
 
 
-#define PLAYER_OWNS(id) (gh->getPlayerAt(c)==gh->getOwner(id))
+#define ACTING_PLAYER (gh->getPlayerAt(c, CPackForServer::player))
+#define PLAYER_OWNS(id) (ACTING_PLAYER==gh->getOwner(id))
 #define ERROR_AND_RETURN												\
 	do { if(c) {														\
 			SystemMessage temp_message("You are not allowed to perform this action!"); \
@@ -33,12 +34,12 @@
 		return false;} while(0)
 
 #define WRONG_PLAYER_MSG(expectedplayer) do {std::ostringstream oss;\
-			oss << "You were identified as player " << gh->getPlayerAt(c) << " while expecting " << expectedplayer;\
+			oss << "You were identified as player " << ACTING_PLAYER << " while expecting " << expectedplayer;\
 			logNetwork->error(oss.str()); \
 			if(c) { SystemMessage temp_message(oss.str()); boost::unique_lock<boost::mutex> lock(*c->wmx); *c << &temp_message; } } while(0)
 
 #define ERROR_IF_NOT_OWNS(id)	do{if(!PLAYER_OWNS(id)){WRONG_PLAYER_MSG(gh->getOwner(id)); ERROR_AND_RETURN; }}while(0)
-#define ERROR_IF_NOT(player)	do{if(player != gh->getPlayerAt(c)){WRONG_PLAYER_MSG(player); ERROR_AND_RETURN; }}while(0)
+#define ERROR_IF_NOT(player)	do{if(player != ACTING_PLAYER){WRONG_PLAYER_MSG(player); ERROR_AND_RETURN; }}while(0)
 #define COMPLAIN_AND_RETURN(txt)	{ gh->complain(txt); ERROR_AND_RETURN; }
 
 
@@ -74,12 +75,13 @@ bool LeaveGame::applyGh( CGameHandler *gh )
 
 bool EndTurn::applyGh( CGameHandler *gh )
 {
-	PlayerColor player = GS(gh)->currentPlayer;
-	ERROR_IF_NOT(player);
+	PlayerColor player = ACTING_PLAYER;
+	if(!gh->isPlayerMakingTurn(player))
+		ERROR_AND_RETURN;
 	if(gh->queries.topQuery(player))
 		COMPLAIN_AND_RETURN("Cannot end turn before resolving queries!");
 
-	gh->states.setFlag(GS(gh)->currentPlayer,&PlayerStatus::makingTurn,false);
+	gh->states.setFlag(player,&PlayerStatus::makingTurn,false);
 	return true;
 }
 
@@ -92,20 +94,26 @@ bool DismissHero::applyGh( CGameHandler *gh )
 bool MoveHero::applyGh( CGameHandler *gh )
 {
 	ERROR_IF_NOT_OWNS(hid);
-	return gh->moveHero(hid,dest,0,transit,gh->getPlayerAt(c));
+	return gh->moveHero(hid,dest,0,transit,ACTING_PLAYER);
+}
+
+bool MoveHeroPath::applyGh( CGameHandler *gh )
+{
+	ERROR_IF_NOT_OWNS(hid);
+	return gh->moveHeroAlongPath(hid, steps, stopOnNewGuard, ACTING_PLAYER);
 }
 
 bool CastleTeleportHero::applyGh( CGameHandler *gh )
 {
 	ERROR_IF_NOT_OWNS(hid);
 
-	return gh->teleportHero(hid,dest,source,gh->getPlayerAt(c));
+	return gh->teleportHero(hid,dest,source,ACTING_PLAYER);
 }
 
 bool ArrangeStacks::applyGh( CGameHandler *gh )
 {
 	//checks for owning in the gh func
-	return gh->arrangeStacks(id1,id2,what,p1,p2,val,gh->getPlayerAt(c));
+	return gh->arrangeStacks(id1,id2,what,p1,p2,val,ACTING_PLAYER);
 }
 
 bool DisbandCreature::applyGh( CGameHandler *gh )
@@ -238,7 +246,7 @@ bool HireHero::applyGh( CGameHandler *gh )
 {
 	const CGObjectInstance *obj = gh->getObj(tid);
 	const CGTownInstance *town = dynamic_ptr_cast<CGTownInstance>(obj);
-	if(town && PlayerRelations::ENEMIES == gh->getPlayerRelations(obj->tempOwner, gh->getPlayerAt(c)))
+	if(town && PlayerRelations::ENEMIES == gh->getPlayerRelations(obj->tempOwner, ACTING_PLAYER))
 		COMPLAIN_AND_RETURN("Can't buy hero in enemy town!");
 
 	return gh->hireHero(obj, hid,player);
@@ -266,8 +274,8 @@ bool QueryReply::applyGh( CGameHandler *gh )
 
 bool MakeAction::applyGh( CGameHandler *gh )
 {
-	const BattleInfo *b = GS(gh)->curB;
-	if(!b) ERROR_AND_RETURN;
+	BattleInfo *b = GS(gh)->getBattle(battleID);
+	if(!b || !vstd::contains_if(b->sides, [&](const SideInBattle & side){ return side.color == player; })) ERROR_AND_RETURN;
 
 	if(b->tacticDistance)
 	{
@@ -280,19 +288,19 @@ bool MakeAction::applyGh( CGameHandler *gh )
 	else if(gh->connections[b->battleGetStackByID(b->activeStack)->owner] != c)
 		ERROR_AND_RETURN;
 
-	return gh->makeBattleAction(ba);
+	return gh->makeBattleAction(b, ba);
 }
 
 bool MakeCustomAction::applyGh( CGameHandler *gh )
 {
-	const BattleInfo *b = GS(gh)->curB;
-	if(!b) ERROR_AND_RETURN;
+	BattleInfo *b = GS(gh)->getBattle(battleID);
+	if(!b || !vstd::contains_if(b->sides, [&](const SideInBattle & side){ return side.color == player; })) ERROR_AND_RETURN;
 	if(b->tacticDistance) ERROR_AND_RETURN;
-	const CStack *active = GS(gh)->curB->battleGetStackByID(GS(gh)->curB->activeStack);
+	const CStack *active = b->battleGetStackByID(b->activeStack);
 	if(!active) ERROR_AND_RETURN;
 	if(gh->connections[active->owner] != c) ERROR_AND_RETURN;
 	if(ba.actionType != Battle::HERO_SPELL) ERROR_AND_RETURN;
-	return gh->makeCustomAction(ba);
+	return gh->makeCustomAction(b, ba);
 }
 
 bool DigWithHero::applyGh( CGameHandler *gh )
@@ -324,7 +332,7 @@ bool PlayerMessage::applyGh( CGameHandler *gh )
 	if(!player.isSpectator()) // TODO: clearly not a great way to verify permissions
 	{
 		ERROR_IF_NOT(player);
-		if(gh->getPlayerAt(c) != player) ERROR_AND_RETURN;
+		if(ACTING_PLAYER != player) ERROR_AND_RETURN;
 	}
 	gh->playerMessage(player,text, currObj);
 	return true;
@@ -0,0 +1,217 @@
+/*
+ * CBattleInfoCallbackTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../../lib/battle/BattleInfo.h"
+#include "../../lib/battle/CObstacleInstance.h"
+
+static ReachabilityInfo::Parameters makeParameters(BattleHex startPosition, bool doubleWide, ui8 side)
+{
+	ReachabilityInfo::Parameters params;
+	params.startPosition = startPosition;
+	params.doubleWide = doubleWide;
+	params.side = side;
+	params.knownAccessible.push_back(startPosition);
+	return params;
+}
+
+/// Battle giving access to obstacle lookup, so that reachability can be calculated the old way
+class ReferenceBattle : public BattleInfo
+{
+public:
+	using CBattleInfoCallback::getStoppers;
+
+	void addQuicksand(BattleHex hex, ui8 casterSide)
+	{
+		auto quicksand = std::make_shared<SpellCreatedObstacle>();
+		quicksand->obstacleType = CObstacleInstance::QUICKSAND;
+		quicksand->pos = hex;
+		quicksand->casterSide = casterSide;
+		quicksand->visibleForAnotherSide = false;
+		quicksand->uniqueID = obstacles.size();
+		obstacles.push_back(quicksand);
+		revision++;
+	}
+};
+
+/// BFS as it was before neighbour table and bitsets, kept to check that the faster one finds the same paths
+static ReachabilityInfo makeReferenceBFS(const ReferenceBattle & battle, const ReachabilityInfo::Parameters & params)
+{
+	ReachabilityInfo ret;
+	ret.accessibility = battle.getAccesibility(params.knownAccessible);
+	ret.params = params;
+	ret.predecessors.fill(BattleHex::INVALID);
+	ret.distances.fill(ReachabilityInfo::INFINITE_DIST);
+
+	const std::set<BattleHex> quicksands = battle.getStoppers(params.perspective);
+
+	std::queue<BattleHex> hexq;
+	hexq.push(params.startPosition);
+	ret.distances[params.startPosition] = 0;
+
+	while(!hexq.empty())
+	{
+		const BattleHex curHex = hexq.front();
+		hexq.pop();
+
+		if(curHex != params.startPosition && vstd::contains(quicksands, curHex))
+			continue;
+
+		const int costToNeighbour = ret.distances[curHex] + 1;
+		for(BattleHex neighbour : curHex.neighbouringTiles())
+		{
+			const bool accessible = ret.accessibility.accessible(neighbour, params.doubleWide, params.side);
+			if(accessible && costToNeighbour < ret.distances[neighbour])
+			{
+				hexq.push(neighbour);
+				ret.distances[neighbour] = costToNeighbour;
+				ret.predecessors[neighbour] = curHex;
+			}
+		}
+	}
+	return ret;
+}
+
+TEST(CBattleInfoCallbackTest, getReachabilityEmptyField)
+{
+	BattleInfo battle;
+	const BattleHex start(1, 5);
+
+	auto reachability = battle.getReachability(makeParameters(start, false, BattleSide::ATTACKER));
+
+	EXPECT_EQ(reachability.distances[start], 0);
+	for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+	{
+		const BattleHex tile(hex);
+		if(!tile.isAvailable())
+		{
+			EXPECT_FALSE(reachability.isReachable(tile));
+			continue;
+		}
+
+		ASSERT_TRUE(reachability.isReachable(tile));
+		if(tile == start)
+			continue;
+
+		//every step of the path leads to neighbouring tile which is one step closer
+		const BattleHex predecessor = reachability.predecessors[tile];
+		EXPECT_NE(BattleHex::mutualPosition(predecessor, tile), BattleHex::INVALID);
+		EXPECT_EQ(reachability.distances[predecessor] + 1, reachability.distances[tile]);
+	}
+
+	EXPECT_EQ(reachability.distances[BattleHex(15, 5)], 14);
+}
+
+TEST(CBattleInfoCallbackTest, getReachabilityDoubleWide)
+{
+	BattleInfo battle;
+
+	auto attacker = battle.getReachability(makeParameters(BattleHex(2, 5), true, BattleSide::ATTACKER));
+	auto defender = battle.getReachability(makeParameters(BattleHex(14, 5), true, BattleSide::DEFENDER));
+
+	//back of two-hex creature can't stand in side column
+	for(si16 y = 0; y < GameConstants::BFIELD_HEIGHT; y++)
+	{
+		EXPECT_FALSE(attacker.isReachable(BattleHex(1, y)));
+		EXPECT_TRUE(attacker.isReachable(BattleHex(15, y)));
+		EXPECT_FALSE(defender.isReachable(BattleHex(15, y)));
+		EXPECT_TRUE(defender.isReachable(BattleHex(1, y)));
+	}
+}
+
+TEST(CBattleInfoCallbackTest, getReachabilityCachedUntilRevisionChanges)
+{
+	BattleInfo battle;
+	const auto params = makeParameters(BattleHex(1, 5), false, BattleSide::ATTACKER);
+	const BattleHex deck(7, 5);
+
+	EXPECT_TRUE(battle.getReachability(params).isReachable(deck));
+
+	//battlefield type never changes during battle, packs don't increase revision for it
+	battle.battlefieldType = BFieldType::SHIP_TO_SHIP;
+	EXPECT_TRUE(battle.getReachability(params).isReachable(deck));
+
+	battle.revision++;
+	EXPECT_FALSE(battle.getReachability(params).isReachable(deck));
+}
+
+TEST(CBattleInfoCallbackTest, getReachabilityCachedMatchesCalculated)
+{
+	BattleInfo battle;
+
+	for(int i = 0; i < 50; i++)
+	{
+		const auto params = makeParameters(BattleHex(1 + i % 15, i % 11), i % 2, i % 2);
+		battle.getReachability(params); //fills cache
+
+		BattleInfo fresh; //same battlefield, nothing cached
+		auto cached = battle.getReachability(params);
+		auto calculated = fresh.getReachability(params);
+
+		EXPECT_EQ(cached.distances, calculated.distances);
+		EXPECT_EQ(cached.predecessors, calculated.predecessors);
+	}
+}
+
+TEST(CBattleInfoCallbackTest, getReachabilityMatchesReferenceBFS)
+{
+	const BattlePerspective::BattlePerspective perspectives[] = {BattlePerspective::ALL_KNOWING, BattlePerspective::LEFT_SIDE, BattlePerspective::RIGHT_SIDE};
+
+	for(bool ship : {false, true})
+	{
+		for(bool quicksands : {false, true})
+		{
+			ReferenceBattle battle;
+			if(ship)
+				battle.battlefieldType = BFieldType::SHIP_TO_SHIP;
+			if(quicksands)
+			{
+				//quicksands of one side are hidden from the other one
+				for(auto hex : {BattleHex(5, 5), BattleHex(8, 2), BattleHex(8, 3), BattleHex(11, 8), BattleHex(14, 5)})
+					battle.addQuicksand(hex, BattleSide::ATTACKER);
+				battle.addQuicksand(BattleHex(4, 9), BattleSide::DEFENDER);
+			}
+
+			for(int i = 0; i < 30; i++)
+			{
+				//board edges, ship decks and hexes next to quicksands
+				auto params = makeParameters(BattleHex(1 + (i * 7) % 15, (i * 5) % 11), i % 2, (i / 2) % 2);
+				params.perspective = perspectives[i % 3];
+
+				auto expected = makeReferenceBFS(battle, params);
+				auto actual = battle.getReachability(params);
+
+				EXPECT_EQ(expected.distances, actual.distances) << "ship " << ship << ", quicksands " << quicksands << ", case " << i;
+				EXPECT_EQ(expected.predecessors, actual.predecessors) << "ship " << ship << ", quicksands " << quicksands << ", case " << i;
+			}
+		}
+	}
+}
+
+TEST(CBattleInfoCallbackTest, DISABLED_getReachabilityPerformance)
+{
+	BattleInfo battle;
+	const int iterations = 10000;
+
+	//AI evaluates reachability of every stack many times per decision, so single calculation should be cheap
+	auto start = boost::posix_time::microsec_clock::universal_time();
+	int total = 0;
+	for(int i = 0; i < iterations; i++)
+	{
+		battle.revision++; //measure calculation, not cache lookup
+		auto reachability = battle.getReachability(makeParameters(BattleHex(1 + i % 15, i % 11), i % 2, i % 2));
+		total += reachability.distances[BattleHex(8, 5)];
+	}
+	auto end = boost::posix_time::microsec_clock::universal_time();
+
+	std::cout << iterations << " reachability calculations done in " << (end - start).total_milliseconds() << " ms" << std::endl;
+
+	EXPECT_GT(total, 0);
+}
@@ -0,0 +1,124 @@
+/*
+ * PaletteBlitTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../../client/gui/PaletteBlit.h"
+#include "../../client/gui/SDL_Pixels.h"
+
+/// Draws row pixel by pixel with the putter used by software blitter before the kernels
+static void blitRowReference(ui32 * dst, const ui8 * src, const ui32 * palette, int width)
+{
+	Uint8 * ptr = reinterpret_cast<Uint8 *>(dst);
+	for(int x = 0; x < width; x++)
+	{
+		const ui32 color = palette[src[x]];
+		ColorPutter<4, +1>::PutColorAlphaSwitch(ptr, color >> 16, color >> 8, color, color >> 24);
+	}
+}
+
+TEST(PaletteBlitTest, allAlphaAndChannelValuesMatchReference)
+{
+	std::vector<ui8> src(256);
+	for(int i = 0; i < 256; i++)
+		src[i] = i;
+
+	for(auto & blitter : PaletteBlit::getAvailableRowBlitters())
+	{
+		std::vector<ui32> palette(256);
+		std::vector<ui32> expected(256), actual(256);
+
+		for(int alpha = 0; alpha < 256; alpha++)
+		{
+			for(int i = 0; i < 256; i++)
+				palette[i] = PaletteBlit::makePaletteEntry(i, 255 - i, i ^ 0x5A, alpha);
+
+			for(int d = 0; d < 256; d++)
+			{
+				for(int i = 0; i < 256; i++)
+					expected[i] = actual[i] = (ui32(i * 7 % 256) << 24) | (d << 16) | ((255 - d) << 8) | (d ^ 0xA5);
+
+				blitRowReference(expected.data(), src.data(), palette.data(), 256);
+				blitter.second(actual.data(), src.data(), palette.data(), 256);
+				ASSERT_EQ(expected, actual) << blitter.first << " kernel, alpha " << alpha << ", destination " << d;
+			}
+		}
+	}
+}
+
+TEST(PaletteBlitTest, randomRowsMatchReference)
+{
+	std::mt19937 rand(42);
+	std::vector<ui32> palette(256);
+	for(auto & entry : palette)
+	{
+		// real sprites use mostly transparent, opaque and shadow colors
+		static const ui8 alphas[] = {0, 0, 255, 255, 128, 64, 32};
+		entry = (rand() & 0xFFFFFF) | (ui32(alphas[rand() % 7]) << 24);
+		if(rand() % 4 == 0)
+			entry = (entry & 0xFFFFFF) | (ui32(rand() % 256) << 24);
+	}
+
+	for(auto & blitter : PaletteBlit::getAvailableRowBlitters())
+	{
+		for(int width = 0; width < 100; width++)
+		{
+			std::vector<ui8> src(width);
+			for(auto & index : src)
+				index = rand() % 256;
+
+			std::vector<ui32> expected(width);
+			for(auto & pixel : expected)
+				pixel = rand();
+			std::vector<ui32> actual = expected;
+
+			blitRowReference(expected.data(), src.data(), palette.data(), width);
+			blitter.second(actual.data(), src.data(), palette.data(), width);
+			ASSERT_EQ(expected, actual) << blitter.first << " kernel, width " << width;
+		}
+	}
+}
+
+TEST(PaletteBlitTest, DISABLED_throughput)
+{
+	const int WIDTH = 800;
+	const int HEIGHT = 600;
+	const int FRAMES = 20;
+
+	std::mt19937 rand(42);
+	std::vector<ui32> palette(256);
+	for(int i = 0; i < 256; i++)
+		palette[i] = PaletteBlit::makePaletteEntry(rand(), rand(), rand(), i < 8 ? (i == 0 ? 0 : 64) : 255);
+
+	// sprite-like picture: transparent background with opaque body and shadow
+	std::vector<ui8> src(WIDTH * HEIGHT);
+	for(int y = 0; y < HEIGHT; y++)
+	{
+		for(int x = 0; x < WIDTH; x++)
+		{
+			const int dist = std::abs(x - WIDTH / 2) + std::abs(y - HEIGHT / 2);
+			src[y * WIDTH + x] = dist < 200 ? 8 + rand() % 248 : (dist < 240 ? 1 + rand() % 7 : 0);
+		}
+	}
+	std::vector<ui32> dst(WIDTH * HEIGHT);
+
+	auto blitters = PaletteBlit::getAvailableRowBlitters();
+	blitters.insert(blitters.begin(), std::make_pair(std::string("ColorPutter"), &blitRowReference));
+	for(auto & blitter : blitters)
+	{
+		auto start = boost::posix_time::microsec_clock::universal_time();
+		for(int frame = 0; frame < FRAMES; frame++)
+			for(int y = 0; y < HEIGHT; y++)
+				blitter.second(dst.data() + y * WIDTH, src.data() + y * WIDTH, palette.data(), WIDTH);
+		auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+
+		const double megapixels = double(WIDTH) * HEIGHT * FRAMES / 1000000;
+		std::cout << blitter.first << " palette blit: " << megapixels / std::max<double>(duration.total_microseconds(), 1) * 1000000 << " Mpx/s" << std::endl;
+	}
+}
@@ -0,0 +1,196 @@
+/*
+ * ERMBytecodeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../../scripting/erm/ERMInterpreter.h"
+#include "../../scripting/erm/ERMBytecode.h"
+
+using namespace VERMInterpreter;
+
+namespace
+{
+	//everything a script can write to, flattened
+	struct ERMState
+	{
+		std::vector<int> ints;
+		std::vector<double> floats;
+		std::vector<std::string> strings;
+		int interpretedLines; //lines of FU triggers left to the interpreter by the compiler
+
+		ERMState() : interpretedLines(0)
+		{}
+	};
+
+	//functions whose variables are compared, scripts in this file use only these
+	const int CHECKED_FUNCTIONS = 10;
+
+	ERMState takeState(ERMInterpreter & erm)
+	{
+		ERMState ret;
+		for(char letter = 'f'; letter <= 't'; letter++)
+			ret.ints.push_back(erm.ermGlobalEnv->getQuickVar(letter));
+		for(int g = 1; g <= ERMEnvironment::NUM_STANDARDS; g++)
+			ret.ints.push_back(erm.ermGlobalEnv->getStandardVar(g));
+		for(int g = 1; g <= ERMEnvironment::NUM_FLAGS; g++)
+			ret.ints.push_back(erm.ermGlobalEnv->getFlag(g));
+		for(int g = 1; g <= ERMEnvironment::NUM_STRINGS; g++)
+			ret.strings.push_back(erm.ermGlobalEnv->getZVar(g));
+
+		for(int f = 0; f <= CHECKED_FUNCTIONS; f++)
+		{
+			FunctionLocalVars * vars = erm.getFuncVars(f);
+			for(int g = 1; g <= FunctionLocalVars::NUM_PARAMETERS; g++)
+				ret.ints.push_back(vars->getParam(g));
+			for(int g = 1; g <= FunctionLocalVars::NUM_LOCALS; g++)
+				ret.ints.push_back(vars->getLocal(g));
+			for(int g = 1; g <= FunctionLocalVars::NUM_STRINGS; g++)
+				ret.strings.push_back(vars->getString(-g));
+			for(int g = 1; g <= FunctionLocalVars::NUM_FLOATINGS; g++)
+				ret.floats.push_back(vars->getFloat(g));
+		}
+
+		for(Trigger & trig : erm.triggers[TriggerType("FU")])
+		{
+			for(int g = 1; g <= TriggerLocalVars::YVAR_NUM; g++)
+				ret.ints.push_back(trig.ermLocalVars.getYvar(-g));
+			for(int g = 1; g <= TriggerLocalVars::EVAR_NUM; g++)
+				ret.floats.push_back(trig.ermLocalVars.getEvar(-g));
+			ret.interpretedLines += trig.bytecode->lines.size();
+		}
+		return ret;
+	}
+
+	//loads lines as a single script file and calls FU1 once, the way DO receiver would
+	ERMState runScript(const std::vector<std::string> & lines, bool bytecode)
+	{
+		FileInfo file;
+		file.filename = "test.erm";
+		file.length = lines.size();
+
+		//function variables take tens of megabytes, too much for the stack
+		auto erm = make_unique<ERMInterpreter>();
+		erm->ermGlobalEnv = new ERMEnvironment();
+		for(int g = 0; g <= ERMInterpreter::TRIG_FUNC_NUM; g++)
+			erm->getFuncVars(g)->reset();
+
+		for(int g = 0; g < lines.size(); g++)
+			erm->scripts[LinePointer(&file, g, g + 1)] = ERMParser::parseLine(lines[g]);
+		erm->scanScripts();
+		erm->compileScripts();
+
+		erm->useBytecode = bytecode;
+		erm->callFunction(1, 0, 1, 1);
+		return takeState(*erm);
+	}
+
+	void checkScript(const std::vector<std::string> & lines)
+	{
+		const ERMState interpreted = runScript(lines, false);
+		const ERMState compiled = runScript(lines, true);
+
+		EXPECT_EQ(0, compiled.interpretedLines); //otherwise both runs would partly use the same code
+		EXPECT_EQ(interpreted.ints, compiled.ints);
+		EXPECT_EQ(interpreted.floats, compiled.floats);
+		EXPECT_EQ(interpreted.strings, compiled.strings);
+	}
+}
+
+TEST(ERMBytecode, vrArithmetic)
+{
+	checkScript(
+	{
+		"!?FU1;",
+		"!!VRv1:S7 +3 *x16 :2 %5;",
+		"!!VRv2:S100 -v1 *3 -7;",
+		"!!VRv3:S5 &3 |8 X1;",
+		"!!VRv4:Sv3 &v2 |v1;",
+		"!!VRf:S2;",
+		"!!VRt:Sf *f;",
+		"!!VRv5:S3;",
+		"!!VRv6:Svv5 +t;",
+		"!!VRy1:Sv6 -1;",
+		"!!VRy2:Sy1 :4;",
+		"!!VRz1:S^abc^;",
+		"!!VRz2:Sz1 +z1;",
+		"!!VRz3:Sz2 +z1 +z2;"
+	});
+}
+
+TEST(ERMBytecode, conditions)
+{
+	checkScript(
+	{
+		"!?FU1;",
+		"!!VRv1:S4;",
+		"!!VRv2&v1>3:S1;",
+		"!!VRv3&v1<3:S1;",
+		"!!VRv4&v1>=4/v1<=4:S1;",
+		"!!VRv5|v1==0/v1<>0:S1;",
+		"!!VRv6&v1==4/v2==0:S1;",
+		"!!VRv7Xv1==4/v2==1:S1;",
+		"!!VRv8&1:S1;",
+		"!!VRv9|1/v1>0:S1;",
+		"!!VRz1:S^abc^;",
+		"!!VRz2:S^abd^;",
+		"!!VRv10&z1<z2:S1;",
+		"!!VRv11&z1==z2:S1;",
+		"!!VRy1&v1==4:Sv1 *v1;",
+		"!!VRv12&y1>v1/y1<100:Sy1;"
+	});
+}
+
+TEST(ERMBytecode, doLoops)
+{
+	checkScript(
+	{
+		"!?FU1;",
+		"!!DO2/0/10/1;",
+		"!!VRv20:S3;",
+		"!!VRv21:S12;",
+		"!!DO3/v20/v21/3;",
+		"!!DO4/5/0/1;",
+		"!?FU2;",
+		"!!VRv1:Sv1 +x16;",
+		"!!VRv2:Sv2 +1;",
+		"!!VRv3&x16==3:Sv2;",
+		"!!VRx16&x16==7:S9;",
+		"!?FU3;",
+		"!!VRy1:Sy1 +x16;",
+		"!!VRv4:Sy1;",
+		"!!DO2/0/2/1;",
+		"!?FU4;",
+		"!!VRv5:S1;",
+		"!?FU2;",
+		"!!VRv6:Sv6 +1;"
+	});
+}
+
+TEST(ERMBytecode, negativeSlots)
+{
+	checkScript(
+	{
+		"!?FU1;",
+		"!!VRy-1:S5;",
+		"!!VRy-100:Sy-1 *2;",
+		"!!VRe-1:Se1;",
+		"!!VRe-2:Se-1 +e-1;",
+		"!!VRe1:Se-2 -e-1;",
+		"!!VRz-1:S^local^;",
+		"!!VRz-10:Sz-1 +z-1;",
+		"!!VRz1:Sz-10;",
+		"!!VRv1:Sy-100;",
+		"!!DO2/0/3/1;",
+		"!?FU2;",
+		"!!VRy-1:Sy-1 +x16;",
+		"!!VRy1:Sy-1;",
+		"!!VRz-1:Sz-1 +z1;",
+		"!!VRv2&y-1>2:Sv2 +1;"
+	});
+}
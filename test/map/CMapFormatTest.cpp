@@ -14,10 +14,13 @@
 #include "../lib/filesystem/CMemoryBuffer.h"
 #include "../lib/filesystem/Filesystem.h"
 
+#include "../lib/CCreatureHandler.h"
+#include "../lib/CHeroHandler.h"
 #include "../lib/mapping/CMap.h"
 #include "../lib/rmg/CMapGenOptions.h"
 #include "../lib/rmg/CMapGenerator.h"
 #include "../lib/mapping/MapFormatJson.h"
+#include "../lib/serializer/CMemorySerializer.h"
 
 #include "../lib/VCMIDirs.h"
 
@@ -215,3 +218,66 @@ TEST(MapFormat, Terrain)
 		c.compare("underground", actualUnderground, expectedUnderground);
 	}
 }
+
+TEST(MapFormat, BinarySaveLoad)
+{
+	CMapGenOptions opt;
+
+	opt.setHeight(CMapHeader::MAP_SIZE_SMALL);
+	opt.setWidth(CMapHeader::MAP_SIZE_SMALL);
+	opt.setHasTwoLevels(false);
+	opt.setPlayerCount(2);
+
+	CMapGenerator gen;
+
+	std::unique_ptr<CMap> initialMap = gen.generate(&opt, TEST_RANDOM_SEED);
+	initialMap->name = "Test";
+
+	//serialize whole map the same way as it is done in savegames
+	CMemorySerializer mem;
+	CMap * savedMap = initialMap.get();
+	mem.oser & savedMap;
+
+	std::unique_ptr<CMap> serialized;
+	mem.iser & serialized;
+
+	EXPECT_EQ(mem.oser.savedPointers.size(), mem.iser.loadedPointers.size());
+
+	MapComparer c;
+	c(serialized, initialMap);
+}
+
+TEST(MapFormat, DISABLED_BinarySaveLoadLargeMap)
+{
+	CMapGenOptions opt;
+
+	opt.setHeight(CMapHeader::MAP_SIZE_XLARGE);
+	opt.setWidth(CMapHeader::MAP_SIZE_XLARGE);
+	opt.setHasTwoLevels(true);
+	opt.setPlayerCount(8);
+
+	CMapGenerator gen;
+
+	std::unique_ptr<CMap> initialMap = gen.generate(&opt, TEST_RANDOM_SEED);
+	initialMap->name = "Test";
+
+	//map is big enough to expose pointer bookkeeping costs of serializer
+	CMemorySerializer mem;
+	CMap * savedMap = initialMap.get();
+
+	auto start = boost::posix_time::microsec_clock::universal_time();
+	mem.oser & savedMap;
+	auto saved = boost::posix_time::microsec_clock::universal_time();
+
+	std::unique_ptr<CMap> serialized;
+	mem.iser & serialized;
+	auto loaded = boost::posix_time::microsec_clock::universal_time();
+
+	std::cout << "Map with " << mem.oser.savedPointers.size() << " pointers saved in "
+		<< (saved - start).total_milliseconds() << " ms, loaded in " << (loaded - saved).total_milliseconds() << " ms" << std::endl;
+
+	EXPECT_EQ(mem.oser.savedPointers.size(), mem.iser.loadedPointers.size());
+
+	MapComparer c;
+	c(serialized, initialMap);
+}
@@ -0,0 +1,123 @@
+/*
+ * CPackLogTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../../server/CPackLog.h"
+#include "../../lib/CGameState.h"
+#include "../../lib/CPlayerState.h"
+#include "../../lib/NetPacks.h"
+#include "../../lib/StartInfo.h"
+#include "../../lib/mapping/CMap.h"
+#include "../../lib/mapObjects/CGHeroInstance.h"
+#include "../../lib/rmg/CMapGenOptions.h"
+#include "../../lib/VCMIDirs.h"
+
+static const int TEST_RANDOM_SEED = 1337;
+
+/// Owns game state like game handler does, without any of its logic
+class PackLogTestState : public CNonConstInfoCallback
+{
+public:
+	PackLogTestState(CGameState * state = nullptr)
+	{
+		gs = state;
+	}
+
+	~PackLogTestState()
+	{
+		delete gs;
+	}
+};
+
+static CGameState * createGameState()
+{
+	CMapGenOptions opt;
+	opt.setHeight(CMapHeader::MAP_SIZE_SMALL);
+	opt.setWidth(CMapHeader::MAP_SIZE_SMALL);
+	opt.setHasTwoLevels(false);
+	opt.setPlayerCount(2);
+	opt.setPlayerTypeForStandardPlayer(PlayerColor(0), EPlayerType::HUMAN);
+	opt.setPlayerTypeForStandardPlayer(PlayerColor(1), EPlayerType::AI);
+
+	StartInfo si;
+	si.mode = StartInfo::NEW_GAME;
+	si.seedToBeUsed = TEST_RANDOM_SEED;
+	si.mapGenOptions = std::make_shared<CMapGenOptions>(opt);
+
+	auto gs = new CGameState();
+	gs->init(&si);
+	return gs;
+}
+
+TEST(CPackLog, replayReachesRecordedState)
+{
+	const auto path = VCMIDirs::get().userDataPath() / "test_packs.vlog";
+	boost::filesystem::remove(path);
+
+	PackLogTestState original(createGameState());
+	CGameState * gs = original.gameState();
+	ASSERT_FALSE(gs->map->heroesOnMap.empty());
+	const ObjectInstanceID heroID = gs->map->heroesOnMap.front()->id;
+
+	{
+		CPackLogWriter writer(path, original);
+
+		//packs are recorded right before they are applied, as game handler does
+		auto record = [&](CPackForClient & pack)
+		{
+			writer.packApplied(&pack);
+			gs->apply(&pack);
+		};
+
+		SetResources gold;
+		gold.player = PlayerColor(0);
+		gold.res[Res::GOLD] = 12345;
+		record(gold);
+
+		SetMana mana;
+		mana.hid = heroID;
+		mana.val = 7;
+		record(mana);
+
+		EndTurn endTurn;
+		writer.packReceived(&endTurn, PlayerColor(0), 1);
+		writer.newTurn();
+
+		SetMovePoints movePoints;
+		movePoints.hid = heroID;
+		movePoints.val = 123;
+		record(movePoints);
+
+		SetResources wood;
+		wood.abs = false;
+		wood.player = PlayerColor(1);
+		wood.res[Res::WOOD] = 5;
+		record(wood);
+	}
+
+	PackLogTestState replayed;
+	CPackLogReplay replay(path);
+	ASSERT_TRUE(replay.run(replayed));
+	ASSERT_NE(nullptr, replayed.gameState());
+
+	for(PlayerColor color : {PlayerColor(0), PlayerColor(1)})
+		EXPECT_EQ(original.getPlayer(color)->resources, replayed.getPlayer(color)->resources) << "player " << color.getNum();
+
+	const CGHeroInstance * hero = original.getHero(heroID);
+	const CGHeroInstance * replayedHero = replayed.getHero(heroID);
+	ASSERT_NE(nullptr, replayedHero);
+	EXPECT_EQ(hero->mana, replayedHero->mana);
+	EXPECT_EQ(hero->movement, replayedHero->movement);
+	EXPECT_EQ(7, replayedHero->mana);
+	EXPECT_EQ(123u, replayedHero->movement);
+	EXPECT_EQ(gs->day, replayed.gameState()->day);
+
+	boost::filesystem::remove(path);
+}
@@ -0,0 +1,190 @@
+/*
+ * SpellRangeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../../lib/spells/CSpellHandler.h"
+#include "../../lib/spells/CDefaultSpellMechanics.h"
+#include "../../lib/battle/BattleHex.h"
+
+namespace
+{
+	//range parsing of rangeInHexes before ranges were parsed on load, kept as a reference
+	namespace Reference
+	{
+		std::pair<int, int> hexToPair(int hex)
+		{
+			return std::make_pair(hex % GameConstants::BFIELD_WIDTH, hex / GameConstants::BFIELD_WIDTH);
+		}
+
+		//0 - left top, 1 - right top, 2 - right, 3 - right bottom, 4 - left bottom, 5 - left
+		std::pair<int, int> gotoDir(std::pair<int, int> xy, int direction)
+		{
+			const int x = xy.first, y = xy.second;
+			switch(direction)
+			{
+			case 0:
+				return std::make_pair((y%2) ? x-1 : x, y-1);
+			case 1:
+				return std::make_pair((y%2) ? x : x+1, y-1);
+			case 2:
+				return std::make_pair(x+1, y);
+			case 3:
+				return std::make_pair((y%2) ? x : x+1, y+1);
+			case 4:
+				return std::make_pair((y%2) ? x-1 : x, y+1);
+			default:
+				return std::make_pair(x-1, y);
+			}
+		}
+
+		bool isGoodHex(std::pair<int, int> xy)
+		{
+			return xy.first >= 0 && xy.first < GameConstants::BFIELD_WIDTH && xy.second >= 0 && xy.second < GameConstants::BFIELD_HEIGHT;
+		}
+
+		std::set<ui16> getInRange(unsigned int center, int low, int high)
+		{
+			std::set<ui16> ret;
+			if(low == 0)
+				ret.insert(center);
+
+			std::pair<int, int> mainPointForLayer[6];
+			for(auto & elem : mainPointForLayer)
+				elem = hexToPair(center);
+
+			for(int it = 1; it <= high; ++it)
+			{
+				for(int b = 0; b < 6; ++b)
+					mainPointForLayer[b] = gotoDir(mainPointForLayer[b], b);
+
+				if(it >= low)
+				{
+					for(int v = 0; v < 6; ++v)
+					{
+						std::pair<int, int> curHex = mainPointForLayer[v];
+						for(int h = 0; h < it; ++h)
+						{
+							if(isGoodHex(curHex))
+								ret.insert(curHex.first + GameConstants::BFIELD_WIDTH * curHex.second);
+							curHex = gotoDir(curHex, (v+2)%6);
+						}
+					}
+				}
+			}
+			return ret;
+		}
+
+		//returns hexes in range, layers are filled with intervals passed to getInRange
+		std::vector<BattleHex> rangeInHexes(const std::string & range, BattleHex centralHex, std::vector<std::pair<int, int>> & layers)
+		{
+			std::vector<BattleHex> ret;
+			std::string rng = range + ',';
+
+			if(rng.size() >= 2 && rng[0] != 'X')
+			{
+				std::string number1, number2;
+				int beg = 0, end = 0;
+				bool readingFirst = true;
+				for(auto & elem : rng)
+				{
+					if(std::isdigit(elem))
+					{
+						if(readingFirst)
+							number1 += elem;
+						else
+							number2 += elem;
+					}
+					else if(elem == ',')
+					{
+						if(readingFirst)
+						{
+							beg = atoi(number1.c_str());
+							number1 = "";
+							end = beg;
+						}
+						else
+						{
+							end = atoi(number2.c_str());
+							number2 = "";
+							readingFirst = true;
+						}
+						layers.push_back(std::make_pair(beg, end));
+						for(auto & hex : getInRange(centralHex, beg, end))
+							ret.push_back(hex);
+					}
+					else if(elem == '-')
+					{
+						beg = atoi(number1.c_str());
+						number1 = "";
+						readingFirst = false;
+					}
+				}
+			}
+
+			range::unique(ret);
+			return ret;
+		}
+	}
+
+	const std::vector<std::string> RANGES = {"0", "0-1", "X", "0,2-3", "1", "0-2", "0,1,2"};
+
+	//hexes next to every edge of battlefield, including both corners of each row
+	std::vector<BattleHex> edgeHexes()
+	{
+		std::vector<BattleHex> ret;
+		for(int y = 0; y < GameConstants::BFIELD_HEIGHT; y++)
+		{
+			for(int x = 0; x < GameConstants::BFIELD_WIDTH; x++)
+			{
+				if(x <= 1 || x >= GameConstants::BFIELD_WIDTH - 2 || y == 0 || y == GameConstants::BFIELD_HEIGHT - 1)
+					ret.push_back(BattleHex(x, y));
+			}
+		}
+		return ret;
+	}
+}
+
+TEST(SpellRange, parsedLayersMatchStringParsing)
+{
+	CSpell spell;
+	for(const std::string & range : RANGES)
+	{
+		CSpell::LevelInfo & levelInfo = const_cast<CSpell::LevelInfo &>(spell.getLevelInfo(0));
+		levelInfo.range = range;
+		levelInfo.parseRange();
+
+		std::vector<std::pair<int, int>> expected;
+		Reference::rangeInHexes(range, BattleHex(0), expected);
+		EXPECT_EQ(expected, levelInfo.rangeLayers) << "range " << range;
+	}
+}
+
+TEST(SpellRange, rangeInHexesMatchesStringParsingAtEdges)
+{
+	CSpell spell;
+	DefaultSpellMechanics mechanics(&spell);
+	for(const std::string & range : RANGES)
+	{
+		for(int level = 0; level < GameConstants::SPELL_SCHOOL_LEVELS; level++)
+		{
+			CSpell::LevelInfo & levelInfo = const_cast<CSpell::LevelInfo &>(spell.getLevelInfo(level));
+			levelInfo.range = range;
+			levelInfo.parseRange();
+		}
+
+		for(BattleHex center : edgeHexes())
+		{
+			std::vector<std::pair<int, int>> layers;
+			const std::vector<BattleHex> expected = Reference::rangeInHexes(range, center, layers);
+			EXPECT_EQ(expected, mechanics.rangeInHexes(center, 0, 0)) << "range " << range << ", center " << center;
+			EXPECT_EQ(expected, mechanics.rangeInHexes(center, 3, 1)) << "range " << range << ", center " << center;
+		}
+	}
+}
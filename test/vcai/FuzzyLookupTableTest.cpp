@@ -0,0 +1,61 @@
+/*
+ * FuzzyLookupTableTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../../AI/VCAI/FuzzyEngines.h"
+#include "../../lib/CRandomGenerator.h"
+
+//output range is 0..5; table interpolates between samples, so it may differ from engine inside a cell but not by much on average
+static const fl::scalar MAX_ERROR = 0.75;
+static const fl::scalar MAX_AVERAGE_ERROR = 0.1;
+
+TEST(FuzzyLookupTable, matchesVisitTileEngine)
+{
+	VisitTileEngine vt;
+	vt.init(SAFE_ATTACK_CONSTANT);
+	vt.configure();
+	ASSERT_TRUE(vt.buildTables());
+
+	CRandomGenerator rand;
+	rand.setSeed(42);
+
+	const int count = 1000;
+	for(bool reward : {false, true})
+	{
+		vt.estimatedReward->setEnabled(reward);
+		fl::scalar errorSum = 0;
+		for(int i = 0; i < count; i++)
+		{
+			//strength ratio goes far above its range, VCAI uses 10 for unguarded tiles
+			const fl::scalar strengthRatio = rand.nextDouble(0, 10);
+			const fl::scalar heroStrength = rand.nextDouble(0, 1);
+			const fl::scalar turns = rand.nextDouble(0, 3);
+			const fl::scalar missionImportance = rand.nextDouble(0, 5);
+			const fl::scalar tilePriority = reward ? 5 : 0;
+
+			vt.strengthRatio->setValue(strengthRatio);
+			vt.heroStrength->setValue(heroStrength);
+			vt.turnDistance->setValue(turns);
+			vt.missionImportance->setValue(missionImportance);
+			vt.estimatedReward->setValue(tilePriority);
+			vt.engine.process();
+			const fl::scalar expected = vt.value->getValue();
+
+			const fl::scalar actual = reward
+				? vt.rewardTable.evaluate({strengthRatio, heroStrength, turns, missionImportance, tilePriority})
+				: vt.table.evaluate({strengthRatio, heroStrength, turns, missionImportance});
+
+			EXPECT_NEAR(actual, expected, MAX_ERROR) << "strengthRatio " << strengthRatio << ", heroStrength " << heroStrength
+				<< ", turns " << turns << ", missionImportance " << missionImportance << ", reward " << tilePriority;
+			errorSum += std::abs(actual - expected);
+		}
+		EXPECT_LT(errorSum / count, MAX_AVERAGE_ERROR) << "reward " << reward;
+	}
+}